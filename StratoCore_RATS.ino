@@ -1,6 +1,6 @@
 #include "StratoCore.h"
 #include "src/StratoRATS.h"
-#include <TimerOne.h>
+#include <IntervalTimer.h>
 #include <SPI.h>
 #include "rats_version.h"
 
@@ -9,6 +9,7 @@
 StratoRATS strato;
 
 // timer control variables
+IntervalTimer control_timer;
 volatile uint8_t timer_counter = 0;
 uint8_t heartbeat_led = 0;
 volatile bool loop_flag = false;
@@ -42,7 +43,11 @@ void ControlLoopTimer(void) {
 
 // Loop timing function
 void WaitForControlTimer(void) {
-  while (!loop_flag) delay(1);
+  // Spend the wait doing deferred work (e.g. SD writes), and only
+  // sleep when there is none.
+  while (!loop_flag) {
+    if (!strato.IdleTask()) delay(1);
+  }
 
   loop_flag = false;
 }
@@ -85,9 +90,10 @@ void setup()
     MCB_SERIAL.addMemoryForRead(&mcb_serial_RX_buffer, sizeof(mcb_serial_RX_buffer));
     MCB_SERIAL.addMemoryForWrite(&mcb_serial_TX_buffer, sizeof(mcb_serial_TX_buffer));
 
-  // Timer interrupt setup for main loop timing
-  Timer1.initialize(100000); // 0.1 s
-  Timer1.attachInterrupt(ControlLoopTimer);
+  // Timer interrupt setup for main loop timing. The PIT behind IntervalTimer
+  // runs from the 24 MHz oscillator, so the period holds when the clock
+  // governor changes the core and bus clocks.
+  control_timer.begin(ControlLoopTimer, 100000); // 0.1 s
 
   // Wait two cycles to align timing
   WaitForControlTimer();
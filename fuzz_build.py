@@ -0,0 +1,9 @@
+# libFuzzer build for the fuzz_* environments: clang, with the fuzzer,
+# address and undefined behaviour sanitizers on both compile and link.
+
+Import("env")
+
+SANITIZE = ["-fsanitize=fuzzer,address,undefined", "-fno-sanitize-recover=undefined", "-g", "-O1"]
+
+env.Replace(CC="clang", CXX="clang++", LINK="clang++")
+env.Append(CCFLAGS=SANITIZE, LINKFLAGS=SANITIZE)
@@ -0,0 +1,152 @@
+import os
+import subprocess
+from SCons.Script import DefaultEnvironment
+
+# Teensy 4.1 RAM breakdown from the ELF, with budgets.
+#
+# RAM1 (512 KB of tightly coupled memory) holds the ITCM code, rounded up to
+# 32 KB banks, followed by DTCM: .data, .bss and then the stack, which grows
+# down from the top of RAM1 into whatever is left. RAM2 (OCRAM, 512 KB) holds
+# DMAMEM (.bss.dma) and the heap.
+#
+# After each build the totals are printed and checked against the budgets
+# below (overridable per environment with the custom_* options), and the
+# build fails if one is exceeded. "pio run -t ramreport" also lists the
+# largest symbols in each region and the DTCM buffers that could move to
+# DMAMEM.
+
+env = DefaultEnvironment()
+
+RAM1_SIZE = 512 * 1024
+RAM2_SIZE = 512 * 1024
+ITCM_BANK = 32 * 1024
+
+REGIONS = [
+    # name, start, end
+    ("ITCM", 0x00000000, 0x00080000),
+    ("DTCM", 0x20000000, 0x20080000),
+    ("RAM2", 0x20200000, 0x20280000),
+    ("EXTMEM", 0x70000000, 0x71000000),
+]
+
+# Zero-initialized DTCM objects at least this large are listed as DMAMEM candidates
+DMAMEM_CANDIDATE_BYTES = 1024
+
+
+def option(name, default):
+    return int(env.GetProjectOption(name, default))
+
+
+def tool(name):
+    # e.g. .../arm-none-eabi-objcopy -> .../arm-none-eabi-nm
+    objcopy = env.subst("$OBJCOPY")
+    if objcopy.endswith("objcopy"):
+        return objcopy[:-len("objcopy")] + name
+    return "arm-none-eabi-" + name
+
+
+def section_sizes(elf):
+    sizes = {}
+    out = subprocess.check_output([tool("size"), "-A", elf]).decode("utf-8")
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def symbols(elf):
+    # (region, size, type, name) for every sized data symbol in RAM
+    syms = []
+    out = subprocess.check_output([tool("nm"), "-S", "-C", "--size-sort", elf]).decode("utf-8", "replace")
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) < 4 or fields[2].lower() not in ("b", "d"):
+            continue
+        addr, size = int(fields[0], 16), int(fields[1], 16)
+        for region, start, end in REGIONS:
+            if start <= addr < end:
+                syms.append((region, size, fields[2], fields[3]))
+                break
+    return syms
+
+
+def usage(elf):
+    s = section_sizes(elf)
+    itcm = s.get(".text.itcm", 0) + s.get(".ARM.exidx", 0)
+    itcm_padded = (itcm + ITCM_BANK - 1) // ITCM_BANK * ITCM_BANK
+    dtcm = s.get(".data", 0) + s.get(".bss", 0)
+    ram2 = s.get(".bss.dma", 0)
+    return {
+        "itcm": itcm,
+        "itcm_padded": itcm_padded,
+        "dtcm": dtcm,
+        "stack": RAM1_SIZE - itcm_padded - dtcm,
+        "ram2": ram2,
+        "heap": RAM2_SIZE - ram2,
+    }
+
+
+def check_budget(source, target, env):
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    if not os.path.exists(elf):
+        print(f"RAM report: {elf} not found")
+        return 0
+
+    u = usage(elf)
+    min_stack = option("custom_ram1_min_stack", 64 * 1024)
+    max_ram2 = option("custom_ram2_budget", 448 * 1024)
+
+    print(f"RAM1: ITCM {u['itcm']} (padded {u['itcm_padded']}) + DTCM {u['dtcm']}, {u['stack']} left for the stack")
+    print(f"RAM2: DMAMEM {u['ram2']}, {u['heap']} left for the heap")
+
+    failed = False
+    if u["stack"] < min_stack:
+        print(f"RAM budget exceeded: RAM1 stack space {u['stack']} < custom_ram1_min_stack {min_stack}")
+        failed = True
+    if u["ram2"] > max_ram2:
+        print(f"RAM budget exceeded: DMAMEM {u['ram2']} > custom_ram2_budget {max_ram2}")
+        failed = True
+
+    # A non-zero return fails the build
+    return 1 if failed else 0
+
+
+def ram_report(source, target, env):
+    elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    if not os.path.exists(elf):
+        print(f"RAM report: {elf} not found, build first")
+        return 1
+
+    top_n = option("custom_ram_report_symbols", 20)
+    syms = symbols(elf)
+    for region, _, _ in REGIONS:
+        in_region = sorted([s for s in syms if s[0] == region], key=lambda s: -s[1])
+        if not in_region:
+            continue
+        total = sum(s[1] for s in in_region)
+        print(f"\n{region}: {total} bytes in {len(in_region)} symbols, largest:")
+        for _, size, kind, name in in_region[:top_n]:
+            print(f"  {size:8d} {kind} {name}")
+
+    # Only zero-initialized (.bss) objects can move: DMAMEM is not
+    # initialized at startup. Objects that are DMA buffers also need cache
+    # maintenance once in OCRAM.
+    candidates = sorted([s for s in syms if s[0] == "DTCM" and s[2].lower() == "b"
+                         and s[1] >= DMAMEM_CANDIDATE_BYTES], key=lambda s: -s[1])
+    if candidates:
+        print(f"\nDMAMEM candidates (zero-initialized DTCM objects >= {DMAMEM_CANDIDATE_BYTES} bytes):")
+        for _, size, _, name in candidates:
+            print(f"  {size:8d} {name}")
+
+    return check_budget(source, target, env)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_budget)
+env.AddCustomTarget(
+    name="ramreport",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=ram_report,
+    title="RAM report",
+    description="Break down RAM use by region and symbol, and check the budgets",
+)
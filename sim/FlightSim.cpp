@@ -0,0 +1,576 @@
+/*
+ *  FlightSim.cpp
+ *
+ *  Closed-loop flight simulation of StratoRATS; see FlightSim.h.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "FlightSim.h"
+#include "Recording.h"
+#include "Serialize.h"
+
+FlightSim* FlightSim::running = nullptr;
+
+// A day with two deployments, a full retract and a low power night,
+// ending in safety and end of flight
+const char* FlightSim::DEFAULT_SCENARIO =
+    "0:01:00   MODE FL\n"
+    "1:00:00   TC DEPLOYx 100\n"
+    "3:00:00   TC RETRACTx 100\n"
+    "6:00:00   TC DEPLOYx 200\n"
+    "9:00:00   TC FULLRETRACT\n"
+    "12:00:00  MODE LP\n"
+    "14:00:00  MODE FL\n"
+    "16:00:00  TC DEPLOYx 50\n"
+    "23:00:00  MODE SA\n"
+    "23:30:00  MODE EF\n";
+
+static bool ParseTime(const char* s, uint32_t& ms)
+{
+    unsigned h = 0, m = 0;
+    float sec = 0;
+    if (sscanf(s, "%u:%u:%f", &h, &m, &sec) == 3 && m < 60 && sec < 60) {
+        ms = (uint32_t) ((h * 3600 + m * 60) * 1000 + sec * 1000);
+        return true;
+    }
+    char* end;
+    sec = strtof(s, &end);
+    if (end != s && *end == '\0' && sec >= 0) {
+        ms = (uint32_t) (sec * 1000);
+        return true;
+    }
+    return false;
+}
+
+static std::string Format(const char* format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return buf;
+}
+
+// ---------------------------------------------------------------------------
+// Results
+
+uint32_t SimResult_t::Entries(const char* substate) const
+{
+    uint32_t n = 0;
+    size_t len = strlen(substate);
+    for (const auto& s : states) {
+        const std::string& name = s.first;
+        if (name.size() >= len + 1 && name.compare(name.size() - len, len, substate) == 0
+            && name[name.size() - len - 1] == ':') {
+            n += s.second.entries;
+        }
+    }
+    return n;
+}
+
+void SimResult_t::Print(FILE* f, bool print_timeline) const
+{
+    if (print_timeline) {
+        fprintf(f, "Timeline:\n");
+        for (const SimEvent_t& e : timeline) {
+            fprintf(f, "  %2u:%02u:%02u.%01u  %s\n", e.ms / 3600000, e.ms / 60000 % 60, e.ms / 1000 % 60,
+                    e.ms / 100 % 10, e.text.c_str());
+        }
+    }
+
+    fprintf(f, "States:                               entries        time\n");
+    for (const auto& s : states) {
+        fprintf(f, "  %-36s %7u %10.1fs\n", s.first.c_str(), s.second.entries, s.second.ms / 1000.0);
+    }
+
+    uint32_t count = 0, bytes = 0;
+    fprintf(f, "TMs:                                    count       bytes\n");
+    for (const auto& t : tms) {
+        fprintf(f, "  %-36s %7u %11u\n", t.first.c_str(), t.second.count, t.second.bytes);
+        count += t.second.count;
+        bytes += t.second.bytes;
+    }
+    fprintf(f, "  %-36s %7u %11u\n", "total", count, bytes);
+
+    fprintf(f, "S %u, IMR %u, TC ack/nak %u/%u, log errors %u\n", s_messages, imrs, tc_acks, tc_naks, log_errors);
+    fprintf(f, "ECU reports %u (%u lost), LoRa commands %u, MCB commands %u, motions %u, clock changes %u\n",
+            ecu_reports_sent, ecu_reports_lost, lora_commands, mcb_commands, motions, clock_changes);
+    fprintf(f, "Final state %s, reel %.1f revs\n", final_state.c_str(), final_reel_revs);
+    fprintf(f, "%u loops, %.1f h simulated in %.2f s (%.0fx real time)\n", loops, sim_ms / 3600000.0, wall_s,
+            (wall_s > 0) ? sim_ms / 1000.0 / wall_s : 0.0);
+}
+
+void SimResult_t::PrintCSVHeader(FILE* f)
+{
+    fprintf(f, "seed,final_state,warmups,measure,reels,tm_count,tm_bytes,ratsreports,mcbreports,"
+               "log_errors,ecu_reports,ecu_lost,motions,wall_s\n");
+}
+
+void SimResult_t::PrintCSV(FILE* f, uint32_t seed) const
+{
+    uint32_t count = 0, bytes = 0;
+    for (const auto& t : tms) {
+        count += t.second.count;
+        bytes += t.second.bytes;
+    }
+    auto n = [this](const char* type) {
+        auto it = tms.find(type);
+        return (it == tms.end()) ? 0u : it->second.count;
+    };
+    fprintf(f, "%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f\n", seed, final_state.c_str(), Entries("FL_WARMUP"),
+            Entries("FL_MEASURE"), Entries("FL_REEL"), count, bytes, n("RATSREPORT"), n("MCBREPORT"), log_errors,
+            ecu_reports_sent, ecu_reports_lost, motions, wall_s);
+}
+
+// ---------------------------------------------------------------------------
+// Simulation
+
+void RunFirmwareLoop(StratoRATS& rats)
+{
+    // As loop() in StratoCore_RATS.ino
+    rats.KickWatchdog();
+    rats.RunScheduler();
+    rats.RunRouter();
+    rats.RunMCBRouter();
+    rats.RunMode();
+    rats.InstrumentLoop();
+    for (int i = 0; i < 1000 && rats.IdleTask(); i++) {
+    }
+}
+
+FlightSim::FlightSim(const SimConfig_t& config) : cfg(config), mcb(*this), rng(config.seed ? config.seed : 1)
+{
+    LoadScenario(DEFAULT_SCENARIO, nullptr, 0);
+}
+
+FlightSim::~FlightSim()
+{
+    recorder.Stop();
+    host::mcb_device = nullptr;
+    running = nullptr;
+    delete rats;
+}
+
+bool FlightSim::LoadScenario(const char* text, char* err, size_t err_size)
+{
+    std::vector<SimEvent_t> events;
+    unsigned line_num = 0;
+
+    while (*text) {
+        const char* eol = strchr(text, '\n');
+        std::string line(text, eol ? eol - text : strlen(text));
+        text = eol ? eol + 1 : text + line.size();
+        line_num++;
+
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        char time[32];
+        int n = 0;
+        if (sscanf(line.c_str(), " %31s %n", time, &n) != 1) {
+            continue;
+        }
+        SimEvent_t e;
+        std::string rest = line.substr(n);
+        while (!rest.empty() && isspace((unsigned char) rest.back())) {
+            rest.pop_back();
+        }
+        if (!ParseTime(time, e.ms) || rest.empty()) {
+            if (err) {
+                snprintf(err, err_size, "line %u: expected \"<time> <event>\"", line_num);
+            }
+            return false;
+        }
+        e.text = rest;
+        events.push_back(e);
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const SimEvent_t& a, const SimEvent_t& b) { return a.ms < b.ms; });
+    scenario = events;
+    next_event = 0;
+    return true;
+}
+
+float FlightSim::Random()
+{
+    // xorshift32: the same sequence for the same seed on every host
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) / 16777216.0f;
+}
+
+void FlightSim::Note(const std::string& text)
+{
+    result.timeline.push_back({millis(), text});
+}
+
+void FlightSim::ClockChanged(uint32_t hz)
+{
+    if (running) {
+        running->result.clock_changes++;
+    }
+}
+
+float FlightSim::BalloonAltitude(uint32_t now_ms) const
+{
+    float alt = cfg.ascent_mps * now_ms / 1000.0f;
+    if (alt < cfg.float_alt_m) {
+        return alt;
+    }
+    // Diurnal oscillation at float
+    return cfg.float_alt_m + 300.0f * sinf(2.0f * (float) M_PI * now_ms / 86400000.0f);
+}
+
+const SimResult_t& FlightSim::Run()
+{
+    auto wall_start = std::chrono::steady_clock::now();
+
+    host::Reset();
+    host::EraseEEPROM();
+    host::sd_files.clear();
+    if (cfg.profile) {
+        host::WriteSDFile(REEL_PROFILE_FILE, cfg.profile);
+    }
+    host::SetEpoch(cfg.epoch);
+    host::log_echo = cfg.echo_log;
+    host::mcb_device = &mcb;
+    running = this;
+    ratsParam.decimate_factor = 1;
+    if (cfg.record) {
+        recorder.Start(cfg.record, cfg.epoch, cfg.loop_ms);
+    }
+
+    rats = new StratoRATS();
+    rats->SetClockChangeHandler(ClockChanged);
+    rats->InitializeCore();
+    rats->InstrumentSetup();
+    Note("Power on");
+
+    uint32_t end_ms = cfg.duration_s * 1000;
+    while (!ended && millis() < end_ms) {
+        Loop();
+        host::Advance(cfg.loop_ms);
+    }
+
+    Observe(millis());
+    recorder.Stop();
+    result.states[state].ms += millis() - state_ms;
+    result.final_state = state;
+    result.final_reel_revs = mcb.pos;
+    result.sim_ms = millis();
+    result.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
+void FlightSim::Loop()
+{
+    uint32_t now_ms = millis();
+
+    RunEvents(now_ms);
+    RunOBC(now_ms);
+    mcb.Service(now_ms);
+    RunECU(now_ms);
+    RunFirmwareLoop(*rats);
+    Observe(now_ms);
+    result.loops++;
+}
+
+void FlightSim::RunEvents(uint32_t now_ms)
+{
+    while (next_event < scenario.size() && scenario[next_event].ms <= now_ms) {
+        RunEvent(scenario[next_event++].text);
+    }
+}
+
+void FlightSim::RunEvent(const std::string& text)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", text.c_str());
+    char* event = strtok(buf, " \t");
+    char* arg = strtok(nullptr, " \t");
+    Note("Scenario: " + text);
+
+    if (!strcasecmp(event, "MODE") && arg) {
+        if (SimParseMode(arg, &obc_mode)) {
+            host::QueueModeChange(obc_mode);
+            return;
+        }
+    } else if (!strcasecmp(event, "SW")) {
+        host::QueueShutdownWarning();
+        return;
+    } else if (!strcasecmp(event, "TC") && arg) {
+        char* p1 = strtok(nullptr, " \t");
+        char* p2 = strtok(nullptr, " \t");
+        Telecommand_t tc;
+        if (SimParseTC(arg, p1, p2, &tc)) {
+            host::QueueTC(tc);
+            return;
+        }
+    } else if (!strcasecmp(event, "CONSOLE")) {
+        size_t n = text.find_first_not_of(" \t", strlen("CONSOLE"));
+        Serial.Inject((n == std::string::npos) ? "" : text.c_str() + n);
+        Serial.Inject("\n");
+        return;
+    } else if (!strcasecmp(event, "ECU") && arg) {
+        ecu_radio = !strcasecmp(arg, "ON");
+        return;
+    } else if (!strcasecmp(event, "LORALOSS") && arg) {
+        cfg.lora_loss = strtof(arg, nullptr);
+        return;
+    } else if (!strcasecmp(event, "MCBFAULT")) {
+        mcb.fault_next = true;
+        return;
+    } else if (!strcasecmp(event, "END")) {
+        ended = true;
+        return;
+    }
+    Note("Scenario: unknown event " + text);
+}
+
+void FlightSim::RunOBC(uint32_t now_ms)
+{
+    if (now_ms >= next_gps_ms) {
+        host::QueueGPS(40.5f, -105.1f, BalloonAltitude(now_ms), cfg.epoch + now_ms / 1000);
+        next_gps_ms = now_ms + cfg.gps_period_s * 1000;
+    }
+
+    for (size_t i = 0; i < obc_pending.size();) {
+        if (obc_pending[i].first <= now_ms) {
+            host::zephyr_rx.push_back(obc_pending[i].second);
+            obc_pending.erase(obc_pending.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void FlightSim::RunECU(uint32_t now_ms)
+{
+    // The ECU boots when its power is switched on
+    bool powered = digitalRead(ECU_PWR_EN) == HIGH;
+    if (powered && !ecu_powered) {
+        ecu_next_ms = now_ms + cfg.ecu_boot_ms;
+    }
+    ecu_powered = powered;
+
+    // Commands queued by LoRaTx()
+    result.lora_commands += host::lora_tx.size();
+    host::lora_tx.clear();
+
+    if (!ecu_powered || now_ms < ecu_next_ms) {
+        return;
+    }
+    // +-10% jitter on the report period
+    ecu_next_ms = now_ms + (uint32_t) (cfg.ecu_period_ms * (0.9f + 0.2f * Random()));
+    result.ecu_reports_sent++;
+    if (!ecu_radio || Random() < cfg.lora_loss) {
+        result.ecu_reports_lost++;
+        return;
+    }
+
+    float alt = BalloonAltitude(now_ms) + mcb.pos * cfg.m_per_rev;   // pos < 0 when deployed
+    float t = (alt < 11000) ? 15.0f - 0.0065f * alt : -56.5f;
+    ECUReport_t r = {};
+    r.msg_type = ECU_REPORT_DATA;
+    r.id = cfg.ecu_id;
+    r.gps_valid = r.rs41_valid = r.tsen_valid = true;
+    r.gps_alt = alt;
+    r.rs41_airt = t + 0.2f * (Random() - 0.5f);
+    r.rs41_hum = 10.0f;
+    r.rs41_pres = 1013.25f * expf(-alt / 7000.0f);
+    r.tsen_airt = t + 0.2f * (Random() - 0.5f);
+    r.tsen_ptemp = 20.0f;
+    r.tsen_pres = r.rs41_pres;
+    ECUReportBytes_t bytes = ecu_report_serialize(r);
+    host::QueueLoRa(bytes.data(), bytes.size());
+}
+
+// Follow what the firmware did in the last loop
+void FlightSim::Observe(uint32_t now_ms)
+{
+    std::string s = rats->getStateName(rats->HostMode(), rats->HostSubstate()).c_str();
+    if (s != state) {
+        if (!state.empty()) {
+            result.states[state].ms += now_ms - state_ms;
+        }
+        result.states[s].entries++;
+        state = s;
+        state_ms = now_ms;
+        Note(s);
+    }
+
+    for (; zephyr_seen < host::zephyr_tx.size(); zephyr_seen++) {
+        const host::ZephyrTX_t& tx = host::zephyr_tx[zephyr_seen];
+        host::ZephyrRX_t reply = {};
+        if (tx.type == "TM") {
+            SimTMStats_t& t = result.tms[tx.details[0]];
+            t.count++;
+            t.bytes += tx.payload.size();
+            Note(Format("TM %s %uB %s", tx.details[0].c_str(), (unsigned) tx.payload.size(), tx.details[2].c_str()));
+            reply.type = host::ZephyrRX_t::TM_ACK;
+            reply.ack = (Random() < cfg.tm_nak_rate) ? NAK : ACK;
+        } else if (tx.type == "S") {
+            result.s_messages++;
+            Note("S");
+            reply.type = host::ZephyrRX_t::S_ACK;
+            reply.ack = ACK;
+        } else if (tx.type == "IMR") {
+            result.imrs++;
+            reply.type = host::ZephyrRX_t::IM;
+            reply.mode = obc_mode;
+        } else {
+            (tx.ack ? result.tc_acks : result.tc_naks)++;
+            continue;
+        }
+        obc_pending.push_back({now_ms + cfg.obc_ack_ms, reply});
+    }
+    host::zephyr_tx.clear();
+    zephyr_seen = 0;
+
+    for (const host::LogLine_t& l : host::log_lines) {
+        if (l.level == host::LOG_ERROR) {
+            result.log_errors++;
+            Note("ERR: " + l.text);
+        }
+    }
+    host::log_lines.clear();
+
+    // Nothing reads the serial ports' output
+    Serial.Output().clear();
+    ZEPHYR_SERIAL.Output().clear();
+    MCB_SERIAL.Output().clear();
+}
+
+// ---------------------------------------------------------------------------
+// MCB
+
+void FlightSim::MCBModel::Send(uint32_t delay_ms, SerialMessage_t type, uint8_t id)
+{
+    HostMCBMessage_t m = {};
+    m.type = type;
+    m.id = id;
+    pending.push_back({millis() + delay_ms, m});
+}
+
+void FlightSim::MCBModel::Command(const HostMCBCommand_t& cmd)
+{
+    uint32_t now_ms = millis();
+    sim.result.mcb_commands++;
+
+    switch (cmd.id) {
+    case MCB_REEL_OUT:
+    case MCB_REEL_IN:
+    case MCB_IN_NO_LW:
+    {
+        Send(sim.cfg.mcb_ack_ms, ACK_MESSAGE, cmd.id);
+        float revs = cmd.param[0];
+        float speed = cmd.param[1];                 // revs/min
+        if (moving || speed <= 0) {
+            break;
+        }
+        start_pos = pos;
+        target = pos + ((cmd.id == MCB_REEL_OUT) ? -revs : revs);
+        vel = ((target < pos) ? -speed : speed) / 60.0f;
+        start_ms = now_ms + sim.cfg.mcb_ack_ms;
+        next_record_ms = start_ms + sim.cfg.record_ms;
+        moving = true;
+        fault_this = fault_next;
+        fault_next = false;
+        sim.result.motions++;
+        if (revs >= 0.01f) {
+            sim.Note(Format("MCB: %s %.1f revs at %.1f revs/min", (vel < 0) ? "out" : "in", revs, speed));
+        }
+        break;
+    }
+    case MCB_CANCEL_MOTION:
+        Send(sim.cfg.mcb_ack_ms, ACK_MESSAGE, cmd.id);
+        if (moving) {
+            moving = false;
+            sim.Note(Format("MCB: cancelled at %.1f revs", pos));
+        }
+        break;
+    case MCB_GET_VOLTAGES:
+    {
+        Send(sim.cfg.mcb_ack_ms, ACK_MESSAGE, cmd.id);
+        HostMCBMessage_t m = {};
+        m.type = ASCII_MESSAGE;
+        m.id = MCB_VOLTAGES;
+        m.voltages[0] = 15.1f;
+        m.voltages[1] = 15.0f;
+        m.voltages[2] = 5.0f;
+        m.voltages[3] = 3.3f;
+        pending.push_back({now_ms + 2 * sim.cfg.mcb_ack_ms, m});
+        break;
+    }
+    case MCB_ZERO_REEL:
+        pos = 0;
+        Send(sim.cfg.mcb_ack_ms, ACK_MESSAGE, cmd.id);
+        break;
+    default:
+        Send(sim.cfg.mcb_ack_ms, ACK_MESSAGE, cmd.id);
+        break;
+    }
+}
+
+// Only the reel position is put where RATS decodes it (MCBMotionRecord.cpp);
+// the rest of the record carries the elapsed time, so that delta encoding
+// sees a changing record.
+void FlightSim::MCBModel::SendRecord(uint32_t now_ms)
+{
+    uint8_t record[MOTION_TM_SIZE] = {0};
+    uint16_t index = 0;
+    BufferAddUInt32(now_ms - start_ms, record, sizeof(record), &index);
+    index = MCB_MOTION_REEL_POS_OFFSET;
+    BufferAddFloat(pos, record, sizeof(record), &index);
+
+    HostMCBMessage_t m = {};
+    m.type = BIN_MESSAGE;
+    m.id = MCB_MOTION_TM;
+    m.bin.assign(record, record + sizeof(record));
+    pending.push_back({now_ms, m});
+}
+
+void FlightSim::MCBModel::Service(uint32_t now_ms)
+{
+    if (moving && now_ms >= start_ms) {
+        float travelled = vel * (now_ms - start_ms) / 1000.0f;
+        float total = target - start_pos;
+        bool done = fabsf(travelled) >= fabsf(total);
+        pos = done ? target : start_pos + travelled;
+
+        if (fault_this && fabsf(travelled) >= fabsf(total) / 2) {
+            HostMCBMessage_t m = {};
+            m.type = ASCII_MESSAGE;
+            m.id = MCB_MOTION_FAULT;
+            m.fault[0] = 0x0001;
+            m.fault[3] = 0x0004;
+            pending.push_back({now_ms, m});
+            moving = false;
+            fault_this = false;
+            sim.Note(Format("MCB: motion fault at %.1f revs", pos));
+        } else if (done) {
+            SendRecord(now_ms);
+            Send(0, ASCII_MESSAGE, MCB_MOTION_FINISHED);
+            moving = false;
+        } else {
+            while (now_ms >= next_record_ms) {
+                SendRecord(now_ms);
+                next_record_ms += sim.cfg.record_ms;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pending.size();) {
+        if (pending[i].ms <= now_ms) {
+            host::mcb_rx.push_back(pending[i].msg);
+            pending.erase(pending.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,211 @@
+/*
+ *  FlightSim.h
+ *
+ *  Closed-loop flight simulation of StratoRATS on the host (env:native).
+ *
+ *  The firmware runs unmodified against the shims in test/shims, on their
+ *  virtual clock, with models standing in for the rest of the payload:
+ *
+ *  - OBC: answers mode requests with the scenario's mode, acks TMs and
+ *    safety messages, sends GPS, and sends the scenario's TCs.
+ *  - MCB: acks commands and runs reel motions at the commanded velocity,
+ *    sending a motion record every record_ms and MOTION_FINISHED at the
+ *    end, or a motion fault when one is injected.
+ *  - ECU: while powered, sends data reports over LoRa every ecu_period_ms,
+ *    measuring a standard atmosphere at the balloon altitude less the
+ *    deployed cable.
+ *
+ *  The main loop runs as in StratoCore_RATS.ino, every loop_ms of virtual
+ *  time, so a 24 hour flight runs in seconds. The result has the timeline
+ *  of state transitions and events, the time spent in each state, and the
+ *  TMs sent by type.
+ *
+ *  A scenario is a list of timed events, one per line, with # comments:
+ *
+ *      <time> MODE SB|FL|LP|SA|EF  The OBC commands a mode
+ *      <time> SW                   Shutdown warning
+ *      <time> TC <name> [p1 [p2]]  e.g. "TC DEPLOYx 100"
+ *      <time> CONSOLE <line>       Typed on the debug port
+ *      <time> ECU ON|OFF           ECU radio working or silent
+ *      <time> LORALOSS <fraction>  Fraction of ECU reports lost
+ *      <time> MCBFAULT             The next motion faults half way
+ *      <time> END                  End of the simulation
+ *
+ *  Times are seconds or h:mm:ss from power on. The TC names and parameters
+ *  are those of a recording (Recording.h).
+ */
+
+#ifndef FLIGHT_SIM_H
+#define FLIGHT_SIM_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "src/StratoRATS.h"
+#include "Recording.h"
+
+struct SimConfig_t {
+    uint32_t duration_s = 24 * 3600;
+    uint32_t seed = 1;
+    uint32_t loop_ms = 500;             // LOOP_TENTHS in StratoCore_RATS.ino
+    uint32_t epoch = 1700000000;        // RTC at power on
+
+    // OBC
+    uint32_t gps_period_s = 60;
+    uint32_t obc_ack_ms = 1000;         // TM, S and mode replies
+    float tm_nak_rate = 0.0f;
+
+    // Balloon
+    float ascent_mps = 5.0f;
+    float float_alt_m = 19000.0f;
+    float m_per_rev = 1.0f;             // Cable deployed per reel rev
+
+    // MCB
+    uint32_t mcb_ack_ms = 50;
+    uint32_t record_ms = 1000;
+
+    // ECU
+    uint8_t ecu_id = 1;
+    uint32_t ecu_boot_ms = 5000;
+    uint32_t ecu_period_ms = 3000;
+    float lora_loss = 0.0f;
+
+    // SD card
+    const char* profile = nullptr;      // REEL_PROFILE_FILE at power on, if set
+
+    bool echo_log = false;              // Print the firmware log
+    FILE* record = nullptr;             // Write a recording (Recording.h)
+};
+
+struct SimEvent_t {
+    uint32_t ms;
+    std::string text;
+};
+
+struct SimStateStats_t {
+    uint32_t entries = 0;
+    uint32_t ms = 0;
+};
+
+struct SimTMStats_t {
+    uint32_t count = 0;
+    uint32_t bytes = 0;
+};
+
+struct SimResult_t {
+    std::vector<SimEvent_t> timeline;
+    std::map<std::string, SimStateStats_t> states;  // by getStateName()
+    std::map<std::string, SimTMStats_t> tms;        // by TM type (first state detail)
+    uint32_t s_messages = 0;
+    uint32_t imrs = 0;
+    uint32_t tc_acks = 0;
+    uint32_t tc_naks = 0;
+    uint32_t log_errors = 0;
+    uint32_t ecu_reports_sent = 0;
+    uint32_t ecu_reports_lost = 0;
+    uint32_t lora_commands = 0;
+    uint32_t mcb_commands = 0;
+    uint32_t motions = 0;
+    uint32_t clock_changes = 0;
+    uint32_t loops = 0;
+    uint32_t sim_ms = 0;
+    double wall_s = 0;
+    std::string final_state;
+    float final_reel_revs = 0;
+
+    // Entries to a state, e.g. "FL_MEASURE", matched against the end of the name
+    uint32_t Entries(const char* substate) const;
+    void Print(FILE* f, bool timeline) const;
+    static void PrintCSVHeader(FILE* f);
+    void PrintCSV(FILE* f, uint32_t seed) const;
+};
+
+class FlightSim
+{
+public:
+    FlightSim(const SimConfig_t& config);
+    ~FlightSim();
+
+    // Parse a scenario (see above). Returns false, with a message in err, on
+    // the first bad line.
+    bool LoadScenario(const char* text, char* err, size_t err_size);
+
+    // Run the flight from power on. Can only be called once per process, as
+    // the firmware keeps some state in statics.
+    const SimResult_t& Run();
+
+    static const char* DEFAULT_SCENARIO;
+
+private:
+    struct Pending_t {
+        uint32_t ms;
+        HostMCBMessage_t msg;
+    };
+
+    class MCBModel : public HostMCBDevice {
+    public:
+        MCBModel(FlightSim& sim) : sim(sim) {}
+        void Command(const HostMCBCommand_t& cmd) override;
+        void Service(uint32_t now_ms);
+
+        FlightSim& sim;
+        std::vector<Pending_t> pending;
+        float pos = 0;
+        bool moving = false;
+        bool fault_next = false;
+        bool fault_this = false;
+        float start_pos = 0;
+        float target = 0;
+        float vel = 0;                  // revs/s, signed
+        uint32_t start_ms = 0;
+        uint32_t next_record_ms = 0;
+
+    private:
+        void Send(uint32_t delay_ms, SerialMessage_t type, uint8_t id);
+        void SendRecord(uint32_t now_ms);
+    };
+
+    void Loop();
+    void RunEvents(uint32_t now_ms);
+    void RunEvent(const std::string& text);
+    void RunOBC(uint32_t now_ms);
+    void RunECU(uint32_t now_ms);
+    void Observe(uint32_t now_ms);
+    float BalloonAltitude(uint32_t now_ms) const;
+    float Random();
+    void Note(const std::string& text);
+    static void ClockChanged(uint32_t hz);
+
+    SimConfig_t cfg;
+    SimResult_t result;
+    std::vector<SimEvent_t> scenario;
+    size_t next_event = 0;
+    StratoRATS* rats = nullptr;
+    MCBModel mcb;
+    Recorder recorder;
+    uint32_t rng;
+
+    // OBC
+    InstMode_t obc_mode = MODE_STANDBY;
+    size_t zephyr_seen = 0;
+    std::vector<std::pair<uint32_t, host::ZephyrRX_t>> obc_pending;
+    uint32_t next_gps_ms = 0;
+
+    // ECU
+    bool ecu_radio = true;
+    bool ecu_powered = false;
+    uint32_t ecu_next_ms = 0;
+    uint8_t ecu_report_id = 0;
+
+    // State tracking
+    std::string state;
+    uint32_t state_ms = 0;
+    bool ended = false;
+
+    static FlightSim* running;
+};
+
+// One pass of loop() in StratoCore_RATS.ino
+void RunFirmwareLoop(StratoRATS& rats);
+
+#endif // FLIGHT_SIM_H
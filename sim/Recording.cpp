@@ -0,0 +1,595 @@
+/*
+ *  Recording.cpp
+ *
+ *  Recording and replay of StratoRATS' inputs and Zephyr outputs; see
+ *  Recording.h.
+ */
+
+#include <chrono>
+#include <thread>
+#include "Recording.h"
+#include "FlightSim.h"
+#include "src/CRC32.h"
+
+// ---------------------------------------------------------------------------
+// TC and mode names
+
+enum SimTCParam_t : uint8_t { TC_FLOAT, TC_U16, TC_U8 };
+
+struct SimTC_t {
+    const char* name;
+    Telecommand_t tc;
+    SimTCParam_t kind;
+    void* p1;
+    void* p2;
+    SimTCParam_t kind2 = TC_FLOAT;  // of p2; kind is that of p1
+};
+
+static const SimTC_t SIM_TCS[] = {
+    {"DEPLOYx",         DEPLOYx,                TC_FLOAT, &mcbParam.deployLen,       nullptr},
+    {"DEPLOYv",         DEPLOYv,                TC_FLOAT, &mcbParam.deployVel,       nullptr},
+    {"DEPLOYa",         DEPLOYa,                TC_FLOAT, &mcbParam.deployAcc,       nullptr},
+    {"RETRACTx",        RETRACTx,               TC_FLOAT, &mcbParam.retractLen,      nullptr},
+    {"RETRACTv",        RETRACTv,               TC_FLOAT, &mcbParam.retractVel,      nullptr},
+    {"RETRACTa",        RETRACTa,               TC_FLOAT, &mcbParam.retractAcc,      nullptr},
+    {"FULLRETRACT",     FULLRETRACT,            TC_FLOAT, nullptr,                   nullptr},
+    {"CANCELMOTION",    CANCELMOTION,           TC_FLOAT, nullptr,                   nullptr},
+    {"ZEROREEL",        ZEROREEL,               TC_FLOAT, nullptr,                   nullptr},
+    {"TORQUELIMITS",    TORQUELIMITS,           TC_FLOAT, &mcbParam.torqueLimits[0], &mcbParam.torqueLimits[1]},
+    {"CURRLIMITS",      CURRLIMITS,             TC_FLOAT, &mcbParam.currLimits[0],   &mcbParam.currLimits[1]},
+    {"IGNORELIMITS",    IGNORELIMITS,           TC_FLOAT, nullptr,                   nullptr},
+    {"USELIMITS",       USELIMITS,              TC_FLOAT, nullptr,                   nullptr},
+    {"GETMCBEEPROM",    GETMCBEEPROM,           TC_FLOAT, nullptr,                   nullptr},
+    {"GETMCBVOLTS",     GETMCBVOLTS,            TC_FLOAT, nullptr,                   nullptr},
+    {"CONTROLLERSON",   CONTROLLERSON,          TC_FLOAT, nullptr,                   nullptr},
+    {"CONTROLLERSOFF",  CONTROLLERSOFF,         TC_FLOAT, nullptr,                   nullptr},
+    {"DECIMATE",        RATSECUDECIMATEFACTOR,  TC_U16,   &ratsParam.decimate_factor, nullptr},
+    {"REALTIMEMCBON",   RATSREALTIMEMCBON,      TC_FLOAT, nullptr,                   nullptr},
+    {"REALTIMEMCBOFF",  RATSREALTIMEMCBOFF,     TC_FLOAT, nullptr,                   nullptr},
+    {"LORATXTESTON",    RATSLORATXTESTON,       TC_FLOAT, nullptr,                   nullptr},
+    {"LORATXTESTOFF",   RATSLORATXTESTOFF,      TC_FLOAT, nullptr,                   nullptr},
+    {"GETEEPROM",       RATSGETEEPROM,          TC_FLOAT, nullptr,                   nullptr},
+    {"ECUTEMP",         RATSECUTEMP,            TC_FLOAT, &ratsParam.ecu_tempC,      nullptr},
+    {"ECUPWRON",        RATSECUPWRON,           TC_FLOAT, nullptr,                   nullptr},
+    {"ECUPWROFF",       RATSECUPWROFF,          TC_FLOAT, nullptr,                   nullptr},
+    {"RS41REGEN",       RATSRS41REGEN,          TC_FLOAT, nullptr,                   nullptr},
+    {"RS41METADATA",    RATSECURS41METADATA,    TC_FLOAT, nullptr,                   nullptr},
+    {"RS41ENON",        RATSRS41ENON,           TC_FLOAT, nullptr,                   nullptr},
+    {"RS41ENOFF",       RATSRS41ENOFF,          TC_FLOAT, nullptr,                   nullptr},
+    {"TSENPOWON",       RATSTSENPOWON,          TC_FLOAT, nullptr,                   nullptr},
+    {"TSENPOWOFF",      RATSTSENPOWOFF,         TC_FLOAT, nullptr,                   nullptr},
+    {"PAIREDECU",       RATSPAIREDCEU,          TC_U8,    &ratsParam.paired_ecu,     nullptr},
+    {"INFO",            RATSINFO,               TC_FLOAT, nullptr,                   nullptr},
+    {"PROFILELOAD",     RATSPROFILELOAD,        TC_FLOAT, nullptr,                   nullptr},
+    {"PROFILESTART",    RATSPROFILESTART,       TC_FLOAT, nullptr,                   nullptr},
+    {"PROFILEABORT",    RATSPROFILEABORT,       TC_FLOAT, nullptr,                   nullptr},
+    {"CONFIGGET",       RATSCONFIGGET,          TC_U8,    &ratsParam.config_id,      nullptr},
+    {"CONFIGSET",       RATSCONFIGSET,          TC_U8,    &ratsParam.config_id,      &ratsParam.config_value, TC_FLOAT},
+};
+
+static const char* SIM_MODES[NUM_MODES] = {"SB", "FL", "LP", "SA", "EF"};
+
+static void SetParam(SimTCParam_t kind, void* p, const char* value)
+{
+    if (!p || !value) {
+        return;
+    }
+    float f = strtof(value, nullptr);
+    switch (kind) {
+    case TC_FLOAT: *(float*) p = f; break;
+    case TC_U16:   *(uint16_t*) p = (uint16_t) f; break;
+    case TC_U8:    *(uint8_t*) p = (uint8_t) f; break;
+    }
+}
+
+static std::string FormatParam(SimTCParam_t kind, const void* p)
+{
+    char buf[32];
+    switch (kind) {
+    case TC_FLOAT: snprintf(buf, sizeof(buf), " %.9g", *(const float*) p); break;
+    case TC_U16:   snprintf(buf, sizeof(buf), " %u", *(const uint16_t*) p); break;
+    case TC_U8:    snprintf(buf, sizeof(buf), " %u", *(const uint8_t*) p); break;
+    }
+    return buf;
+}
+
+bool SimParseTC(const char* name, const char* p1, const char* p2, Telecommand_t* tc)
+{
+    for (const SimTC_t& t : SIM_TCS) {
+        if (!strcasecmp(name, t.name)) {
+            SetParam(t.kind, t.p1, p1);
+            SetParam(t.kind2, t.p2, p2);
+            *tc = t.tc;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string SimFormatTC(Telecommand_t tc)
+{
+    for (const SimTC_t& t : SIM_TCS) {
+        if (t.tc == tc) {
+            std::string s = t.name;
+            if (t.p1) s += FormatParam(t.kind, t.p1);
+            if (t.p2) s += FormatParam(t.kind2, t.p2);
+            return s;
+        }
+    }
+    return "UNKNOWN" + std::to_string((unsigned) tc);
+}
+
+bool SimParseMode(const char* name, InstMode_t* mode)
+{
+    for (int m = 0; m < NUM_MODES; m++) {
+        if (!strcasecmp(name, SIM_MODES[m])) {
+            *mode = (InstMode_t) m;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* SimModeName(InstMode_t mode)
+{
+    return (mode < NUM_MODES) ? SIM_MODES[mode] : "??";
+}
+
+// ---------------------------------------------------------------------------
+// Line formats
+
+static const char* ACK_NAMES[] = {"NO", "ACK", "NAK"};
+static const char* MCB_TYPES[] = {"NONE", "ASCII", "ACK", "BIN", "STRING"};
+
+static std::string Hex(const uint8_t* data, size_t len)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    std::string s;
+    s.reserve(2 * len);
+    for (size_t i = 0; i < len; i++) {
+        s += digits[data[i] >> 4];
+        s += digits[data[i] & 0x0F];
+    }
+    return s.empty() ? "-" : s;
+}
+
+static bool Unhex(const char* s, std::vector<uint8_t>& data)
+{
+    data.clear();
+    if (!strcmp(s, "-")) {
+        return true;
+    }
+    size_t len = strlen(s);
+    if (len % 2) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i += 2) {
+        unsigned b;
+        if (!isxdigit((unsigned char) s[i]) || !isxdigit((unsigned char) s[i + 1]) || sscanf(s + i, "%2x", &b) != 1) {
+            return false;
+        }
+        data.push_back((uint8_t) b);
+    }
+    return true;
+}
+
+static bool ParseAck(const char* s, AckFlag_t* ack)
+{
+    for (int i = 0; i < 3; i++) {
+        if (s && !strcasecmp(s, ACK_NAMES[i])) {
+            *ack = (AckFlag_t) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string RecordingOutput(const host::ZephyrTX_t& tx)
+{
+    char buf[96];
+    if (tx.type == "TM") {
+        uint32_t crc = ~CRC32Update(0xFFFFFFFF, tx.payload.data(), tx.payload.size());
+        snprintf(buf, sizeof(buf), "TM %u %08X ", (unsigned) tx.payload.size(), crc);
+        return buf + tx.details[0];
+    }
+    if (tx.type == "TCACK") {
+        return tx.ack ? "TCACK ACK" : "TCACK NAK";
+    }
+    return tx.type;
+}
+
+// ---------------------------------------------------------------------------
+// Recorder
+
+Recorder* Recorder::active = nullptr;
+
+Recorder::~Recorder()
+{
+    Stop();
+}
+
+void Recorder::Start(FILE* f, uint32_t epoch, uint32_t loop_ms)
+{
+    file = f;
+    active = this;
+    fprintf(file, "# StratoRATS recording (sim/Recording.h)\nEPOCH %u\nLOOP %u\n", epoch, loop_ms);
+    host::zephyr_rx_tap = ZephyrRX;
+    host::zephyr_tx_tap = ZephyrTX;
+    host::mcb_rx_tap = MCBRX;
+    host::lora_rx_tap = LoRaRX;
+    Serial.rx_tap = ConsoleRX;
+}
+
+void Recorder::Stop()
+{
+    if (active != this) {
+        return;
+    }
+    host::zephyr_rx_tap = nullptr;
+    host::zephyr_tx_tap = nullptr;
+    host::mcb_rx_tap = nullptr;
+    host::lora_rx_tap = nullptr;
+    Serial.rx_tap = nullptr;
+    fflush(file);
+    active = nullptr;
+}
+
+void Recorder::ZephyrRX(const host::ZephyrRX_t& m)
+{
+    FILE* f = active->file;
+    uint32_t ms = millis();
+    switch (m.type) {
+    case host::ZephyrRX_t::IM:
+        fprintf(f, "%u IM %s\n", ms, SimModeName(m.mode));
+        break;
+    case host::ZephyrRX_t::SW:
+        fprintf(f, "%u SW\n", ms);
+        break;
+    case host::ZephyrRX_t::GPS:
+        fprintf(f, "%u GPS %.9g %.9g %.9g %u\n", ms, m.lat, m.lon, m.alt, m.epoch);
+        break;
+    case host::ZephyrRX_t::TC:
+        // RunRouter() has set mcbParam and ratsParam from the message
+        fprintf(f, "%u TC %s\n", ms, SimFormatTC(m.tc).c_str());
+        break;
+    case host::ZephyrRX_t::TM_ACK:
+        fprintf(f, "%u TMACK %s\n", ms, ACK_NAMES[m.ack]);
+        break;
+    case host::ZephyrRX_t::S_ACK:
+        fprintf(f, "%u SACK %s\n", ms, ACK_NAMES[m.ack]);
+        break;
+    case host::ZephyrRX_t::RA_ACK:
+        fprintf(f, "%u RAACK %s\n", ms, ACK_NAMES[m.ack]);
+        break;
+    }
+}
+
+void Recorder::ZephyrTX(const host::ZephyrTX_t& m)
+{
+    fprintf(active->file, "%u > %s\n", millis(), RecordingOutput(m).c_str());
+}
+
+void Recorder::MCBRX(const HostMCBMessage_t& m)
+{
+    FILE* f = active->file;
+    fprintf(f, "%u MCB %s %u", millis(), MCB_TYPES[m.type], m.id);
+    if (m.type == BIN_MESSAGE) {
+        fprintf(f, " %s", Hex(m.bin.data(), m.bin.size()).c_str());
+    } else if (m.id == MCB_VOLTAGES) {
+        fprintf(f, " %.9g %.9g %.9g %.9g", m.voltages[0], m.voltages[1], m.voltages[2], m.voltages[3]);
+    } else if (m.id == MCB_MOTION_FAULT) {
+        for (int i = 0; i < 8; i++) {
+            fprintf(f, " %u", m.fault[i]);
+        }
+    } else if (m.id == MCB_ERROR) {
+        fprintf(f, " %s", m.error.c_str());
+    }
+    fputc('\n', f);
+}
+
+void Recorder::LoRaRX(const ECULoRaMsg_t& m)
+{
+    fprintf(active->file, "%u LORA %lu %lu %d %.9g %s\n", millis(), m.count, m.id, host::lora_rssi,
+            host::lora_snr, Hex(m.data, m.data_len).c_str());
+}
+
+void Recorder::ConsoleRX(const uint8_t* buf, size_t n)
+{
+    fprintf(active->file, "%u CONSOLE %s\n", millis(), Hex(buf, n).c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+
+void ReplayResult_t::Print(FILE* f) const
+{
+    for (const std::string& d : diffs) {
+        fprintf(f, "%s\n", d.c_str());
+    }
+    fprintf(f, "%u inputs, %u outputs (%u in the recording), %u mismatched: %s\n", inputs, outputs, expected,
+            mismatches, Matched() ? "MATCH" : "DIFFERENT");
+    fprintf(f, "%u loops, %.1f h replayed in %.2f s (%.0fx real time)\n", loops, sim_ms / 3600000.0, wall_s,
+            (wall_s > 0) ? sim_ms / 1000.0 / wall_s : 0.0);
+}
+
+FlightReplay::~FlightReplay()
+{
+    delete rats;
+}
+
+bool FlightReplay::Load(const char* text, char* err, size_t err_size)
+{
+    std::vector<Input_t> in;
+    std::vector<Output_t> out;
+    uint32_t last_ms = 0;
+    unsigned line_num = 0;
+
+    // TCs leave out the parameters they don't take
+    memset(&mcbParam, 0, sizeof(mcbParam));
+    memset(&ratsParam, 0, sizeof(ratsParam));
+
+    while (*text) {
+        const char* eol = strchr(text, '\n');
+        std::string line(text, eol ? eol - text : strlen(text));
+        text = eol ? eol + 1 : text + line.size();
+        line_num++;
+
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        while (!line.empty() && isspace((unsigned char) line.back())) {
+            line.pop_back();
+        }
+        unsigned value;
+        char word[16];
+        int n = 0;
+        if (sscanf(line.c_str(), " %15s %n", word, &n) != 1) {
+            continue;
+        }
+        if (!strcmp(word, "EPOCH") && sscanf(line.c_str() + n, "%u", &value) == 1) {
+            epoch = value;
+            continue;
+        }
+        if (!strcmp(word, "LOOP") && sscanf(line.c_str() + n, "%u", &value) == 1 && value > 0) {
+            loop_ms = value;
+            continue;
+        }
+
+        char* end;
+        uint32_t ms = (uint32_t) strtoul(word, &end, 10);
+        std::string rest = line.substr(n);
+        bool ok = (*end == '\0' && !rest.empty() && ms >= last_ms);
+        if (ok && rest[0] == '>') {
+            size_t s = rest.find_first_not_of(" \t", 1);
+            ok = (s != std::string::npos);
+            if (ok) {
+                out.push_back({ms, rest.substr(s)});
+            }
+        } else if (ok) {
+            in.emplace_back();
+            in.back().ms = ms;
+            ok = ParseInput(rest, in.back());
+        }
+        if (!ok) {
+            if (err) {
+                snprintf(err, err_size, "line %u: expected \"<ms> <input>\" or \"<ms> > <output>\" in time order",
+                         line_num);
+            }
+            return false;
+        }
+        last_ms = ms;
+    }
+
+    inputs = in;
+    outputs = out;
+    result.expected = outputs.size();
+    return true;
+}
+
+bool FlightReplay::ParseInput(const std::string& text, Input_t& in)
+{
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%s", text.c_str());
+    std::vector<const char*> args;
+    for (char* t = strtok(buf, " \t"); t && args.size() < 12; t = strtok(nullptr, " \t")) {
+        args.push_back(t);
+    }
+    auto arg = [&args](size_t i) { return (i < args.size()) ? args[i] : nullptr; };
+    const char* type = arg(0);
+    host::ZephyrRX_t& z = in.zephyr;
+    z = {};
+    in.link = Input_t::ZEPHYR;
+
+    if (!strcmp(type, "IM")) {
+        z.type = host::ZephyrRX_t::IM;
+        return arg(1) && SimParseMode(arg(1), &z.mode);
+    }
+    if (!strcmp(type, "SW")) {
+        z.type = host::ZephyrRX_t::SW;
+        return true;
+    }
+    if (!strcmp(type, "GPS") && args.size() == 5) {
+        z.type = host::ZephyrRX_t::GPS;
+        z.lat = strtof(arg(1), nullptr);
+        z.lon = strtof(arg(2), nullptr);
+        z.alt = strtof(arg(3), nullptr);
+        z.epoch = (uint32_t) strtoul(arg(4), nullptr, 10);
+        return true;
+    }
+    if (!strcmp(type, "TC") && arg(1) && SimParseTC(arg(1), arg(2), arg(3), &z.tc)) {
+        z.type = host::ZephyrRX_t::TC;
+        z.mcb_param = mcbParam;
+        z.rats_param = ratsParam;
+        return true;
+    }
+    if (!strcmp(type, "TMACK") || !strcmp(type, "SACK") || !strcmp(type, "RAACK")) {
+        z.type = (type[0] == 'T') ? host::ZephyrRX_t::TM_ACK
+                 : (type[0] == 'S') ? host::ZephyrRX_t::S_ACK : host::ZephyrRX_t::RA_ACK;
+        return ParseAck(arg(1), &z.ack);
+    }
+
+    if (!strcmp(type, "MCB") && args.size() >= 3) {
+        HostMCBMessage_t& m = in.mcb;
+        in.link = Input_t::MCB;
+        m = {};
+        m.type = NO_MESSAGE;
+        for (int i = ASCII_MESSAGE; i <= STRING_MESSAGE; i++) {
+            if (!strcmp(arg(1), MCB_TYPES[i])) {
+                m.type = (SerialMessage_t) i;
+            }
+        }
+        m.id = (uint8_t) strtoul(arg(2), nullptr, 10);
+        if (m.type == BIN_MESSAGE) {
+            return arg(3) && Unhex(arg(3), m.bin);
+        }
+        if (m.id == MCB_VOLTAGES && args.size() == 7) {
+            for (int i = 0; i < 4; i++) {
+                m.voltages[i] = strtof(arg(3 + i), nullptr);
+            }
+        } else if (m.id == MCB_MOTION_FAULT && args.size() == 11) {
+            for (int i = 0; i < 8; i++) {
+                m.fault[i] = (uint16_t) strtoul(arg(3 + i), nullptr, 10);
+            }
+        } else if (m.id == MCB_ERROR) {
+            // The rest of the line, spaces and all
+            size_t n = 0;
+            for (int word = 0; word < 3 && n != std::string::npos; word++) {
+                n = text.find_first_not_of(" \t", text.find_first_of(" \t", n));
+            }
+            m.error = (n == std::string::npos) ? "" : text.substr(n);
+        } else if (args.size() != 3) {
+            return false;
+        }
+        return m.type != NO_MESSAGE;
+    }
+
+    if (!strcmp(type, "LORA") && args.size() == 6) {
+        in.link = Input_t::LORA;
+        in.lora_count = strtoul(arg(1), nullptr, 10);
+        in.lora_id = strtoul(arg(2), nullptr, 10);
+        in.rssi = atoi(arg(3));
+        in.snr = strtof(arg(4), nullptr);
+        return Unhex(arg(5), in.data) && in.data.size() <= ECU_LORA_DATA_BUFSIZE;
+    }
+    if (!strcmp(type, "CONSOLE") && args.size() == 2) {
+        in.link = Input_t::CONSOLE;
+        return Unhex(arg(1), in.data);
+    }
+    return false;
+}
+
+// Hand a recorded input to the shim where the firmware will take it
+void FlightReplay::Queue(const Input_t& in)
+{
+    switch (in.link) {
+    case Input_t::ZEPHYR:
+        host::zephyr_rx.push_back(in.zephyr);
+        break;
+    case Input_t::MCB:
+        host::mcb_rx.push_back(in.mcb);
+        break;
+    case Input_t::LORA:
+    {
+        ECULoRaMsg_t m = {};
+        m.count = in.lora_count;
+        m.id = in.lora_id;
+        m.data_len = (uint8_t) in.data.size();
+        memcpy(m.data, in.data.data(), in.data.size());
+        host::lora_rssi = in.rssi;
+        host::lora_snr = in.snr;
+        host::lora_rx.push_back(m);
+        break;
+    }
+    case Input_t::CONSOLE:
+        Serial.Inject(in.data.data(), in.data.size());
+        break;
+    }
+}
+
+void FlightReplay::Mismatch(const std::string& text)
+{
+    result.mismatches++;
+    if (result.diffs.size() < MAX_DIFFS) {
+        result.diffs.push_back(text);
+    }
+}
+
+void FlightReplay::Compare(const host::ZephyrTX_t& tx)
+{
+    result.outputs++;
+    std::string got = std::to_string(tx.ms) + " > " + RecordingOutput(tx);
+    if (next_output >= outputs.size()) {
+        Mismatch("Not in the recording: " + got);
+        return;
+    }
+    const Output_t& e = outputs[next_output++];
+    std::string expected = std::to_string(e.ms) + " > " + e.text;
+    if (got != expected) {
+        Mismatch("Expected: " + expected + "\n     got: " + got);
+    }
+}
+
+const ReplayResult_t& FlightReplay::Run()
+{
+    auto wall_start = std::chrono::steady_clock::now();
+
+    // As FlightSim::Run(), with no MCB device: its messages are recorded
+    host::Reset();
+    host::EraseEEPROM();
+    host::sd_files.clear();
+    host::SetEpoch(epoch);
+    host::log_echo = cfg.echo_log;
+
+    rats = new StratoRATS();
+    rats->InitializeCore();
+    rats->InstrumentSetup();
+
+    uint32_t end_ms = 0;
+    if (!inputs.empty()) {
+        end_ms = inputs.back().ms;
+    }
+    if (!outputs.empty() && outputs.back().ms > end_ms) {
+        end_ms = outputs.back().ms;
+    }
+
+    size_t next_input = 0;
+    for (;;) {
+        uint32_t now_ms = millis();
+        for (; next_input < inputs.size() && inputs[next_input].ms <= now_ms; next_input++) {
+            Queue(inputs[next_input]);
+            result.inputs++;
+        }
+
+        RunFirmwareLoop(*rats);
+        result.loops++;
+
+        for (const host::ZephyrTX_t& tx : host::zephyr_tx) {
+            Compare(tx);
+        }
+        host::zephyr_tx.clear();
+        host::mcb_tx.clear();
+        host::lora_tx.clear();
+        host::log_lines.clear();
+        Serial.Output().clear();
+        ZEPHYR_SERIAL.Output().clear();
+        MCB_SERIAL.Output().clear();
+
+        if (cfg.speed > 0) {
+            std::this_thread::sleep_until(wall_start + std::chrono::duration<double>(now_ms / 1000.0 / cfg.speed));
+        }
+        if (now_ms >= end_ms) {
+            break;
+        }
+        host::Advance(loop_ms);
+    }
+
+    for (; next_output < outputs.size(); next_output++) {
+        const Output_t& e = outputs[next_output];
+        Mismatch("Not sent: " + std::to_string(e.ms) + " > " + e.text);
+    }
+
+    result.sim_ms = millis();
+    result.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
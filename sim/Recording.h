@@ -0,0 +1,144 @@
+/*
+ *  Recording.h
+ *
+ *  Recordings of what StratoRATS takes in from the Zephyr, MCB and LoRa links
+ *  and the debug port, with what it sends to the OBC, and a replay engine
+ *  that feeds a recording back through the unmodified firmware on the host
+ *  and checks that it sends the same thing.
+ *
+ *  FlightSim writes a recording when SimConfig_t::record is set; one made
+ *  from flight logs (the debug port log, the SD MCB TM files and the
+ *  downlinked TMs) uses the same format. A recording is a text file with one
+ *  line per input or output, in time order, and # comments:
+ *
+ *      EPOCH <epoch>                       RTC at power on
+ *      LOOP <ms>                           Main loop period
+ *      <ms> IM SB|FL|LP|SA|EF              Zephyr: mode change
+ *      <ms> SW                             Zephyr: shutdown warning
+ *      <ms> GPS <lat> <lon> <alt> <epoch>  Zephyr: GPS
+ *      <ms> TC <name> [p1 [p2]]            Zephyr: TC, names as in scenarios
+ *      <ms> TMACK|SACK|RAACK ACK|NAK       Zephyr: acks
+ *      <ms> MCB ACK|ASCII|BIN|STRING <id> [data]
+ *                                          MCB: data is the 4 voltages of
+ *                                          MCB_VOLTAGES, the 8 fault words of
+ *                                          MCB_MOTION_FAULT, the text of
+ *                                          MCB_ERROR or the hex of a BIN
+ *      <ms> LORA <count> <id> <rssi> <snr> <hex>
+ *                                          LoRa packet as the radio gives it
+ *      <ms> CONSOLE <hex>                  Bytes typed on the debug port
+ *      <ms> > TM <bytes> <crc32> <type>    Sent: TM, CRC-32 of the payload
+ *      <ms> > S|IMR                        Sent: safety message, mode request
+ *      <ms> > TCACK ACK|NAK                Sent: TC ack
+ *
+ *  Inputs are stamped with the virtual time at which the firmware took them,
+ *  so a replay at the same loop period hands each one over in the same loop
+ *  as the recording. Inputs not in the recording (analog inputs, EEPROM and
+ *  SD contents) start as in FlightSim.
+ */
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <string>
+#include <vector>
+#include "src/StratoRATS.h"
+
+// The TCs that scenarios and recordings name. Parse sets mcbParam and
+// ratsParam from the parameters; Format writes the TC from them.
+bool SimParseTC(const char* name, const char* p1, const char* p2, Telecommand_t* tc);
+std::string SimFormatTC(Telecommand_t tc);
+
+// Mode names in scenarios and recordings
+bool SimParseMode(const char* name, InstMode_t* mode);
+const char* SimModeName(InstMode_t mode);
+
+// Writes a recording from the host shims' taps. Start() after host::Reset().
+class Recorder
+{
+public:
+    ~Recorder();
+    void Start(FILE* f, uint32_t epoch, uint32_t loop_ms);
+    void Stop();
+
+private:
+    static void ZephyrRX(const host::ZephyrRX_t& m);
+    static void ZephyrTX(const host::ZephyrTX_t& m);
+    static void MCBRX(const HostMCBMessage_t& m);
+    static void LoRaRX(const ECULoRaMsg_t& m);
+    static void ConsoleRX(const uint8_t* buf, size_t n);
+
+    FILE* file = nullptr;
+    static Recorder* active;
+};
+
+struct ReplayConfig_t {
+    float speed = 0;                    // 0: as fast as possible, 1: real time
+    bool echo_log = false;              // Print the firmware log
+};
+
+struct ReplayResult_t {
+    uint32_t inputs = 0;
+    uint32_t outputs = 0;               // Sent by the firmware
+    uint32_t expected = 0;              // Sent in the recording
+    uint32_t mismatches = 0;
+    std::vector<std::string> diffs;     // The first few mismatches
+    uint32_t loops = 0;
+    uint32_t sim_ms = 0;
+    double wall_s = 0;
+
+    bool Matched() const { return mismatches == 0 && outputs == expected; }
+    void Print(FILE* f) const;
+};
+
+class FlightReplay
+{
+public:
+    FlightReplay(const ReplayConfig_t& config) : cfg(config) {}
+    ~FlightReplay();
+
+    // Parse a recording. Returns false, with a message in err, on the first
+    // bad line.
+    bool Load(const char* text, char* err, size_t err_size);
+
+    // Replay from power on to the last line of the recording. As with
+    // FlightSim, once per process.
+    const ReplayResult_t& Run();
+
+    static const size_t MAX_DIFFS = 10;
+
+private:
+    struct Input_t {
+        uint32_t ms;
+        enum Link_t : uint8_t { ZEPHYR, MCB, LORA, CONSOLE } link;
+        host::ZephyrRX_t zephyr;
+        HostMCBMessage_t mcb;
+        std::vector<uint8_t> data;      // LoRa packet or console bytes
+        unsigned long lora_count, lora_id;
+        int rssi;
+        float snr;
+    };
+
+    struct Output_t {
+        uint32_t ms;
+        std::string text;
+    };
+
+    static bool ParseInput(const std::string& text, Input_t& in);
+    static void Queue(const Input_t& in);
+    void Compare(const host::ZephyrTX_t& tx);
+    void Mismatch(const std::string& text);
+
+    ReplayConfig_t cfg;
+    ReplayResult_t result;
+    std::vector<Input_t> inputs;
+    std::vector<Output_t> outputs;
+    size_t next_output = 0;
+    uint32_t epoch = 1700000000;
+    uint32_t loop_ms = 500;
+    StratoRATS* rats = nullptr;
+};
+
+// The recording's line for a message sent to the OBC, without the time
+std::string RecordingOutput(const host::ZephyrTX_t& tx);
+
+#endif // RECORDING_H
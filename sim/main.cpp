@@ -0,0 +1,156 @@
+/*
+ *  main.cpp
+ *
+ *  Command line for the flight simulator (FlightSim.h):
+ *
+ *      pio run -e sim && .pio/build/sim/program [options] [scenario]
+ *
+ *  With no scenario file the built-in one is flown. Each flight runs in its
+ *  own process, as the firmware keeps state in statics.
+ *
+ *  "-r <file>" records the flight's inputs and TMs (Recording.h), and
+ *  "-R <file>" replays a recording instead of flying, exiting with 1 if the
+ *  firmware did not send the recorded TMs.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include "FlightSim.h"
+
+static void Usage()
+{
+    fprintf(stderr,
+        "Usage: program [options] [scenario]\n"
+        "  -n <flights>    Fly n flights, seeds seed..seed+n-1, one CSV line each\n"
+        "  -s <seed>       Random seed (default 1)\n"
+        "  -H <hours>      Flight duration (default 24)\n"
+        "  -l <fraction>   Fraction of ECU reports lost\n"
+        "  -k <fraction>   Fraction of TMs NAKed\n"
+        "  -e <ms>         ECU report period (default 3000)\n"
+        "  -t              Print the timeline\n"
+        "  -v              Print the firmware log\n"
+        "  -p              Print the built-in scenario and exit\n"
+        "  -r <file>       Write a recording of the flight\n"
+        "  -R <file>       Replay a recording and check the TMs sent\n"
+        "  -x <speed>      Replay speed: 0 as fast as possible (default), 1 real time\n");
+}
+
+static bool ReadFile(const char* path, std::string& text)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(f);
+    return true;
+}
+
+static int Replay(const ReplayConfig_t& cfg, const char* path)
+{
+    std::string text;
+    if (!ReadFile(path, text)) {
+        fprintf(stderr, "Unable to read %s\n", path);
+        return 1;
+    }
+    FlightReplay replay(cfg);
+    char err[96];
+    if (!replay.Load(text.c_str(), err, sizeof(err))) {
+        fprintf(stderr, "Recording %s\n", err);
+        return 1;
+    }
+    const ReplayResult_t& r = replay.Run();
+    r.Print(stdout);
+    return r.Matched() ? 0 : 1;
+}
+
+static int Fly(const SimConfig_t& cfg, const std::string& scenario, bool csv, bool timeline)
+{
+    FlightSim sim(cfg);
+    char err[80];
+    if (!scenario.empty() && !sim.LoadScenario(scenario.c_str(), err, sizeof(err))) {
+        fprintf(stderr, "Scenario %s\n", err);
+        return 1;
+    }
+    const SimResult_t& r = sim.Run();
+    if (csv) {
+        r.PrintCSV(stdout, cfg.seed);
+    } else {
+        r.Print(stdout, timeline);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    SimConfig_t cfg;
+    ReplayConfig_t replay_cfg;
+    const char* record = nullptr;
+    const char* replay = nullptr;
+    uint32_t flights = 1;
+    bool timeline = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:H:l:k:e:tvpr:R:x:h")) != -1) {
+        switch (opt) {
+        case 'n': flights = (uint32_t) atoi(optarg); break;
+        case 's': cfg.seed = (uint32_t) atoi(optarg); break;
+        case 'H': cfg.duration_s = (uint32_t) (atof(optarg) * 3600); break;
+        case 'l': cfg.lora_loss = (float) atof(optarg); break;
+        case 'k': cfg.tm_nak_rate = (float) atof(optarg); break;
+        case 'e': cfg.ecu_period_ms = (uint32_t) atoi(optarg); break;
+        case 't': timeline = true; break;
+        case 'v': cfg.echo_log = replay_cfg.echo_log = true; break;
+        case 'p': fputs(FlightSim::DEFAULT_SCENARIO, stdout); return 0;
+        case 'r': record = optarg; break;
+        case 'R': replay = optarg; break;
+        case 'x': replay_cfg.speed = (float) atof(optarg); break;
+        default: Usage(); return 2;
+        }
+    }
+
+    if (replay) {
+        return Replay(replay_cfg, replay);
+    }
+
+    std::string scenario;
+    if (optind < argc && !ReadFile(argv[optind], scenario)) {
+        fprintf(stderr, "Unable to read %s\n", argv[optind]);
+        return 1;
+    }
+
+    if (flights <= 1) {
+        if (record && !(cfg.record = fopen(record, "w"))) {
+            fprintf(stderr, "Unable to write %s\n", record);
+            return 1;
+        }
+        int rc = Fly(cfg, scenario, false, timeline);
+        if (cfg.record) {
+            fclose(cfg.record);
+        }
+        return rc;
+    }
+
+    SimResult_t::PrintCSVHeader(stdout);
+    fflush(stdout);
+    int failed = 0;
+    uint32_t seed = cfg.seed;
+    for (uint32_t i = 0; i < flights; i++) {
+        cfg.seed = seed + i;
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(Fly(cfg, scenario, true, false));
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "Flight with seed %u failed\n", cfg.seed);
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}
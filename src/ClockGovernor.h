@@ -0,0 +1,171 @@
+#ifndef CLOCK_GOVERNOR_H
+#define CLOCK_GOVERNOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#if defined(__IMXRT1062__)
+extern "C" uint32_t set_arm_clock(uint32_t frequency);
+#endif
+
+// Core clock levels, lowest first
+enum ClockLevel_t : uint8_t {
+    CLOCK_LOW,          // Nothing to do but wait: low power, safety, end of flight
+    CLOCK_NOMINAL,      // The board_build.f_cpu boot frequency
+    CLOCK_HIGH,         // Reel motions and report building
+    NUM_CLOCK_LEVELS
+};
+
+// Switch the Teensy 4 core clock between a few fixed levels and account for
+// the time spent at each.
+//
+// set_arm_clock() also adjusts the core voltage and the IPG (peripheral bus)
+// divider, and updates F_CPU_ACTUAL and F_BUS_ACTUAL. millis() runs from the
+// fixed-rate SysTick reference, and the LPUARTs and the PIT (IntervalTimer,
+// which times the main loop) from the 24 MHz oscillator, so serial baud
+// rates, millis() and the loop period are unaffected. Timers clocked from the
+// IPG bus (e.g. TimerOne) would need their period re-derived in a change
+// handler.
+//
+// Raising the clock takes effect immediately. Lowering it waits until the
+// lower level has been requested continuously for DOWNSHIFT_DELAY_MS, so
+// brief lulls (e.g. between the steps of a profile) don't cause switching.
+class ClockGovernor
+{
+public:
+    typedef void (*ChangeHandler_t)(uint32_t hz);
+
+    static const uint32_t DOWNSHIFT_DELAY_MS = 5000;
+
+    static uint32_t LevelHz(ClockLevel_t level)
+    {
+        switch (level) {
+        case CLOCK_LOW:     return 24000000;
+        case CLOCK_NOMINAL: return 150000000;
+        case CLOCK_HIGH:    return 396000000;
+        default:            return 150000000;
+        }
+    }
+
+    ClockGovernor() : _handler(nullptr), _enabled(true), _level(CLOCK_NOMINAL), _actual_hz(0),
+                      _level_ms(0), _lower_since_ms(0), _lower_pending(false), _switches(0)
+    {
+        for (uint8_t i = 0; i < NUM_CLOCK_LEVELS; i++) {
+            _time_ms[i] = 0;
+        }
+    }
+
+    // Called after every frequency change with the actual new frequency
+    void SetChangeHandler(ChangeHandler_t handler) { _handler = handler; }
+
+    // Start accounting at the boot frequency
+    void Begin(uint32_t now_ms)
+    {
+        _level = CLOCK_NOMINAL;
+        _actual_hz = LevelHz(CLOCK_NOMINAL);
+        _level_ms = now_ms;
+    }
+
+    // When disabled, the clock is returned to, and held at, CLOCK_NOMINAL
+    void Enable(bool enable, uint32_t now_ms)
+    {
+        _enabled = enable;
+        if (!enable && _level != CLOCK_NOMINAL) {
+            Apply(CLOCK_NOMINAL, now_ms);
+        }
+    }
+
+    // Request a level. Returns true if the clock was changed.
+    bool Request(ClockLevel_t level, uint32_t now_ms)
+    {
+        if (!_enabled || level >= NUM_CLOCK_LEVELS || level == _level) {
+            _lower_pending = false;
+            return false;
+        }
+
+        if (level > _level) {
+            _lower_pending = false;
+            Apply(level, now_ms);
+            return true;
+        }
+
+        if (!_lower_pending) {
+            _lower_pending = true;
+            _lower_since_ms = now_ms;
+            return false;
+        }
+        if (now_ms - _lower_since_ms < DOWNSHIFT_DELAY_MS) {
+            return false;
+        }
+        _lower_pending = false;
+        Apply(level, now_ms);
+        return true;
+    }
+
+    ClockLevel_t Level() const { return _level; }
+    uint32_t ActualHz() const { return _actual_hz; }
+    uint32_t Switches() const { return _switches; }
+
+    // Time spent at a level, including the current stretch
+    uint32_t TimeAt(ClockLevel_t level, uint32_t now_ms) const
+    {
+        if (level >= NUM_CLOCK_LEVELS) {
+            return 0;
+        }
+        uint32_t t = _time_ms[level];
+        if (level == _level) {
+            t += now_ms - _level_ms;
+        }
+        return t;
+    }
+
+    // e.g. "Clock 150MHz, 3 sw: 24M 61% 150M 35% 396M 4%"
+    int Format(char* buf, size_t size, uint32_t now_ms) const
+    {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < NUM_CLOCK_LEVELS; i++) {
+            total += TimeAt((ClockLevel_t) i, now_ms);
+        }
+        if (total == 0) {
+            total = 1;
+        }
+        int n = snprintf(buf, size, "Clock %luMHz, %lu sw:", (unsigned long) (_actual_hz / 1000000),
+                         (unsigned long) _switches);
+        for (uint8_t i = 0; i < NUM_CLOCK_LEVELS && n > 0 && (size_t) n < size; i++) {
+            n += snprintf(buf + n, size - n, " %luM %lu%%", (unsigned long) (LevelHz((ClockLevel_t) i) / 1000000),
+                          (unsigned long) ((uint64_t) TimeAt((ClockLevel_t) i, now_ms) * 100 / total));
+        }
+        return n;
+    }
+
+protected:
+    void Apply(ClockLevel_t level, uint32_t now_ms)
+    {
+        _time_ms[_level] += now_ms - _level_ms;
+        _level_ms = now_ms;
+        _level = level;
+        _switches++;
+
+#if defined(__IMXRT1062__)
+        _actual_hz = set_arm_clock(LevelHz(level));
+#else
+        _actual_hz = LevelHz(level);
+#endif
+        if (_handler) {
+            _handler(_actual_hz);
+        }
+    }
+
+    ChangeHandler_t _handler;
+    bool _enabled;
+    ClockLevel_t _level;
+    uint32_t _actual_hz;
+    uint32_t _level_ms;
+    uint32_t _lower_since_ms;
+    bool _lower_pending;
+    uint32_t _switches;
+    uint32_t _time_ms[NUM_CLOCK_LEVELS];
+};
+
+#endif // CLOCK_GOVERNOR_H
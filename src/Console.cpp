@@ -0,0 +1,57 @@
+#include "StratoRATS.h"
+
+// Line commands on the debug serial port, e.g. "PROFILESTART" or
+// "CONFIGSET 18 1". They run the same code as the TCs and answer on the
+// debug port.
+void StratoRATS::ServiceConsole()
+{
+#ifndef LOG_ZEPHYR_COMMS_SHARED
+    while (Serial.available()) {
+        char c = (char) Serial.read();
+        if (c == '\r' || c == '\n') {
+            if (console_len) {
+                console_line[console_len] = '\0';
+                console_len = 0;
+                ConsoleCommand(console_line);
+            }
+        } else if (console_len < sizeof(console_line) - 1) {
+            console_line[console_len++] = c;
+        }
+    }
+#endif
+}
+
+void StratoRATS::ConsoleCommand(char* line)
+{
+    String detail("");
+    StateFlag_t flag = FINE;
+
+    char* cmd = strtok(line, " ");
+    char* id = nullptr;
+    char* value = nullptr;
+    if (!cmd) {
+        return;
+    }
+
+    if (!strcasecmp(cmd, "PROFILELOAD")) {
+        flag = ProfileLoadCommand(detail);
+    } else if (!strcasecmp(cmd, "PROFILESTART")) {
+        flag = ProfileStartCommand(detail);
+    } else if (!strcasecmp(cmd, "PROFILEABORT")) {
+        flag = ProfileAbortCommand(detail);
+    } else if (!strcasecmp(cmd, "CONFIGGET") && (id = strtok(nullptr, " "))) {
+        flag = ConfigGetCommand((uint8_t) atoi(id), detail);
+    } else if (!strcasecmp(cmd, "CONFIGSET") && (id = strtok(nullptr, " ")) && (value = strtok(nullptr, " "))) {
+        flag = ConfigSetCommand((uint8_t) atoi(id), (float) atof(value), detail);
+    } else {
+        detail = "Commands: PROFILELOAD, PROFILESTART, PROFILEABORT, CONFIGGET <id>, CONFIGSET <id> <value>";
+        flag = WARN;
+    }
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Console %s: %s %s", cmd, (flag == FINE) ? "OK" : "FAILED", detail.c_str());
+    if (flag == FINE) {
+        log_nominal(log_array);
+    } else {
+        log_error(log_array);
+    }
+}
@@ -0,0 +1,223 @@
+#ifndef ECU_STREAMS_H
+#define ECU_STREAMS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Number of ECUs tracked at once when paired_ecu is 0 (accept any ECU)
+#define MAX_ECU_STREAMS 4
+
+// Per-ECU reception state for one report collection
+struct ECUStream_t {
+    uint8_t ecu_id;
+    uint16_t received;          // Data reports received
+    uint16_t accumulated;       // Data reports added to the RATSReport (after decimation)
+    uint16_t decimate_count;
+    int32_t rssi_sum;
+    float snr_sum;
+    uint32_t last_rx_ms;
+    uint32_t max_gap_ms;        // Longest interval between consecutive reports
+};
+
+// The ECUs heard by one RATS, so that several ECUs can share a RATS in a
+// test campaign without their data becoming ambiguous.
+//
+// Every ECU record in a RATSReport already carries its ECU ID, so the
+// records of all the streams are interleaved in the one report. What is per
+// stream is the decimation (each ECU keeps every decimate_factor'th of its
+// own reports, rather than of the mixed arrival sequence) and the reception
+// statistics, which are sent with each report. ECU reports carry no sequence
+// number, so losses show up as gaps between arrivals.
+//
+// A stream is created when an ECU is first heard. Reports from ECUs beyond
+// MAX_ECU_STREAMS go to one shared overflow stream, which accumulates all of
+// them, undecimated: no ECU data is dropped for want of a table entry. The
+// IDs are kept from one collection to the next; Reset() clears the
+// statistics and, if the overflow stream was used, evicts the stream that
+// has been silent longest to make room. A paired ECU has a stream of its own
+// and never touches the table.
+class ECUStreams
+{
+public:
+    ECUStreams() : _n_streams(0)
+    {
+        _paired.ecu_id = 0;
+        _paired.decimate_count = 0;
+        Clear(_paired);
+        _overflow.ecu_id = 0;
+        _overflow.decimate_count = 0;
+        Clear(_overflow);
+    }
+
+    // Find, or create, the stream for an ECU, or the overflow stream if the
+    // table is full
+    ECUStream_t& Stream(uint8_t ecu_id)
+    {
+        for (uint8_t i = 0; i < _n_streams; i++) {
+            if (_streams[i].ecu_id == ecu_id) {
+                return _streams[i];
+            }
+        }
+        if (_n_streams >= MAX_ECU_STREAMS) {
+            return _overflow;
+        }
+        ECUStream_t& s = _streams[_n_streams++];
+        s.ecu_id = ecu_id;
+        s.decimate_count = 0;
+        Clear(s);
+        return s;
+    }
+
+    // The stream for the paired ECU
+    ECUStream_t& Paired(uint8_t ecu_id)
+    {
+        if (_paired.ecu_id != ecu_id) {
+            _paired.ecu_id = ecu_id;
+            _paired.decimate_count = 0;
+            Clear(_paired);
+        }
+        return _paired;
+    }
+
+    // Account for a data report. Returns true if it should be accumulated
+    // under a decimation factor.
+    bool Receive(ECUStream_t& s, int rssi, float snr, uint16_t decimate_factor, uint32_t now_ms)
+    {
+        if (s.received && now_ms - s.last_rx_ms > s.max_gap_ms) {
+            s.max_gap_ms = now_ms - s.last_rx_ms;
+        }
+        s.last_rx_ms = now_ms;
+        if (s.received < UINT16_MAX) {
+            s.received++;
+            s.rssi_sum += rssi;
+            s.snr_sum += snr;
+        }
+
+        // The overflow stream mixes ECUs, so it can't decimate each
+        if (&s == &_overflow) {
+            return true;
+        }
+        if (++s.decimate_count < decimate_factor) {
+            return false;
+        }
+        s.decimate_count = 0;
+        return true;
+    }
+
+    // Count a report that made it into the RATSReport
+    void Accumulated(ECUStream_t& s)
+    {
+        if (s.accumulated < UINT16_MAX) {
+            s.accumulated++;
+        }
+    }
+
+    // Streams heard since the last Reset(), counting the overflow stream as
+    // one
+    uint8_t Active() const
+    {
+        uint8_t n = (_paired.received ? 1 : 0) + (_overflow.received ? 1 : 0);
+        for (uint8_t i = 0; i < _n_streams; i++) {
+            if (_streams[i].received) {
+                n++;
+            }
+        }
+        return n;
+    }
+
+    // Reports from ECUs that didn't fit the table, since the last Reset()
+    uint16_t Overflowed() const { return _overflow.received; }
+
+    // Clear the statistics for the next collection. The decimation phase
+    // carries on.
+    void Reset()
+    {
+        if (_overflow.received && _n_streams > 0) {
+            Evict(LongestSilent());
+        }
+        for (uint8_t i = 0; i < _n_streams; i++) {
+            Clear(_streams[i]);
+        }
+        Clear(_paired);
+        Clear(_overflow);
+    }
+
+    // e.g. "ECU3 n:120/60 rssi:-87 snr:7.5 gap:12s; ECU5 n:98/49 rssi:-101 snr:1.0 gap:40s",
+    // with "others" for the overflow stream
+    int Format(char* buf, size_t size) const
+    {
+        int n = 0;
+        if (size > 0) {
+            buf[0] = '\0';
+        }
+        n = FormatStream(_paired, buf, size, n);
+        for (uint8_t i = 0; i < _n_streams; i++) {
+            n = FormatStream(_streams[i], buf, size, n);
+        }
+        return FormatStream(_overflow, buf, size, n);
+    }
+
+protected:
+    static void Clear(ECUStream_t& s)
+    {
+        s.received = 0;
+        s.accumulated = 0;
+        s.rssi_sum = 0;
+        s.snr_sum = 0;
+        s.last_rx_ms = 0;
+        s.max_gap_ms = 0;
+    }
+
+    // True if a has been silent longer than b; a stream not heard since the
+    // last Reset() longest of all
+    static bool SilentLonger(const ECUStream_t& a, const ECUStream_t& b)
+    {
+        if (!a.received || !b.received) {
+            return !a.received && b.received;
+        }
+        return (int32_t) (a.last_rx_ms - b.last_rx_ms) < 0;
+    }
+
+    uint8_t LongestSilent() const
+    {
+        uint8_t oldest = 0;
+        for (uint8_t i = 1; i < _n_streams; i++) {
+            if (SilentLonger(_streams[i], _streams[oldest])) {
+                oldest = i;
+            }
+        }
+        return oldest;
+    }
+
+    void Evict(uint8_t i)
+    {
+        for (; i + 1 < _n_streams; i++) {
+            _streams[i] = _streams[i + 1];
+        }
+        _n_streams--;
+    }
+
+    int FormatStream(const ECUStream_t& s, char* buf, size_t size, int n) const
+    {
+        if (s.received == 0 || n < 0 || (size_t) n >= size) {
+            return n;
+        }
+        char name[8];
+        if (&s == &_overflow) {
+            snprintf(name, sizeof(name), "others");
+        } else {
+            snprintf(name, sizeof(name), "ECU%u", s.ecu_id);
+        }
+        return n + snprintf(buf + n, size - n, "%s%s n:%u/%u rssi:%ld snr:%.1f gap:%lus", n ? "; " : "", name,
+                            s.received, s.accumulated, (long) (s.rssi_sum / s.received), s.snr_sum / s.received,
+                            (unsigned long) (s.max_gap_ms / 1000));
+    }
+
+    ECUStream_t _streams[MAX_ECU_STREAMS];
+    uint8_t _n_streams;
+    ECUStream_t _paired;        // The paired ECU, outside the table
+    ECUStream_t _overflow;      // Every ECU that didn't fit the table
+};
+
+#endif // ECU_STREAMS_H
@@ -32,6 +32,7 @@ void StratoRATS::FlightMode()
 
         // Transition to waiting for a GPS message.
         scheduler.AddAction(ACTION_GPS_WAIT_MSG, 5);
+        LatencyStart(LAT_GPS_TIME);
         inst_substate = FL_GPS_WAIT;
         log_nominal("Entering FL_GPS_WAIT");
         break;
@@ -43,6 +44,7 @@ void StratoRATS::FlightMode()
         }
         // time_valid is set when StratoCore::RouteRXMessage() receives a GPS message
         if (time_valid) {
+            LatencyEnd(LAT_GPS_TIME);
             log_nominal("Entering FL_WARMUP");
             // Initialize Flight_Warmup()
             Flight_Warmup(true);
@@ -64,31 +66,64 @@ void StratoRATS::FlightMode()
         ratsReportCheck(false);
 
         if(CheckAction(ACTION_REEL_OUT)) {
-            // Turn off the ECU
-            ECUPowerControl(false);
+            // Turn off the ECU, unless it stays on for the profile product
+            ECUMotionPower();
             mcb_motion = MOTION_REEL_OUT;
             inst_substate = FL_REEL;
             log_nominal("Entering FL_REEL (reel out)");
             // START the Flight Manual Motion state machine
             Flight_Reel(true);
         } else if (CheckAction(ACTION_REEL_IN)) {
-            // Turn off the ECU
-            ECUPowerControl(false);
+            // Turn off the ECU, unless it stays on for the profile product
+            ECUMotionPower();
             mcb_motion = MOTION_REEL_IN;
             inst_substate = FL_REEL;
             log_nominal("Entering FL_REEL (reel in)");
             // START the Flight Manual Motion state machine
             Flight_Reel(true);
+        } else if (CheckAction(ACTION_FULL_RETRACT)) {
+            // Turn off the ECU, unless it stays on for the profile product
+            ECUMotionPower();
+            inst_substate = FL_REEL;
+            log_nominal("Entering FL_REEL (full retract)");
+            // START the full retract, which runs its motions through Flight_Reel()
+            FullRetract(true);
+        } else if (CheckAction(ACTION_PROFILE_START) || ProfileAutostart()) {
+            inst_substate = FL_PROFILE;
+            log_nominal("Entering FL_PROFILE");
+            // START the reel profile sequencer
+            Flight_Profile(true);
         }
         break;
     case FL_REEL:
-        if (Flight_Reel(false)) {
-            // Turn on the ECU
-            ECUPowerControl(true);
-            // Start the warmup sequence
-            log_nominal("Entering FL_WARMUP");
-            Flight_Warmup(true);
-            inst_substate = FL_WARMUP;
+        // mcb_reeling_in selects a full retract over a single motion
+        if (mcb_reeling_in ? FullRetract(false) : Flight_Reel(false)) {
+            if (IsECUPowerEnabled()) {
+                // The ECU ran through the motion and is still warm
+                inst_substate = FL_MEASURE;
+                log_nominal("Entering FL_MEASURE");
+            } else {
+                // Turn on the ECU
+                ECUPowerControl(true);
+                // Start the warmup sequence
+                log_nominal("Entering FL_WARMUP");
+                Flight_Warmup(true);
+                inst_substate = FL_WARMUP;
+            }
+        }
+        break;
+    case FL_PROFILE:
+        if (Flight_Profile(false)) {
+            if (IsECUPowerEnabled()) {
+                inst_substate = FL_MEASURE;
+                log_nominal("Entering FL_MEASURE");
+            } else {
+                // Ended after a motion; bring the ECU back up
+                ECUPowerControl(true);
+                log_nominal("Entering FL_WARMUP");
+                Flight_Warmup(true);
+                inst_substate = FL_WARMUP;
+            }
         }
         break;
     case FL_ERROR:
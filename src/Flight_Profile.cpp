@@ -0,0 +1,220 @@
+#include "StratoRATS.h"
+
+enum ProfileStates_t {
+    PROFILE_ENTRY,
+    PROFILE_NEXT_STEP,
+    PROFILE_REEL,
+    PROFILE_WARMUP,
+    PROFILE_MEASURE,
+};
+
+static ProfileStates_t profile_state = PROFILE_ENTRY;
+
+// Run the steps of reel_profile one after another. Returns true when the
+// profile has finished or been aborted. A fault in Flight_Reel() sets
+// inst_substate to FL_ERROR, which takes flight mode out of FL_PROFILE and
+// so stops the profile.
+bool StratoRATS::Flight_Profile(bool restart_state)
+{
+    if (restart_state) {
+        profile_state = PROFILE_ENTRY;
+        profile_abort = false;
+        log_nominal("FLIGHT_PROFILE: Entering PROFILE_ENTRY");
+    }
+
+#if EXTRA_LOGGING
+    static uint old_profile_state = 256;
+    if (profile_state != old_profile_state) {
+        log_nominal((String("profile_state:" + String(profile_state)).c_str()));
+        old_profile_state = profile_state;
+    }
+#endif
+
+    // Let a motion in progress run to completion (or cancellation) first,
+    // and an ECU warmup to its end, so that warmup_status is left COMPLETE or
+    // FAILED and FlightMode() does not measure with a half warmed up ECU.
+    if (profile_abort && profile_state != PROFILE_REEL && profile_state != PROFILE_WARMUP) {
+        profile_abort = false;
+        snprintf(log_array, LOG_ARRAY_SIZE, "Profile aborted at step %u/%u", profile_step + 1, reel_profile.NumSteps());
+        SendRATSTextTM(log_array, WARN);
+        return true;
+    }
+
+    switch (profile_state) {
+    case PROFILE_ENTRY:
+        profile_step = 0;
+        profile_start_ms = millis();
+        snprintf(log_array, LOG_ARRAY_SIZE, "Profile started: %u steps", reel_profile.NumSteps());
+        SendRATSTextTM(log_array, FINE);
+        profile_state = PROFILE_NEXT_STEP;
+        log_nominal("FLIGHT_PROFILE: Entering PROFILE_NEXT_STEP");
+        break;
+
+    case PROFILE_NEXT_STEP:
+    {
+        if (profile_step >= reel_profile.NumSteps()) {
+            snprintf(log_array, LOG_ARRAY_SIZE, "Profile complete: %u steps in %lus", reel_profile.NumSteps(),
+                     (unsigned long) ((millis() - profile_start_ms) / 1000));
+            SendRATSTextTM(log_array, FINE);
+            return true;
+        }
+
+        const ReelStep_t& step = reel_profile.Step(profile_step);
+        step_start_ms = millis();
+        step_reel_ms = 0;
+        step_warmup_ms = 0;
+
+        if (step.type == STEP_DWELL) {
+            if (!IsECUPowerEnabled()) {
+                ECUPowerControl(true);
+                Flight_Warmup(true);
+                profile_state = PROFILE_WARMUP;
+                log_nominal("FLIGHT_PROFILE: Entering PROFILE_WARMUP");
+            } else {
+                measure_start_ms = millis();
+                profile_state = PROFILE_MEASURE;
+                log_nominal("FLIGHT_PROFILE: Entering PROFILE_MEASURE");
+            }
+            break;
+        }
+
+        if (step.type == STEP_OUT) {
+            deploy_length = step.revs;
+            mcb_motion = MOTION_REEL_OUT;
+        } else {
+            retract_length = step.revs;
+            mcb_motion = MOTION_REEL_IN;
+        }
+        // Turn off the ECU, unless it stays on for the profile product
+        ECUMotionPower();
+        Flight_Reel(true);
+        profile_state = PROFILE_REEL;
+        log_nominal("FLIGHT_PROFILE: Entering PROFILE_REEL");
+        break;
+    }
+
+    case PROFILE_REEL:
+        if (Flight_Reel(false)) {
+            step_reel_ms = millis() - step_start_ms;
+            if (reel_profile.Step(profile_step).measure_secs == 0) {
+                // Straight on to the next motion, without powering the ECU.
+                FinishProfileStep();
+                profile_state = PROFILE_NEXT_STEP;
+                log_nominal("FLIGHT_PROFILE: Entering PROFILE_NEXT_STEP");
+            } else if (IsECUPowerEnabled()) {
+                // The ECU ran through the motion and is still warm
+                measure_start_ms = millis();
+                profile_state = PROFILE_MEASURE;
+                log_nominal("FLIGHT_PROFILE: Entering PROFILE_MEASURE");
+            } else {
+                ECUPowerControl(true);
+                Flight_Warmup(true);
+                profile_state = PROFILE_WARMUP;
+                log_nominal("FLIGHT_PROFILE: Entering PROFILE_WARMUP");
+            }
+        }
+        break;
+
+    case PROFILE_WARMUP:
+        if (Flight_Warmup(false)) {
+            step_warmup_ms = millis() - step_start_ms - step_reel_ms;
+            if (warmup_status == WARMUP_FAILED) {
+                snprintf(log_array, LOG_ARRAY_SIZE, "Profile aborted at step %u/%u: ECU warmup failed",
+                         profile_step + 1, reel_profile.NumSteps());
+                SendRATSTextTM(log_array, CRIT);
+                return true;
+            }
+            measure_start_ms = millis();
+            profile_state = PROFILE_MEASURE;
+            log_nominal("FLIGHT_PROFILE: Entering PROFILE_MEASURE");
+        }
+        break;
+
+    case PROFILE_MEASURE:
+        // RATSREPORTs are sent by FlightMode() while the window runs.
+        if (millis() - measure_start_ms >= 1000UL * reel_profile.Step(profile_step).measure_secs) {
+            FinishProfileStep();
+            profile_state = PROFILE_NEXT_STEP;
+            log_nominal("FLIGHT_PROFILE: Entering PROFILE_NEXT_STEP");
+        }
+        break;
+
+    default:
+        // unknown state, stop the profile
+        return true;
+    }
+
+    return false;
+}
+
+void StratoRATS::FinishProfileStep()
+{
+    const ReelStep_t& step = reel_profile.Step(profile_step);
+    uint32_t step_ms = millis() - step_start_ms;
+
+    // Per-step timing: motion, ECU warmup, and the whole step
+    snprintf(log_array, LOG_ARRAY_SIZE, "Profile step %u/%u %s %.1f: reel %lus, warmup %lus, total %lus",
+             profile_step + 1, reel_profile.NumSteps(), ReelProfile::StepName(step.type), step.revs,
+             (unsigned long) (step_reel_ms / 1000), (unsigned long) (step_warmup_ms / 1000),
+             (unsigned long) (step_ms / 1000));
+    SendRATSTextTM(log_array, FINE);
+
+    profile_step++;
+}
+
+StateFlag_t StratoRATS::ProfileLoadCommand(String& detail)
+{
+    if (inst_substate == FL_PROFILE) {
+        detail = "Cannot load, profile running";
+        return WARN;
+    }
+
+    char err[64];
+    if (!reel_profile.Load(err, sizeof(err))) {
+        detail = err;
+        return WARN;
+    }
+    detail = String(reel_profile.NumSteps()) + " steps";
+    return FINE;
+}
+
+StateFlag_t StratoRATS::ProfileStartCommand(String& detail)
+{
+    if (my_inst_mode != MODE_FLIGHT || inst_substate != FL_MEASURE) {
+        detail = "Cannot start profile, not in FL_MEASURE";
+        return WARN;
+    }
+    if (reel_profile.NumSteps() == 0) {
+        detail = "No reel profile loaded";
+        return WARN;
+    }
+    SetAction(ACTION_PROFILE_START);
+    return FINE;
+}
+
+StateFlag_t StratoRATS::ProfileAbortCommand(String& detail)
+{
+    if (my_inst_mode != MODE_FLIGHT || inst_substate != FL_PROFILE) {
+        detail = "No profile running";
+        return WARN;
+    }
+    // A motion or warmup in progress finishes; no further steps are started
+    profile_abort = true;
+    return FINE;
+}
+
+bool StratoRATS::ProfileAutostart()
+{
+    if (profile_autostart_done || !ratsConfigs.Values().profile_autostart) {
+        return false;
+    }
+    profile_autostart_done = true;
+
+    if (reel_profile.NumSteps() == 0) {
+        SendRATSTextTM("Profile autostart: no reel profile loaded", WARN);
+        return false;
+    }
+    snprintf(log_array, LOG_ARRAY_SIZE, "Profile autostart: %u steps", reel_profile.NumSteps());
+    SendRATSTextTM(log_array, FINE);
+    return true;
+}
@@ -10,11 +10,17 @@ enum ReelStates_t {
 
 static ReelStates_t reel_state = REEL_ENTRY;
 static bool resend_attempted = false;
+// The scheduler can't cancel an action, so the timeout of an earlier motion
+// that finished early still fires. Only a timeout at or after this motion's
+// deadline counts.
+static uint32_t motion_deadline_ms = 0;
 
 bool StratoRATS::Flight_Reel(bool restart_state)
 {
     if (restart_state) {
         reel_state = REEL_ENTRY;
+        reel_motion_stopped = false;
+        reel_tm_ack_ms = 0;
         log_nominal("FLIGHT_REEL: Entering REEL_ENTRY");
     }
 
@@ -58,6 +64,7 @@ bool StratoRATS::Flight_Reel(bool restart_state)
             log_nominal("FLIGHT_REEL: MCB commanded motion");
             // max_reel_seconds was set in StartMCBMotion()
             scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_reel_seconds);
+            motion_deadline_ms = millis() + 1000UL * max_reel_seconds;
             reel_state = REEL_MONITOR_MOTION;
             log_nominal("FLIGHT_REEL: Entering REEL_MONITOR_MOTION");
         }
@@ -80,12 +87,15 @@ bool StratoRATS::Flight_Reel(bool restart_state)
         if (CheckAction(ACTION_MOTION_STOP)) {
             // todo: verification of motion stop
             SendMCBTM("MCBREPORT", FINE, "Commanded motion stop");
-
+            reel_motion_stopped = true;
             return true;
             break;
         }
-        if (CheckAction(ACTION_MOTION_TIMEOUT)) {
-            SendMCBTM("MCBREPORT", CRIT, "MCB Motion took longer than expected");
+        if (CheckAction(ACTION_MOTION_TIMEOUT) && (int32_t) (millis() - motion_deadline_ms) >= 0) {
+            // Report how far the reel got, from the position estimate.
+            snprintf(log_array, LOG_ARRAY_SIZE, "MCB Motion took longer than expected, %.1f revs to go",
+                     fabs(reel_est.Target() - ReelPosition()));
+            SendMCBTM("MCBREPORT", CRIT, log_array);
             log_error("FLIGHT_REEL: MCB Motion took longer than expected");
             mcbComm.TX_ASCII(MCB_CANCEL_MOTION);
             inst_substate = MODE_ERROR; // will force exit of Flight_Profile
@@ -93,8 +103,14 @@ bool StratoRATS::Flight_Reel(bool restart_state)
             break;
         }
         if (!mcb_motion_ongoing) {
-            SendMCBTM("MCBREPORT", FINE, "Finished commanded reel motion");
+            // Msg2 carries the motion summary so peaks are visible without decoding the payload
+            char summary[80];
+            mcb_motion_summary.format(summary, sizeof(summary));
+            snprintf(log_array, LOG_ARRAY_SIZE, "Finished motion %s", summary);
+            log_nominal(log_array);
+            SendMCBTM("MCBREPORT", FINE, log_array);
             reel_state = REEL_TM_ACK;
+            reel_tm_ack_ms = millis();
             scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
             log_nominal("FLIGHT_REEL: Entering REEL_TM_ACK");
         }
@@ -103,11 +119,13 @@ bool StratoRATS::Flight_Reel(bool restart_state)
     case REEL_TM_ACK:
         if (ACK == TM_ack_flag) {
             log_nominal("FLIGHT_REEL: Zephyr ACKed motion TM");
+            reel_tm_ack_ms = 0;
             return true;
         } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
             // attempt one resend
             log_error("FLIGHT_REEL: Needed to resend TM");
             ZephyrTXpoke(ZEPHYRTX_TM); // message is still saved in XMLWriter, no need to reconstruct
+            reel_tm_ack_ms = 0;
             return true;
         }
         break;
@@ -1,153 +1,121 @@
 #include "StratoRATS.h"
 #include <ArduinoJson.h>
 
-enum WarmupStates_t
-{
-    WARMUP_ENTRY,
-    WARMUP_LORA_WAIT1,
-    WARMUP_CONFIG_ECU,
-    WARMUP_LORA_WAIT2
+// The ECU is the LoRa leader: a message queued by LoRaTx() goes out in the
+// uplink slot that follows the next ECU report. So the config is queued as
+// soon as an attempt starts, the first report from the paired ECU carries it
+// out, and WARMUP_CONFIRM_REPORTS further reports show that the ECU is
+// running with it. LoRaRX() counts the reports (WarmupECUReport()), so
+// there is no polling.
+//
+// WS_ATTEMPT is the parent of the two waiting states, so its timeout
+// transitions apply to both, and re-entering it re-sends the config.
+const StratoRATS::WarmupSM_t::State_t StratoRATS::WARMUP_STATES[NUM_WARMUP_STATES] = {
+    // name           parent      initial         entry                           run      exit
+    { "ATTEMPT",      SM_NONE,    WS_CONFIG_SENT, &StratoRATS::WarmupSendConfig,  nullptr, nullptr },
+    { "CONFIG_SENT",  WS_ATTEMPT, SM_NONE,        nullptr,                        nullptr, nullptr },
+    { "CONFIRM",      WS_ATTEMPT, SM_NONE,        nullptr,                        nullptr, nullptr },
+    { "DONE",         SM_NONE,    SM_NONE,        &StratoRATS::WarmupComplete,    nullptr, nullptr },
+    { "FAILED",       SM_NONE,    SM_NONE,        &StratoRATS::WarmupFail,        nullptr, nullptr },
 };
 
-static WarmupStates_t warmup_state = WARMUP_ENTRY;
+const StratoRATS::WarmupSM_t::Transition_t StratoRATS::WARMUP_TRANSITIONS[NUM_WARMUP_TRANSITIONS] = {
+    // from            to              guard                                   action
+    { WS_CONFIG_SENT,  WS_CONFIRM,     &StratoRATS::WarmupConfigCarried,       nullptr },
+    { WS_CONFIRM,      WS_DONE,        &StratoRATS::WarmupConfirmed,           nullptr },
+    { WS_ATTEMPT,      WS_FAILED,      &StratoRATS::WarmupLastAttemptExpired,  nullptr },
+    { WS_ATTEMPT,      WS_ATTEMPT,     &StratoRATS::WarmupAttemptExpired,      &StratoRATS::WarmupRetry },
+};
 
 static JsonDocument ecu_json;
 static char ecu_json_str[ECU_LORA_DATA_BUFSIZE];
 
+void StratoRATS::WarmupECUReport()
+{
+    if (warmup_status == WARMUP_INPROCESS) {
+        warmup_reports++;
+    }
+}
+
 bool StratoRATS::Flight_Warmup(bool restart)
 {
     if (restart)
     {
-        warmup_state = WARMUP_ENTRY;
         warmup_status = WARMUP_INPROCESS;
         warmup_cycles = 0;
+        warmup_start_ms = millis();
+        warmup_sm.ResetStats();
+        warmup_sm.Start(WS_ATTEMPT, millis());
+        return false;
     }
 
-#if EXTRA_LOGGING
-    static uint old_warmup_state = 256;
-    if (warmup_state != old_warmup_state) {
-        log_nominal((String("warmup_state:" + String(warmup_state)).c_str()));
-        old_warmup_state = warmup_state;
+    if (warmup_sm.Step(millis())) {
+        log_nominal((String("Warmup: entering ") + warmup_sm.CurrentName()).c_str());
     }
-#endif
 
-    switch (warmup_state)
-    {
-    case WARMUP_ENTRY:
-        // Power on ECU
-        log_nominal("WARMUP_ENTRY Powering on ECU");
-        // Start the LoRa message counter
-        lora_count_check(true);
-        LoRaMsg_timer_start = now();
-        scheduler.AddAction(ACTION_LORA_COUNT_MSGS, 1);
-        warmup_state = WARMUP_LORA_WAIT1;
-        log_nominal("Entering WARMUP_WAIT1");
-        break;
-
-    case WARMUP_LORA_WAIT1:
-        if (LoRaMsg_timer_start + LORA_WARMUP_MSG_TIMEOUT < now())
-        {
-            warmup_cycles++;
-            if (warmup_cycles >= 2)
-            {
-                log_error("WARMUP_LORA_WAIT1 Too many LoRa message timeouts");
-                SendRATSTextTM("Warmup failed: LoRa message timeouts", CRIT);
-                warmup_status = WARMUP_FAILED;
-                return(true);
-            }
-            else
-            {
-                warmup_state = WARMUP_ENTRY;
-                log_nominal("Re-entering WARMUP_ENTRY");
-                return(false);
-            }
-        }
-        else
-        {
-            if (CheckAction(ACTION_LORA_COUNT_MSGS))
-            {
-                // Wait for enough LoRa message to arrive.
-                if (lora_count_check() >= LORA_MSG_COUNT)
-                {
-                    log_nominal("WARMUP_LORA_WAIT1 Required LoRa messages received");
-                    warmup_state = WARMUP_CONFIG_ECU;
-                    log_nominal("Entering WARMUP_CONFIG_ECU");
-                }
-                else
-                {
-                    scheduler.AddAction(ACTION_LORA_COUNT_MSGS, 1);
-                }
-            }
-        }
-        break;
-    case WARMUP_CONFIG_ECU:
-        // Configure the ECU here.
-        log_nominal("WARMUP_CONFIG_ECU Configuring ECU");
-        // TODO: Send all of the ECU config parameters in one JSON message, 
-        // since we are only allowed to send one message at a time.
-        // TODO: Abstract the ECU configuration into a separate function,
-        // with flexibility to set any collection of parameters. This can be
-        // shared with the TC handler.
-        ecu_json["tempC"] = ratsConfigs.ecu_tempC.Read();
-        serializeJson(ecu_json, ecu_json_str);
-        log_nominal((String("ECU command: ") + ecu_json_str).c_str());
-        // Send the configuration message to the ECU
-        // Don't forget that the message will not be sent until we receive a message from the ECU.
-        // So it will not work to try to send two messages back-to-back.
-        LoRaTx(ecu_json_str);
-
-        LoRaMsg_timer_start = now();
-        warmup_cycles = 0;
-        scheduler.AddAction(ACTION_LORA_COUNT_MSGS, 1);
-        warmup_state = WARMUP_LORA_WAIT2;
-        // Start the LoRa message counter
-        lora_count_check(true);
-        log_nominal("Entering WARMUP_LORA_WAIT2");
-        log_nominal("WARMUP_LORA_WAIT2 waiting for LoRa message");
-        break;
-    case WARMUP_LORA_WAIT2:
-        if (LoRaMsg_timer_start + LORA_WARMUP_MSG_TIMEOUT < now())
-        {
-            warmup_cycles++;
-            if (warmup_cycles >= 2)
-            {
-                log_error("WARMUP_LORA_WAIT2 Too many LoRa message timeouts");
-                SendRATSTextTM("Warmup failed: LoRa message timeouts", CRIT);
-                warmup_status = WARMUP_FAILED;
-                return(true);
-            }
-            else
-            {
-                warmup_state = WARMUP_ENTRY;
-                log_nominal("Re-entering WARMUP_ENTRY");
-                return(false);
-            }
-        }
-        else
-        {
-            if (CheckAction(ACTION_LORA_COUNT_MSGS))
-            {
-                // Wait for enough LoRa messages to arrive.
-                if (lora_count_check() >= LORA_MSG_COUNT)
-                {
-                    log_nominal("WARMUP_LORA_WAIT2 Required LoRa messages received");
-                    log_nominal("Warmup complete");
-                    SendRATSTextTM("Warmup complete", FINE);
-                    warmup_status = WARMUP_COMPLETE;
-                    return true;
-                }
-                else
-                {
-                    scheduler.AddAction(ACTION_LORA_COUNT_MSGS, 1);
-                }
-            }
-        }
-        break;
-
-    default:
-        // unknown state, move on!
-        return true;
-    }
+    return warmup_sm.Current() == WS_DONE || warmup_sm.Current() == WS_FAILED;
+}
+
+void StratoRATS::WarmupSendConfig()
+{
+    // TODO: Send all of the ECU config parameters in one JSON message,
+    // since we are only allowed to send one message at a time.
+    // TODO: Abstract the ECU configuration into a separate function,
+    // with flexibility to set any collection of parameters. This can be
+    // shared with the TC handler.
+    ecu_json["tempC"] = ratsConfigs.Values().ecu_tempC;
+    serializeJson(ecu_json, ecu_json_str);
+    log_nominal((String("ECU command: ") + ecu_json_str).c_str());
+    LoRaTx(ecu_json_str);
+
+    warmup_reports = 0;
+    warmup_attempt_ms = millis();
+}
+
+bool StratoRATS::WarmupConfigCarried()
+{
+    // The first report opens the uplink slot that carries the config
+    return warmup_reports >= 1;
+}
 
-    return false; //  // remain in this mode, unless we have changed inst_substate
+bool StratoRATS::WarmupConfirmed()
+{
+    return warmup_reports >= 1 + WARMUP_CONFIRM_REPORTS;
+}
+
+bool StratoRATS::WarmupAttemptExpired()
+{
+    return millis() - warmup_attempt_ms > 1000UL * LORA_WARMUP_MSG_TIMEOUT;
+}
+
+bool StratoRATS::WarmupLastAttemptExpired()
+{
+    // Two attempts in all
+    return warmup_cycles >= 1 && WarmupAttemptExpired();
+}
+
+void StratoRATS::WarmupRetry()
+{
+    warmup_cycles++;
+    log_nominal("Warmup: LoRa timeout, re-sending the ECU config");
+}
+
+void StratoRATS::WarmupComplete()
+{
+    warmup_ms = millis() - warmup_start_ms;
+    snprintf(log_array, LOG_ARRAY_SIZE, "Warmup complete in %.1fs", warmup_ms / 1000.0f);
+    log_nominal(log_array);
+    SendRATSTextTM(log_array, FINE);
+    warmup_status = WARMUP_COMPLETE;
+
+    // Per-state timing, e.g. to see how long the config took to go out
+    warmup_sm.FormatStats(log_array, LOG_ARRAY_SIZE, millis());
+    log_nominal(log_array);
+}
+
+void StratoRATS::WarmupFail()
+{
+    log_error("Warmup: too many LoRa message timeouts");
+    SendRATSTextTM("Warmup failed: LoRa message timeouts", CRIT);
+    warmup_status = WARMUP_FAILED;
 }
\ No newline at end of file
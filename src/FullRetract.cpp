@@ -0,0 +1,151 @@
+#include "StratoRATS.h"
+
+// Less than this many revs deployed counts as fully retracted.
+#define FULL_RETRACT_MIN_REVS 0.5f
+// Time allowed for the MCB to report the reel position when it is unknown
+#define FULL_RETRACT_POSITION_MS 10000
+// Time for the MCB to finish the tiny position request motion before the
+// retract is commanded
+#define FULL_RETRACT_SETTLE_MS 2000
+
+enum RetractStates_t {
+    RETRACT_ENTRY,
+    RETRACT_POSITION,
+    RETRACT_FAST,
+    RETRACT_SLOW,
+};
+
+static RetractStates_t retract_state = RETRACT_ENTRY;
+
+bool StratoRATS::FullRetract(bool restart_state)
+{
+    if (restart_state) {
+        retract_state = RETRACT_ENTRY;
+        mcb_reeling_in = true;
+        full_retract_start_ms = millis();
+        log_nominal("FULL_RETRACT: Entering RETRACT_ENTRY");
+    }
+
+    switch (retract_state) {
+    case RETRACT_ENTRY:
+    {
+        if (reel_est.Confidence(millis()) == 0) {
+            // The same tiny motion as the standby init, so that the MCB
+            // sends a motion record with the reel position.
+            InitializeReelPosition();
+            retract_state = RETRACT_POSITION;
+            log_nominal("FULL_RETRACT: Entering RETRACT_POSITION");
+            break;
+        }
+
+        // Deployed positions are negative
+        float remaining = -ReelPosition();
+        if (remaining < FULL_RETRACT_MIN_REVS) {
+            SendRATSTextTM("Full retract: already retracted", FINE);
+            mcb_reeling_in = false;
+            return true;
+        }
+
+        float fast_vel = ratsConfigs.Values().retract_velocity;
+        float slow_vel = ratsConfigs.Values().full_retract_slow_vel;
+        float slow_revs = ratsConfigs.Values().full_retract_slow_revs;
+        if (slow_revs > remaining) {
+            slow_revs = remaining;
+        }
+        float fast_revs = remaining - slow_revs;
+
+        // Expected duration from the trajectory; each phase's own timeout
+        // is set from its length and velocity in StartMCBMotion().
+        uint32_t expected_secs = (uint32_t) (60 * (fast_revs / fast_vel + slow_revs / slow_vel));
+        snprintf(log_array, LOG_ARRAY_SIZE, "Full retract %.1f revs: %.1f at %.1f, %.1f at %.1f rpm, ~%lus",
+                 remaining, fast_revs, fast_vel, slow_revs, slow_vel, (unsigned long) expected_secs);
+        SendRATSTextTM(log_array, FINE);
+
+        if (fast_revs >= FULL_RETRACT_MIN_REVS) {
+            retract_length = fast_revs;
+            mcb_motion = MOTION_REEL_IN;
+            Flight_Reel(true);
+            retract_state = RETRACT_FAST;
+            log_nominal("FULL_RETRACT: Entering RETRACT_FAST");
+        } else {
+            retract_length = remaining;
+            retract_velocity_cmd = slow_vel;
+            mcb_motion = MOTION_IN_NO_LW;
+            Flight_Reel(true);
+            retract_state = RETRACT_SLOW;
+            log_nominal("FULL_RETRACT: Entering RETRACT_SLOW");
+        }
+        break;
+    }
+
+    case RETRACT_POSITION:
+        if (CheckAction(ACTION_MOTION_STOP)) {
+            SendRATSTextTM("Full retract: stopped by command", WARN);
+            mcb_reeling_in = false;
+            return true;
+        }
+        if (reel_est.Confidence(millis()) > 0 && millis() - full_retract_start_ms >= FULL_RETRACT_SETTLE_MS) {
+            retract_state = RETRACT_ENTRY;
+            log_nominal("FULL_RETRACT: Entering RETRACT_ENTRY");
+        } else if (millis() - full_retract_start_ms >= FULL_RETRACT_POSITION_MS) {
+            SendRATSTextTM("Full retract: reel position unknown", CRIT);
+            log_error("FULL_RETRACT: reel position unknown");
+            mcb_reeling_in = false;
+            return true;
+        }
+        break;
+
+    case RETRACT_FAST:
+        if (Flight_Reel(false)) {
+            if (reel_motion_stopped) {
+                // CANCELMOTION: don't go on to the slow phase
+                snprintf(log_array, LOG_ARRAY_SIZE, "Full retract: stopped by command, reel %.1f", ReelPosition());
+                SendRATSTextTM(log_array, WARN);
+                mcb_reeling_in = false;
+                return true;
+            }
+            // Size the slow phase from where the reel actually stopped.
+            float remaining = -ReelPosition();
+            if (remaining < FULL_RETRACT_MIN_REVS) {
+                retract_state = RETRACT_ENTRY;
+                break;
+            }
+            retract_length = remaining;
+            retract_velocity_cmd = ratsConfigs.Values().full_retract_slow_vel;
+            mcb_motion = MOTION_IN_NO_LW;
+            Flight_Reel(true);
+            retract_state = RETRACT_SLOW;
+            log_nominal("FULL_RETRACT: Entering RETRACT_SLOW");
+        }
+        break;
+
+    case RETRACT_SLOW:
+        if (Flight_Reel(false)) {
+            if (reel_motion_stopped) {
+                snprintf(log_array, LOG_ARRAY_SIZE, "Full retract: stopped by command, reel %.1f", ReelPosition());
+                SendRATSTextTM(log_array, WARN);
+                mcb_reeling_in = false;
+                return true;
+            }
+            snprintf(log_array, LOG_ARRAY_SIZE, "Full retract complete in %lus, reel %.1f",
+                     (unsigned long) ((millis() - full_retract_start_ms) / 1000), ReelPosition());
+            SendRATSTextTM(log_array, FINE);
+            mcb_reeling_in = false;
+            return true;
+        }
+        break;
+
+    default:
+        // unknown state, exit
+        mcb_reeling_in = false;
+        return true;
+    }
+
+    // Flight_Reel() reports a fault by setting inst_substate
+    if (inst_substate == MODE_ERROR) {
+        log_error("FULL_RETRACT: motion fault, retract stopped");
+        mcb_reeling_in = false;
+    }
+
+    return false;
+}
@@ -0,0 +1,97 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// The latencies measured by StratoRATS. Each probe is started at one event
+// and ended at a later one; see LatencyStart()/LatencyEnd().
+enum LatencyProbe_t : uint8_t {
+    LAT_TC_MOTION,      // Motion TC accepted -> MCB motion ack (InitMCBMotionTracking)
+    LAT_MCB_ACK,        // Motion command sent to the MCB -> MCB motion ack
+    LAT_ACTION,         // Reel command action flag set -> consumed by CheckAction()
+    LAT_GPS_TIME,       // FL_GPS_WAIT entered -> time_valid
+    LAT_LOOP,           // InstrumentLoop() -> next InstrumentLoop()
+    NUM_LATENCY_PROBES
+};
+
+// Latency distribution in power-of-two millisecond bins.
+//
+// Bin 0 holds 0 ms and bin i (i >= 1) holds [2^(i-1), 2^i) ms; the last bin
+// also holds everything longer. Percentiles are reported as the upper bound
+// of the bin they fall in (never more than the maximum seen), so they are
+// conservative to within a factor of two, which is enough to see where a
+// loop period or a scheduler change moves a latency, in 40 bytes per probe.
+class LatencyHistogram
+{
+public:
+    static const uint8_t NUM_BINS = 16;
+
+    LatencyHistogram() { Reset(); }
+
+    void Reset()
+    {
+        for (uint8_t i = 0; i < NUM_BINS; i++) {
+            _bins[i] = 0;
+        }
+        _count = 0;
+        _max_ms = 0;
+    }
+
+    void Add(uint32_t ms)
+    {
+        uint8_t bin = 0;
+        while (bin < NUM_BINS - 1 && ms >= (1UL << bin)) {
+            bin++;
+        }
+        if (_bins[bin] < UINT16_MAX) {
+            _bins[bin]++;
+        }
+        _count++;
+        if (ms > _max_ms) {
+            _max_ms = ms;
+        }
+    }
+
+    uint32_t Count() const { return _count; }
+    uint32_t Max() const { return _max_ms; }
+
+    // Upper bound (ms) of the pct'th percentile
+    uint32_t Percentile(uint8_t pct) const
+    {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < NUM_BINS; i++) {
+            total += _bins[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        uint32_t rank = (total * pct + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < NUM_BINS; i++) {
+            seen += _bins[i];
+            if (seen >= rank) {
+                uint32_t upper = (i == 0) ? 0 : (1UL << i) - 1;
+                return (upper < _max_ms) ? upper : _max_ms;
+            }
+        }
+        return _max_ms;
+    }
+
+    // e.g. "MCBACK n:12 p50:<=63 p90:<=127 max:97ms"
+    int Format(const char* name, char* buf, size_t size) const
+    {
+        return snprintf(buf, size, "%s n:%lu p50:<=%lu p90:<=%lu p99:<=%lu max:%lums", name,
+                        (unsigned long) _count, (unsigned long) Percentile(50), (unsigned long) Percentile(90),
+                        (unsigned long) Percentile(99), (unsigned long) _max_ms);
+    }
+
+protected:
+    uint16_t _bins[NUM_BINS];
+    uint32_t _count;
+    uint32_t _max_ms;
+};
+
+#endif // LATENCY_STATS_H
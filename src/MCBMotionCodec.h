@@ -0,0 +1,171 @@
+#ifndef MCB_MOTION_CODEC_H
+#define MCB_MOTION_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Encoding of MCB motion records in the MCBREPORT payload.
+//
+// Every record starts with a sync byte and the elapsed time since the start
+// of the motion, in tenths of a second (big-endian uint16):
+//
+//   Key record:   0xA5 | elapsed(2) | record[RECORD_SIZE]
+//   Delta record: 0xA6 | elapsed(2) | mask[MASK_BYTES] | changed bytes
+//
+// A delta record compares the record byte by byte with the previous record in
+// the same payload. Bit (i % 8) of mask[i / 8] is set if byte i changed, and
+// only the changed bytes follow, in order. Slowly varying values (e.g. the
+// exponent and high mantissa bytes of a float) therefore cost a mask bit
+// instead of a byte.
+//
+// The first record of every payload is a key record, so each TM can be decoded
+// on its own. A key record is also forced after KEY_INTERVAL delta records to
+// bound the damage from a corrupted record.
+//
+// When the MCB reports a motion fault, its raw registers are appended as a
+// fault record, which does not change the delta reference:
+//
+//   Fault record: 0xA7 | elapsed(2) | 8 big-endian uint16 registers
+//
+// The registers are in MCB_MOTION_FAULT order; see TechnosoftRegs.h.
+//
+// This header has no Arduino dependencies so that it can be shared with host tools.
+template <size_t RECORD_SIZE>
+class MCBMotionCodec
+{
+public:
+    static const uint8_t KEY_SYNC = 0xA5;
+    static const uint8_t DELTA_SYNC = 0xA6;
+    static const uint8_t FAULT_SYNC = 0xA7;
+    static const size_t FAULT_REGS = 8;
+    static const size_t FAULT_RECORD_SIZE = 3 + 2 * FAULT_REGS;
+    static const uint16_t KEY_INTERVAL = 50;
+    static const size_t MASK_BYTES = (RECORD_SIZE + 7) / 8;
+    // The largest possible encoded record.
+    static const size_t MAX_ENCODED_SIZE = 3 + MASK_BYTES + RECORD_SIZE;
+
+    MCBMotionCodec() { Reset(); }
+
+    // Forget the previous record; the next record will be a key record.
+    void Reset()
+    {
+        _prev_valid = false;
+        _since_key = 0;
+    }
+
+    // Encode record into out (at least MAX_ENCODED_SIZE bytes), as a delta
+    // record if allow_delta is set and there is a previous record to compare
+    // against. Returns the encoded length. The codec state is not changed
+    // until Commit() is called, so the caller can discard the result.
+    size_t Encode(const uint8_t* record, uint16_t elapsed_tenths, bool allow_delta, uint8_t* out) const
+    {
+        size_t n = 0;
+        bool delta = allow_delta && _prev_valid && _since_key < KEY_INTERVAL;
+
+        out[n++] = delta ? DELTA_SYNC : KEY_SYNC;
+        out[n++] = (uint8_t)(elapsed_tenths >> 8);
+        out[n++] = (uint8_t)(elapsed_tenths & 0xFF);
+
+        if (!delta) {
+            memcpy(&out[n], record, RECORD_SIZE);
+            return n + RECORD_SIZE;
+        }
+
+        uint8_t* mask = &out[n];
+        memset(mask, 0, MASK_BYTES);
+        n += MASK_BYTES;
+        for (size_t i = 0; i < RECORD_SIZE; i++) {
+            if (record[i] != _prev[i]) {
+                mask[i / 8] |= (uint8_t)(1 << (i % 8));
+                out[n++] = record[i];
+            }
+        }
+        return n;
+    }
+
+    // The record passed to Encode() was stored; make it the reference for the next delta.
+    void Commit(const uint8_t* record, const uint8_t* encoded)
+    {
+        _since_key = (encoded[0] == KEY_SYNC) ? 0 : _since_key + 1;
+        memcpy(_prev, record, RECORD_SIZE);
+        _prev_valid = true;
+    }
+
+    // Decode one record from in (avail bytes) into record, using and updating
+    // the previous-record state. Returns the number of bytes consumed, or 0 if
+    // the input is truncated, has an unknown sync byte, or is a delta record
+    // with no preceding key record. Use DecodeFault() for FAULT_SYNC records.
+    size_t Decode(const uint8_t* in, size_t avail, uint8_t* record, uint16_t& elapsed_tenths)
+    {
+        if (avail < 3) {
+            return 0;
+        }
+        size_t n = 3;
+        elapsed_tenths = (uint16_t)((in[1] << 8) | in[2]);
+
+        if (in[0] == KEY_SYNC) {
+            if (avail < n + RECORD_SIZE) {
+                return 0;
+            }
+            memcpy(record, &in[n], RECORD_SIZE);
+            n += RECORD_SIZE;
+        } else if (in[0] == DELTA_SYNC && _prev_valid) {
+            if (avail < n + MASK_BYTES) {
+                return 0;
+            }
+            const uint8_t* mask = &in[n];
+            n += MASK_BYTES;
+            for (size_t i = 0; i < RECORD_SIZE; i++) {
+                if (mask[i / 8] & (1 << (i % 8))) {
+                    if (n >= avail) {
+                        return 0;
+                    }
+                    record[i] = in[n++];
+                } else {
+                    record[i] = _prev[i];
+                }
+            }
+        } else {
+            return 0;
+        }
+
+        Commit(record, in);
+        return n;
+    }
+
+    // Encode a fault record into out (at least FAULT_RECORD_SIZE bytes).
+    static size_t EncodeFault(const uint16_t regs[FAULT_REGS], uint16_t elapsed_tenths, uint8_t* out)
+    {
+        size_t n = 0;
+        out[n++] = FAULT_SYNC;
+        out[n++] = (uint8_t)(elapsed_tenths >> 8);
+        out[n++] = (uint8_t)(elapsed_tenths & 0xFF);
+        for (size_t i = 0; i < FAULT_REGS; i++) {
+            out[n++] = (uint8_t)(regs[i] >> 8);
+            out[n++] = (uint8_t)(regs[i] & 0xFF);
+        }
+        return n;
+    }
+
+    // Decode a fault record (in[0] == FAULT_SYNC). Returns the number of bytes
+    // consumed, or 0 if it is not a complete fault record.
+    static size_t DecodeFault(const uint8_t* in, size_t avail, uint16_t regs[FAULT_REGS], uint16_t& elapsed_tenths)
+    {
+        if (avail < FAULT_RECORD_SIZE || in[0] != FAULT_SYNC) {
+            return 0;
+        }
+        elapsed_tenths = (uint16_t)((in[1] << 8) | in[2]);
+        for (size_t i = 0; i < FAULT_REGS; i++) {
+            regs[i] = (uint16_t)((in[3 + 2 * i] << 8) | in[4 + 2 * i]);
+        }
+        return FAULT_RECORD_SIZE;
+    }
+
+protected:
+    uint8_t _prev[RECORD_SIZE];
+    bool _prev_valid;
+    uint16_t _since_key;
+};
+
+#endif // MCB_MOTION_CODEC_H
@@ -0,0 +1,43 @@
+/*
+ *  MCBMotionRecord.cpp
+ *
+ *  MCB_MOTION_TM reel position and per-motion summary.
+ */
+
+#include "MCBMotionRecord.h"
+#include "Serialize.h"
+
+bool MCBMotionReelPos(const uint8_t* buf, uint16_t len, float& reel_pos)
+{
+    if (len != MOTION_TM_SIZE) {
+        return false;
+    }
+
+    // The Serialize.h getters take a non-const buffer, but do not modify it.
+    uint16_t index = MCB_MOTION_REEL_POS_OFFSET;
+    return BufferGetFloat(&reel_pos, const_cast<uint8_t*>(buf), len, &index);
+}
+
+void MCBMotionSummary_t::reset()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void MCBMotionSummary_t::add(bool pos_valid, float reel_pos)
+{
+    if (pos_valid) {
+        if (!has_pos || reel_pos < min_reel_pos) min_reel_pos = reel_pos;
+        if (!has_pos || reel_pos > max_reel_pos) max_reel_pos = reel_pos;
+        has_pos = true;
+    }
+    n_records++;
+}
+
+void MCBMotionSummary_t::format(char* buf, size_t size) const
+{
+    if (has_pos) {
+        snprintf(buf, size, "n:%u P:%.1f..%.1f", n_records, min_reel_pos, max_reel_pos);
+    } else {
+        snprintf(buf, size, "n:%u P:-", n_records);
+    }
+}
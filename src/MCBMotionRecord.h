@@ -0,0 +1,48 @@
+/*
+ *  MCBMotionRecord.h
+ *
+ *  What RATS reads from the MCB_MOTION_TM binary record sent by the MCB
+ *  during a reel motion, and the per-motion summary built from it.
+ *
+ *  The record layout is defined by MonitorMCB::SendMotionData() in the MCB
+ *  firmware. RATS reads only the reel position, at the offset it has always
+ *  used; the rest of the record is passed to the ground undecoded in the
+ *  MCBREPORT payload. Only read further fields once their offset and
+ *  encoding have been checked against SendMotionData(): RATS acts on these
+ *  values, and a guessed layout would decode plausible-looking garbage.
+ */
+
+#ifndef MCB_MOTION_RECORD_H
+#define MCB_MOTION_RECORD_H
+
+#include <Arduino.h>
+#include "MCBComm.h"
+
+// Byte offset of the reel position (float, revs) in the record
+#define MCB_MOTION_REEL_POS_OFFSET 21
+static_assert(MCB_MOTION_REEL_POS_OFFSET + sizeof(float) <= MOTION_TM_SIZE,
+              "MCB motion record is too small to hold the reel position");
+
+// Read the reel position from a record. Returns false if len is not
+// MOTION_TM_SIZE.
+bool MCBMotionReelPos(const uint8_t* buf, uint16_t len, float& reel_pos);
+
+// The records of one motion and the range of reel positions they reported,
+// for the Msg2 of the final MCBREPORT.
+struct MCBMotionSummary_t {
+    uint16_t n_records;
+    // Set once a record has had a reel position, so that the range starts
+    // from the first position.
+    bool has_pos;
+    float min_reel_pos;
+    float max_reel_pos;
+
+    void reset();
+    // Count a record, and its reel position if it had one.
+    void add(bool pos_valid, float reel_pos);
+    // Format the summary for a TM message, e.g. "n:120 P:-120.0..-20.1"
+    // ("P:-" if no record had a position).
+    void format(char* buf, size_t size) const;
+};
+
+#endif /* MCB_MOTION_RECORD_H */
@@ -47,6 +47,8 @@ void StratoRATS::HandleMCBASCII()
         CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
         log_nominal("MCBASCII: MCB motion finished"); // state machine will report to Zephyr
         mcb_motion_ongoing = false;
+        reel_est.StopMotion(millis());
+        motion_sup.Stop();
         break;
     case MCB_MOTION_FAULT:
         CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
@@ -60,35 +62,41 @@ void StratoRATS::HandleMCBASCII()
             // The MCB MCB_MOTION_FAULT message was successfully decoded.
             // However, there was still a motion fault.
 
-            // motion_fault[] fields, to decode, use the following maps:
-            //   [0] rl_status_lo  — Reel SRL (Status Register Low),  use SRLmap()
-            //   [1] rl_status_hi  — Reel SRH (Status Register High), use SRHmap()
-            //   [2] rl_detailed_err — Reel detailed error (MCB-specific, no bit map)
-            //   [3] rl_motion_err — Reel MER (Motion Error Register), use MERmap()
-            //   [4] lw_status_lo  — Level Wind SRL,                  use SRLmap()
-            //   [5] lw_status_hi  — Level Wind SRH,                  use SRHmap()
-            //   [6] lw_detailed_err — Level Wind detailed error (MCB-specific, no bit map)
-            //   [7] lw_motion_err — Level Wind MER,                  use MERmap()
+            // motion_fault[] holds the reel and level wind SRL, SRH, detailed
+            // error and MER, in the order given by TS_MOTION_FAULT_REGS
+            // (TechnosoftRegs.h). The raw registers go into the MCB TM as a
+            // fault record; the decoded MERs go in the message text.
 
             mcb_motion_ongoing = false;
+            reel_est.StopMotion(millis());
+            motion_sup.Stop();
+
+            AddMCBFaultRecord();
 
             snprintf(log_array, LOG_ARRAY_SIZE, "MCB Fault: %x,%x,%x,%x,%x,%x,%x,%x", motion_fault[0], motion_fault[1],
                      motion_fault[2], motion_fault[3], motion_fault[4], motion_fault[5], motion_fault[6], motion_fault[7]);
             SendMCBTM("MCBASCII", CRIT, log_array);
-            if (motion_fault[3]) { 
-                SendMCBTM("MCBASCII", CRIT, String("RL MER:" + MERmap(motion_fault[3])).c_str()); 
-            }
-            if (motion_fault[7]) { 
-                SendMCBTM("MCBASCII", CRIT, String("LW MER:" + MERmap(motion_fault[7])).c_str()); 
+            log_error(log_array);
+            if (motion_fault[3] || motion_fault[7]) {
+                // Each MER gets half of what the text leaves, so that both always fit
+                const size_t mer_size = (LOG_ARRAY_SIZE - sizeof("RL MER: LW MER:")) / 2 + 1;
+                char rl_mer[mer_size];
+                char lw_mer[mer_size];
+                TechnosoftDecode(TS_REG_MER, motion_fault[3], rl_mer, sizeof(rl_mer));
+                TechnosoftDecode(TS_REG_MER, motion_fault[7], lw_mer, sizeof(lw_mer));
+                snprintf(log_array, LOG_ARRAY_SIZE, "RL MER:%s LW MER:%s", rl_mer, lw_mer);
+                SendMCBTM("MCBASCII", CRIT, log_array);
+                log_error(log_array);
             }
 
             inst_substate = MODE_ERROR;
-            log_error(log_array);
             log_error("MCBASCII: Entering FL_ERROR MCB_MOTION_FAULT");
         } else {
             // The MCB MCB_MOTION_FAULT message was unsuccessfully decoded. 
             // However, there was still a motion fault.
             mcb_motion_ongoing = false;
+            reel_est.StopMotion(millis());
+            motion_sup.Stop();
             SendMCBTM("MCBASCII", CRIT, "MCBASCII: MCB fault, error receiving MCB parameters, motion terminated");
             inst_substate = MODE_ERROR;
             log_error("MCBASCII: MCB fault, error receiving parameters");
@@ -108,6 +116,8 @@ void StratoRATS::HandleMCBAck()
         log_nominal("MCBACK: acked cancel motion");
         mcb_motion = NO_MOTION;
         mcb_motion_ongoing = false;
+        reel_est.StopMotion(millis());
+        motion_sup.Stop();
         break;
     case MCB_GO_LOW_POWER:
         log_nominal("MCBACK: acked in low power");
@@ -129,7 +139,8 @@ void StratoRATS::HandleMCBAck()
         }
         break;
     case MCB_FULL_RETRACT:
-        mcb_reeling_in = true;
+        // RATS runs a full retract itself (FullRetract.cpp) and never sends MCB_FULL_RETRACT
+        log_error("MCBACK: unexpected full retract ack");
         break;
     case MCB_IN_ACC:
         SendMCBTM("MCBACK", FINE, "MCBACK: acked retract acc");
@@ -169,20 +180,26 @@ void StratoRATS::HandleMCBAck()
 
 void StratoRATS::HandleMCBBin()
 {
-    // reel_pos_index is the location in the binary data sent from the MCB. 
-    // That buffer is filled in MonitorMCB::SendMotionData(void),
-    // look in that code to determine the offset.
-    uint16_t reel_pos_index = 21; // todo: don't hard-code this
-
     switch (mcbComm.binary_rx.bin_id) {
     case MCB_MOTION_TM:
-        if (BufferGetFloat(&reel_pos, mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &reel_pos_index)) {
-            log_nominal((String("Reel pos: ") + String(reel_pos)).c_str());
+    {
+        bool pos_valid = MCBMotionReelPos(mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, reel_pos);
+        if (pos_valid) {
+            reel_est.AddSample(reel_pos, millis());
+            if (mcb_motion_ongoing) {
+                SuperviseMotion();
+            }
+            snprintf(log_array, LOG_ARRAY_SIZE, "Reel pos: %.2f", reel_pos);
+            log_nominal(log_array);
         } else {
-            log_nominal("Received MCB bin: unable to read position");
+            snprintf(log_array, LOG_ARRAY_SIZE, "Received MCB bin: unable to read position (len %u, expected %u)",
+                     mcbComm.binary_rx.bin_length, MOTION_TM_SIZE);
+            log_nominal(log_array);
         }
+        mcb_motion_summary.add(pos_valid, reel_pos);
         AddMCBTM();
         break;
+    }
     case MCB_EEPROM:
         SendMCBEEPROM();
         break;
@@ -223,84 +240,4 @@ void StratoRATS::HandleMCBString()
         log_error("Unknown MCB String message received");
         break;
     }
-}
-
-String StratoRATS::MERmap(uint16_t mer) {
-    // MER - Motion Error Register: https://www.technosoftmotion.com/ESM-um-html/tml_mer.htm
-    static const char* const bit_names[16] = {
-        "CANBER",   // 0:  CAN bus error
-        "SCER",     // 1:  Short-circuit protection
-        "STPTBL",   // 2:  Invalid setup table
-        "CTRER",    // 3:  Control error
-        "SCIER",    // 4:  Serial/internal communication error
-        "WRPSER",   // 5:  Hall/resolver/BiSS/wrap-around error
-        "LSPST",    // 6:  Positive limit switch active
-        "LSNST",    // 7:  Negative limit switch active
-        "OCER",     // 8:  Over-current error
-        "I2TER",    // 9:  I2T protection error
-        "OTERM",    // 10: Motor over-temperature error
-        "OTERD",    // 11: Drive over-temperature error
-        "OVER",     // 12: Over-voltage error
-        "UVER",     // 13: Under-voltage error
-        "CMDER",    // 14: Command error
-        "ENST",     // 15: Drive/motor disabled
-    };
-    String result = "";
-    for (uint8_t i = 0; i < 16; i++) {
-        if (mer & (1 << i)) {
-            if (result.length() > 0) result += ",";
-            result += bit_names[i];
-        }
-    }
-    return result.length() > 0 ? result : "none";
-}
-
-String StratoRATS::SRLmap(uint16_t srl) {
-    // SRL - Status Register Low: https://www.technosoftmotion.com/ESM-um-html/tml_srl.htm
-    // Only defined bits listed; reserved bits skipped.
-    struct { uint8_t bit; const char* name; } bits[] = {
-        { 15, "AXISST" },    // Axis on
-        { 14, "EVNS" },      // Last programmed event reached
-        { 10, "MOTS" },      // Motion complete
-        {  8, "CALLSST" },   // Function running via cancelable call
-        {  7, "CALLWRG" },   // Cancelable call warning
-    };
-    String result = "";
-    for (auto& b : bits) {
-        if (srl & (1 << b.bit)) {
-            if (result.length() > 0) result += ",";
-            result += b.name;
-        }
-    }
-    return result.length() > 0 ? result : "none";
-}
-
-String StratoRATS::SRHmap(uint16_t srh) {
-    // SRH - Status Register High: https://www.technosoftmotion.com/ESM-um-html/tml_srh.htm
-    static const char* const bit_names[16] = {
-        "ENDINIT",   // 0:  Drive/motor initialization complete
-        "PTRG1",     // 1:  Position trigger 1 active
-        "PTRG2",     // 2:  Position trigger 2 active
-        "PTRG3",     // 3:  Position trigger 3 active
-        "PTRG4",     // 4:  Position trigger 4 active
-        "AUTORUN",   // 5:  AUTORUN mode enabled
-        "LSWPS",     // 6:  Positive limit switch event
-        "LSWNS",     // 7:  Negative limit switch event
-        "PCAPS",     // 8:  Capture event triggered
-        "TRGR",      // 9:  Target command achieved
-        "I2TWRGM",   // 10: Motor I2T warning
-        "I2TWRGD",   // 11: Drive I2T warning
-        "INGEAR",    // 12: Electronic gearing ratio achieved
-        nullptr,     // 13: Reserved
-        "INCAM",     // 14: Absolute electronic camming position reached
-        "FAULT",     // 15: Drive/motor in fault
-    };
-    String result = "";
-    for (uint8_t i = 0; i < 16; i++) {
-        if (bit_names[i] && (srh & (1 << i))) {
-            if (result.length() > 0) result += ",";
-            result += bit_names[i];
-        }
-    }
-    return result.length() > 0 ? result : "none";
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+#ifndef MOTION_SUPERVISOR_H
+#define MOTION_SUPERVISOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Fault codes reported by MotionSupervisor, and in the MCBREPORT TM sent
+// when it cancels a motion.
+enum MotionSupervisorFault_t : uint8_t {
+    MSUP_OK = 0,
+    MSUP_STALL = 1,         // The reel stopped moving before the end of the motion
+    MSUP_LAG = 2,           // The reel fell well behind the expected trajectory
+    MSUP_OVERSPEED = 3,     // The reel moved faster than commanded, or past the target
+    MSUP_REVERSED = 4,      // The reel moved the wrong way
+};
+
+// Check each reel position sample of a motion against the trajectory
+// expected from the commanded length, velocity and acceleration.
+//
+// The expected trajectory is a trapezoid (or triangle, for short motions):
+// accelerate at the commanded acceleration, cruise at the commanded
+// velocity, and decelerate to stop at the commanded length. Each sample is
+// compared with it, and with the previous sample to get the measured
+// velocity. A condition must hold for FAULT_SAMPLES consecutive samples to
+// be reported (except a gross reversal or overrun, which is immediate), so
+// a fault is caught within a couple of MCB packets while a single noisy
+// sample is ignored. Stall and lag are not checked until the acceleration
+// phase plus START_GRACE_MS has passed.
+//
+// Lengths are in revs, velocities in revs/s and accelerations in revs/s^2;
+// times are millis() values, so this header has no Arduino dependencies.
+class MotionSupervisor
+{
+public:
+    static const uint8_t FAULT_SAMPLES = 2;
+    static const uint32_t START_GRACE_MS = 3000;
+    // Tolerances (revs, or fractions of the commanded velocity/position)
+    static constexpr float REVERSE_TOL_REVS = 0.5f;
+    static constexpr float OVERRUN_TOL_REVS = 1.0f;
+    static constexpr float END_TOL_REVS = 0.5f;
+    static constexpr float STALL_VEL_FRACTION = 0.2f;
+    static constexpr float OVERSPEED_VEL_FACTOR = 1.5f;
+    static constexpr float LAG_TOL_REVS = 2.0f;
+    static constexpr float LAG_TOL_FRACTION = 0.25f;
+
+    MotionSupervisor() : _active(false) { }
+
+    // A motion of length revs, from start_pos towards increasing reel
+    // position if direction > 0 or decreasing if direction < 0, started at
+    // now_ms. vel and acc are magnitudes; acc <= 0 means instantaneous.
+    void Start(float start_pos, float length, int8_t direction, float vel, float acc, uint32_t now_ms)
+    {
+        _start_pos = start_pos;
+        _length = length;
+        _dir = (direction < 0) ? -1.0f : 1.0f;
+        _vel = vel;
+        _acc = acc;
+        _start_ms = now_ms;
+        _have_prev = false;
+        _n_stall = _n_lag = _n_over = _n_rev = 0;
+        _last_progress = 0.0f;
+        _last_expected = 0.0f;
+        _active = (length > 0.0f) && (vel > 0.0f);
+
+        // Trapezoid timing
+        if (_acc > 0.0f) {
+            _t_acc = _vel / _acc;
+            float d_acc = 0.5f * _acc * _t_acc * _t_acc;
+            if (2.0f * d_acc > _length) {
+                // Triangular: never reaches the commanded velocity
+                _t_acc = sqrtf(_length / _acc);
+                _v_peak = _acc * _t_acc;
+                _t_cruise = 0.0f;
+            } else {
+                _v_peak = _vel;
+                _t_cruise = (_length - 2.0f * d_acc) / _vel;
+            }
+        } else {
+            _t_acc = 0.0f;
+            _v_peak = _vel;
+            _t_cruise = _length / _vel;
+        }
+    }
+
+    void Stop() { _active = false; }
+    bool Active() const { return _active; }
+
+    // Expected progress (revs along the direction of motion) t seconds after the start.
+    float ExpectedProgress(float t) const
+    {
+        float t_total = 2.0f * _t_acc + _t_cruise;
+        if (t <= 0.0f) {
+            return 0.0f;
+        }
+        if (t >= t_total) {
+            return _length;
+        }
+        if (t < _t_acc) {
+            return 0.5f * _acc * t * t;
+        }
+        float d_acc = 0.5f * _v_peak * _t_acc;
+        if (t < _t_acc + _t_cruise) {
+            return d_acc + _v_peak * (t - _t_acc);
+        }
+        float t_left = t_total - t;
+        return _length - 0.5f * _acc * t_left * t_left;
+    }
+
+    // Expected duration of the motion (s)
+    float ExpectedDuration() const { return 2.0f * _t_acc + _t_cruise; }
+
+    // Actual and expected progress at the most recent Check()
+    float LastProgress() const { return _last_progress; }
+    float LastExpected() const { return _last_expected; }
+
+    // Check a position sample. Returns MSUP_OK, or the fault detected.
+    MotionSupervisorFault_t Check(float pos, uint32_t now_ms)
+    {
+        if (!_active) {
+            return MSUP_OK;
+        }
+
+        float progress = (pos - _start_pos) * _dir;
+        float t = (float) (now_ms - _start_ms) / 1000.0f;
+        float expected = ExpectedProgress(t);
+        _last_progress = progress;
+        _last_expected = expected;
+
+        // Gross errors need no confirmation.
+        if (progress < -REVERSE_TOL_REVS) {
+            return MSUP_REVERSED;
+        }
+        if (progress > _length + OVERRUN_TOL_REVS) {
+            return MSUP_OVERSPEED;
+        }
+
+        bool past_start = (now_ms - _start_ms) > (uint32_t) (1000.0f * _t_acc) + START_GRACE_MS;
+        bool near_end = (_length - progress) < END_TOL_REVS;
+
+        // Behind the trajectory, by more than the tolerance
+        bool lag = past_start && !near_end
+            && progress < expected - (LAG_TOL_REVS + LAG_TOL_FRACTION * expected);
+        _n_lag = lag ? _n_lag + 1 : 0;
+
+        // Sample-to-sample velocity checks
+        uint32_t dt_ms = now_ms - _prev_ms;
+        if (_have_prev && dt_ms >= MIN_DT_MS) {
+            float v = (progress - _prev_progress) * 1000.0f / (float) dt_ms;
+            bool stall = past_start && !near_end && v < STALL_VEL_FRACTION * _vel;
+            bool over = v > OVERSPEED_VEL_FACTOR * _v_peak;
+            bool rev = v < -STALL_VEL_FRACTION * _vel;
+            _n_stall = stall ? _n_stall + 1 : 0;
+            _n_over = over ? _n_over + 1 : 0;
+            _n_rev = rev ? _n_rev + 1 : 0;
+        }
+        _have_prev = true;
+        _prev_progress = progress;
+        _prev_ms = now_ms;
+
+        if (_n_rev >= FAULT_SAMPLES) return MSUP_REVERSED;
+        if (_n_over >= FAULT_SAMPLES) return MSUP_OVERSPEED;
+        if (_n_stall >= FAULT_SAMPLES) return MSUP_STALL;
+        if (_n_lag >= FAULT_SAMPLES) return MSUP_LAG;
+        return MSUP_OK;
+    }
+
+    static const char* FaultName(MotionSupervisorFault_t fault)
+    {
+        switch (fault) {
+        case MSUP_OK:        return "OK";
+        case MSUP_STALL:     return "STALL";
+        case MSUP_LAG:       return "LAG";
+        case MSUP_OVERSPEED: return "OVERSPEED";
+        case MSUP_REVERSED:  return "REVERSED";
+        default:             return "?";
+        }
+    }
+
+protected:
+    // Samples closer together than this don't give a usable velocity
+    static const uint32_t MIN_DT_MS = 100;
+
+    bool _active;
+    float _start_pos;
+    float _length;
+    float _dir;
+    float _vel;
+    float _acc;
+    float _v_peak;
+    float _t_acc;
+    float _t_cruise;
+    uint32_t _start_ms;
+    bool _have_prev;
+    float _prev_progress;
+    uint32_t _prev_ms;
+    float _last_progress;
+    float _last_expected;
+    uint8_t _n_stall, _n_lag, _n_over, _n_rev;
+};
+
+#endif // MOTION_SUPERVISOR_H
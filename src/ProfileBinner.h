@@ -0,0 +1,254 @@
+#ifndef PROFILE_BINNER_H
+#define PROFILE_BINNER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// Altitude bins per profile, and bins kept on the far side of the start
+// altitude to absorb balloon altitude changes during the motion
+#define PROFILE_MAX_BINS 128
+#define PROFILE_START_MARGIN_BINS 4
+
+#define PROFILE_PRODUCT_REV 1
+#define PROFILE_HEADER_BYTES 24
+#define PROFILE_BIN_BYTES 20
+#define PROFILE_MAX_BYTES (PROFILE_HEADER_BYTES + PROFILE_MAX_BINS * PROFILE_BIN_BYTES)
+
+// The ECU measurements that are binned
+enum ProfileVar_t : uint8_t {
+    PV_TSEN_AIRT,       // TSEN air temperature, C
+    PV_RS41_AIRT,       // RS41 air temperature, C
+    PV_RS41_HUM,        // RS41 relative humidity, %
+    PV_RS41_PRES,       // RS41 pressure, hPa
+    NUM_PROFILE_VARS
+};
+
+// One ECU report, reduced to what is binned. NAN marks a value that is
+// missing or invalid.
+struct ProfileSample_t {
+    float alt_m;
+    float reel_revs;
+    float value[NUM_PROFILE_VARS];
+};
+
+// Bin the ECU measurements by altitude during one reel motion, to give a
+// vertical profile product of a few bytes per bin instead of every record.
+//
+// The bins are bin_m high and fixed, in ascending altitude, by the first
+// sample with a valid altitude: a reel out (descending) puts it near the
+// top bin and a reel in (ascending) near the bottom one. Each bin keeps the
+// mean and standard deviation (Welford's method, which is stable in float)
+// of each measurement and the mean reel position, so the product also shows
+// where the cable was when the ECU passed through each bin. Samples with no
+// altitude, or outside the bins, are only counted.
+//
+// Only one ECU is binned per profile: the first one heard.
+class ProfileBinner
+{
+public:
+    ProfileBinner() : _active(false), _n_bins_used(0) {}
+
+    void Start(uint8_t direction, float bin_m, uint32_t epoch, float start_revs)
+    {
+        for (uint16_t i = 0; i < PROFILE_MAX_BINS; i++) {
+            _bins[i].n = 0;
+            _bins[i].reel_sum = 0;
+            for (uint8_t v = 0; v < NUM_PROFILE_VARS; v++) {
+                _bins[i].var[v].n = 0;
+                _bins[i].var[v].mean = 0;
+                _bins[i].var[v].m2 = 0;
+            }
+        }
+        _active = true;
+        _direction = direction;
+        _bin_m = (bin_m > 0) ? bin_m : 1;
+        _epoch = epoch;
+        _start_revs = start_revs;
+        _end_revs = start_revs;
+        _ecu_id = 0;
+        _have_ecu = false;
+        _have_base = false;
+        _base_index = 0;
+        _n_bins_used = 0;
+        _samples = 0;
+        _no_alt = 0;
+        _out_of_range = 0;
+    }
+
+    // Finish the profile; Serialize() still returns it
+    void Stop(float end_revs)
+    {
+        _active = false;
+        _end_revs = end_revs;
+    }
+
+    bool Active() const { return _active; }
+    uint16_t Samples() const { return _samples; }
+    uint8_t BinsUsed() const { return _n_bins_used; }
+
+    // Add a sample from ecu_id. Returns true if it was binned.
+    bool Add(uint8_t ecu_id, const ProfileSample_t& s)
+    {
+        if (!_active) {
+            return false;
+        }
+        if (!_have_ecu) {
+            _ecu_id = ecu_id;
+            _have_ecu = true;
+        } else if (ecu_id != _ecu_id) {
+            return false;
+        }
+        Count(_samples);
+
+        if (isnan(s.alt_m)) {
+            Count(_no_alt);
+            return false;
+        }
+
+        int32_t alt_index = (int32_t) floorf(s.alt_m / _bin_m);
+        if (!_have_base) {
+            _base_index = (_direction == PROFILE_UP) ? alt_index - PROFILE_START_MARGIN_BINS
+                                                     : alt_index - (PROFILE_MAX_BINS - 1 - PROFILE_START_MARGIN_BINS);
+            _have_base = true;
+        }
+        int32_t i = alt_index - _base_index;
+        if (i < 0 || i >= PROFILE_MAX_BINS) {
+            Count(_out_of_range);
+            return false;
+        }
+
+        Bin_t& b = _bins[i];
+        if (b.n == 0) {
+            _n_bins_used++;
+        }
+        if (b.n < UINT16_MAX) {
+            b.n++;
+            b.reel_sum += s.reel_revs;
+        }
+        for (uint8_t v = 0; v < NUM_PROFILE_VARS; v++) {
+            if (isnan(s.value[v]) || b.var[v].n == UINT16_MAX) {
+                continue;
+            }
+            Stat_t& st = b.var[v];
+            st.n++;
+            float delta = s.value[v] - st.mean;
+            st.mean += delta / st.n;
+            st.m2 += delta * (s.value[v] - st.mean);
+        }
+        return true;
+    }
+
+    // Write the profile product to buf, big-endian; see docs/TM_specs.md.
+    // Returns the number of bytes written, 0 if size is too small.
+    size_t Serialize(uint8_t* buf, size_t size) const
+    {
+        size_t needed = PROFILE_HEADER_BYTES + (size_t) _n_bins_used * PROFILE_BIN_BYTES;
+        if (size < needed) {
+            return 0;
+        }
+
+        size_t n = 0;
+        buf[n++] = PROFILE_PRODUCT_REV;
+        buf[n++] = _ecu_id;
+        n = Put32(buf, n, _epoch);
+        buf[n++] = _direction;
+        buf[n++] = _n_bins_used;
+        n = Put16(buf, n, Saturate(_bin_m * 10, 0, UINT16_MAX));
+        n = Put32(buf, n, (uint32_t) (_have_base ? (int32_t) (_base_index * _bin_m) : 0));
+        n = Put16(buf, n, (uint16_t) Saturate(_start_revs * 10, INT16_MIN, INT16_MAX));
+        n = Put16(buf, n, (uint16_t) Saturate(_end_revs * 10, INT16_MIN, INT16_MAX));
+        n = Put16(buf, n, _samples);
+        n = Put16(buf, n, _no_alt);
+        n = Put16(buf, n, _out_of_range);
+
+        for (uint16_t i = 0; i < PROFILE_MAX_BINS; i++) {
+            const Bin_t& b = _bins[i];
+            if (b.n == 0) {
+                continue;
+            }
+            buf[n++] = (uint8_t) i;
+            buf[n++] = (uint8_t) ((b.n > UINT8_MAX) ? UINT8_MAX : b.n);
+            n = Put16(buf, n, (uint16_t) Saturate(b.reel_sum / b.n * 10, INT16_MIN, INT16_MAX));
+            for (uint8_t v = 0; v < NUM_PROFILE_VARS; v++) {
+                const Stat_t& st = b.var[v];
+                if (st.n == 0) {
+                    n = Put16(buf, n, (uint16_t) INT16_MIN);
+                    n = Put16(buf, n, 0);
+                    continue;
+                }
+                float sd = (st.n > 1) ? sqrtf(st.m2 / (st.n - 1)) : 0;
+                n = Put16(buf, n, (uint16_t) Saturate(st.mean * Scale(v), INT16_MIN + 1, INT16_MAX));
+                n = Put16(buf, n, (uint16_t) Saturate(sd * Scale(v), 0, UINT16_MAX));
+            }
+        }
+        return n;
+    }
+
+    // Fixed-point scale of each measurement in the product
+    static float Scale(uint8_t var) { return (var == PV_RS41_PRES) ? 10.0f : 100.0f; }
+
+    static const uint8_t PROFILE_DOWN = 0;     // Reel out
+    static const uint8_t PROFILE_UP = 1;       // Reel in
+
+protected:
+    struct Stat_t {
+        uint16_t n;
+        float mean;
+        float m2;
+    };
+    struct Bin_t {
+        uint16_t n;
+        float reel_sum;
+        Stat_t var[NUM_PROFILE_VARS];
+    };
+
+    static void Count(uint16_t& c)
+    {
+        if (c < UINT16_MAX) {
+            c++;
+        }
+    }
+
+    static int32_t Saturate(float x, int32_t lo, int32_t hi)
+    {
+        if (isnan(x)) {
+            return lo;
+        }
+        x = roundf(x);
+        if (x < lo) return lo;
+        if (x > hi) return hi;
+        return (int32_t) x;
+    }
+
+    static size_t Put16(uint8_t* buf, size_t n, uint16_t x)
+    {
+        buf[n++] = (uint8_t) (x >> 8);
+        buf[n++] = (uint8_t) x;
+        return n;
+    }
+
+    static size_t Put32(uint8_t* buf, size_t n, uint32_t x)
+    {
+        n = Put16(buf, n, (uint16_t) (x >> 16));
+        return Put16(buf, n, (uint16_t) x);
+    }
+
+    Bin_t _bins[PROFILE_MAX_BINS];
+    bool _active;
+    uint8_t _direction;
+    float _bin_m;
+    uint32_t _epoch;
+    float _start_revs;
+    float _end_revs;
+    uint8_t _ecu_id;
+    bool _have_ecu;
+    bool _have_base;
+    int32_t _base_index;
+    uint8_t _n_bins_used;
+    uint16_t _samples;
+    uint16_t _no_alt;
+    uint16_t _out_of_range;
+};
+
+#endif // PROFILE_BINNER_H
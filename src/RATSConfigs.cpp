@@ -3,21 +3,70 @@
  */
 
 #include "RATSConfigs.h"
+#include "CRC32.h"
 #include "StratoGroundPort.h"
+#include <EEPROM.h>
+#include <stddef.h>
+
+const RATSConfigField_t RATSConfigs::SCHEMA[] = {
+#define RATS_CONFIG_SCHEMA(id, type, name, dflt, min, max) \
+    { id, RATSConfigTypeOf<type>::code, #name, offsetof(RATSConfigValues_t, name), min, max },
+    RATS_CONFIG_FIELDS(RATS_CONFIG_SCHEMA)
+#undef RATS_CONFIG_SCHEMA
+};
+
+const uint8_t RATSConfigs::NUM_FIELDS = sizeof(RATSConfigs::SCHEMA) / sizeof(RATSConfigs::SCHEMA[0]);
+
+// Shadow layout: magic (2), count (1), count * record, CRC-32 of all before it (4)
+struct RATSConfigShadowRecord_t {
+    uint8_t id;
+    uint8_t type;
+    uint8_t value[4];
+};
+
+static_assert(sizeof(RATSConfigShadowRecord_t) == 6, "Shadow records must be packed");
+static_assert(sizeof(RATSConfigValues_t) <= 255, "Schema offsets are 8-bit");
+
+// The TeensyEEPROM image: the version, then every value in registration order
+#define RATS_CONFIG_SIZE(id, type, name, dflt, min, max) + sizeof(type)
+static const size_t CONFIG_IMAGE_SIZE = sizeof(uint16_t) RATS_CONFIG_FIELDS(RATS_CONFIG_SIZE);
+#undef RATS_CONFIG_SIZE
+static_assert(RATSConfigs::BASE_ADDRESS + CONFIG_IMAGE_SIZE <= CONFIG_SHADOW_ADDRESS,
+              "The config shadow overlaps the TeensyEEPROM image");
+
+static uint8_t TypeSize(uint8_t type)
+{
+    switch (type) {
+    case CFG_BOOL:  return sizeof(bool);
+    case CFG_U8:    return sizeof(uint8_t);
+    case CFG_U16:   return sizeof(uint16_t);
+    case CFG_FLOAT: return sizeof(float);
+    default:        return 0;
+    }
+}
+
+// Read a stored value of the given type as a float. Returns false for an unknown type.
+static bool LoadAsFloat(uint8_t type, const uint8_t* p, float& value)
+{
+    switch (type) {
+    case CFG_BOOL:  { bool v;     memcpy(&v, p, sizeof(v)); value = v ? 1.0f : 0.0f; break; }
+    case CFG_U8:    { uint8_t v;  memcpy(&v, p, sizeof(v)); value = v; break; }
+    case CFG_U16:   { uint16_t v; memcpy(&v, p, sizeof(v)); value = v; break; }
+    case CFG_FLOAT: { memcpy(&value, p, sizeof(value)); break; }
+    default:        return false;
+    }
+    return true;
+}
 
 RATSConfigs::RATSConfigs()
     : TeensyEEPROM(CONFIG_VERSION, BASE_ADDRESS),
     // ------------ Hard-Coded Config Defaults ------------
     // TODO Assign correct default values here
-    decimate_factor(1),
-    ecu_tempC(0.0f),
-    deploy_velocity(10.0f),
-    retract_velocity(10.0f),
-    motion_timeout(10),
-    real_time_mcb(false),
-    paired_ecu(0)
-
+#define RATS_CONFIG_DEFAULT(id, type, name, dflt, min, max) name##_eeprom(dflt),
+    RATS_CONFIG_FIELDS(RATS_CONFIG_DEFAULT)
+#undef RATS_CONFIG_DEFAULT
     // ----------------------------------------------------
+    snapshot_crc(0)
 { }
 
 void RATSConfigs::RegisterAll()
@@ -30,15 +79,195 @@ void RATSConfigs::RegisterAll()
 
     bool success = true;
 
-    success &= Register(&decimate_factor);
-    success &= Register(&ecu_tempC);
-    success &= Register(&deploy_velocity);
-    success &= Register(&retract_velocity);
-    success &= Register(&motion_timeout);
-    success &= Register(&real_time_mcb);
-    success &= Register(&paired_ecu);
+#define RATS_CONFIG_REGISTER(id, type, name, dflt, min, max) success &= Register(&name##_eeprom);
+    RATS_CONFIG_FIELDS(RATS_CONFIG_REGISTER)
+#undef RATS_CONFIG_REGISTER
 
     if (!success) {
         debug_serial->println("Error registering EEPROM configs");
     }
+}
+
+bool RATSConfigs::Initialize()
+{
+    bool success = TeensyEEPROM::Initialize();
+    Refresh();
+
+    migrated_count = 0;
+    if (!success) {
+        // The version changed and the defaults were loaded
+        migrated_count = Migrate();
+        Flush();
+    }
+
+    // Keep the shadow in step with the current schema
+    WriteShadow();
+    return success;
+}
+
+void RATSConfigs::Refresh()
+{
+#define RATS_CONFIG_LOAD(id, type, name, dflt, min, max) snapshot.name = name##_eeprom.Read();
+    RATS_CONFIG_FIELDS(RATS_CONFIG_LOAD)
+#undef RATS_CONFIG_LOAD
+    committed_snapshot = snapshot;
+    snapshot_crc = SnapshotCRC();
+    dirty = false;
+}
+
+uint32_t RATSConfigs::SnapshotCRC() const
+{
+    return ~CRC32Update(0xFFFFFFFF, (const uint8_t*)&snapshot, sizeof(snapshot));
+}
+
+void RATSConfigs::MarkChanged()
+{
+    snapshot_crc = SnapshotCRC();
+    dirty = true;
+    last_set_ms = millis();
+}
+
+const RATSConfigField_t* RATSConfigs::FindField(uint8_t id)
+{
+    for (uint8_t i = 0; i < NUM_FIELDS; i++) {
+        if (SCHEMA[i].id == id) {
+            return &SCHEMA[i];
+        }
+    }
+    return nullptr;
+}
+
+bool RATSConfigs::GetByID(uint8_t id, float& value) const
+{
+    const RATSConfigField_t* field = FindField(id);
+    if (!field) {
+        return false;
+    }
+
+    return LoadAsFloat(field->type, (const uint8_t*)&snapshot + field->offset, value);
+}
+
+bool RATSConfigs::SetByID(uint8_t id, float value)
+{
+    const RATSConfigField_t* field = FindField(id);
+    // Written so that NaN fails the range check
+    if (!field || !(value >= field->min && value <= field->max)) {
+        return false;
+    }
+
+    uint8_t* p = (uint8_t*)&snapshot + field->offset;
+    switch (field->type) {
+    case CFG_BOOL:  { bool v = (value != 0.0f);                 memcpy(p, &v, sizeof(v)); break; }
+    case CFG_U8:    { uint8_t v = (uint8_t) lroundf(value);     memcpy(p, &v, sizeof(v)); break; }
+    case CFG_U16:   { uint16_t v = (uint16_t) lroundf(value);   memcpy(p, &v, sizeof(v)); break; }
+    case CFG_FLOAT: { memcpy(p, &value, sizeof(value)); break; }
+    default:        return false;
+    }
+    MarkChanged();
+    return true;
+}
+
+void RATSConfigs::WriteShadow()
+{
+    static_assert(CONFIG_SHADOW_MAX_FIELDS >= sizeof(SCHEMA) / sizeof(SCHEMA[0]), "Too many config fields for the shadow");
+
+    uint8_t buf[3 + CONFIG_SHADOW_MAX_FIELDS * sizeof(RATSConfigShadowRecord_t) + 4];
+    uint16_t n = 0;
+    buf[n++] = CONFIG_SHADOW_MAGIC & 0xFF;
+    buf[n++] = CONFIG_SHADOW_MAGIC >> 8;
+    buf[n++] = NUM_FIELDS;
+
+    for (uint8_t i = 0; i < NUM_FIELDS; i++) {
+        RATSConfigShadowRecord_t rec = { SCHEMA[i].id, SCHEMA[i].type, { 0 } };
+        memcpy(rec.value, (const uint8_t*)&committed_snapshot + SCHEMA[i].offset, TypeSize(SCHEMA[i].type));
+        memcpy(&buf[n], &rec, sizeof(rec));
+        n += sizeof(rec);
+    }
+
+    uint32_t crc = ~CRC32Update(0xFFFFFFFF, buf, n);
+    memcpy(&buf[n], &crc, sizeof(crc));
+    n += sizeof(crc);
+
+    // update() only writes the bytes that changed
+    for (uint16_t i = 0; i < n; i++) {
+        EEPROM.update(CONFIG_SHADOW_ADDRESS + i, buf[i]);
+    }
+}
+
+uint8_t RATSConfigs::Migrate()
+{
+    uint8_t buf[3 + CONFIG_SHADOW_MAX_FIELDS * sizeof(RATSConfigShadowRecord_t) + 4];
+
+    for (uint16_t i = 0; i < 3; i++) {
+        buf[i] = EEPROM.read(CONFIG_SHADOW_ADDRESS + i);
+    }
+    uint8_t count = buf[2];
+    if ((buf[0] | (buf[1] << 8)) != CONFIG_SHADOW_MAGIC || count > CONFIG_SHADOW_MAX_FIELDS) {
+        log_error("RATSConfigs: no config shadow to migrate from");
+        return 0;
+    }
+
+    uint16_t len = 3 + count * sizeof(RATSConfigShadowRecord_t);
+    for (uint16_t i = 3; i < len + 4; i++) {
+        buf[i] = EEPROM.read(CONFIG_SHADOW_ADDRESS + i);
+    }
+    uint32_t crc;
+    memcpy(&crc, &buf[len], sizeof(crc));
+    if (crc != (uint32_t) ~CRC32Update(0xFFFFFFFF, buf, len)) {
+        log_error("RATSConfigs: config shadow CRC error");
+        return 0;
+    }
+
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        RATSConfigShadowRecord_t rec;
+        memcpy(&rec, &buf[3 + i * sizeof(rec)], sizeof(rec));
+
+        const RATSConfigField_t* field = FindField(rec.id);
+        if (!field || field->type != rec.type) {
+            continue;
+        }
+
+        // Go through SetByID() so the value is range checked against the new schema
+        float value;
+        if (LoadAsFloat(rec.type, rec.value, value) && SetByID(rec.id, value)) {
+            kept++;
+        }
+    }
+    return kept;
+}
+
+bool RATSConfigs::Service()
+{
+    if (!dirty || (millis() - last_set_ms) < CONFIG_COMMIT_DELAY_MS) {
+        return false;
+    }
+    Flush();
+    return true;
+}
+
+void RATSConfigs::Flush()
+{
+    if (!dirty) {
+        return;
+    }
+
+    if (snapshot_crc != SnapshotCRC()) {
+        log_error("RATSConfigs: RAM snapshot corrupted, reloading from EEPROM");
+        Refresh();
+        return;
+    }
+
+    // Write only the values that differ from what is in EEPROM.
+#define RATS_CONFIG_COMMIT(id, type, name, dflt, min, max) \
+    if (memcmp(&snapshot.name, &committed_snapshot.name, sizeof(type)) != 0) { \
+        name##_eeprom.Write(snapshot.name); \
+        committed_snapshot.name = snapshot.name; \
+        commit_count++; \
+    }
+    RATS_CONFIG_FIELDS(RATS_CONFIG_COMMIT)
+#undef RATS_CONFIG_COMMIT
+
+    dirty = false;
+    WriteShadow();
 }
\ No newline at end of file
@@ -5,38 +5,179 @@
  *
  *  This class manages configuration storage in EEPROM on the PIB
  *
+ *  The values are read from a RAM snapshot, Values(), so reads cost no
+ *  more than a member access. Set() updates the snapshot immediately and
+ *  marks it dirty; Service() commits the changed values to EEPROM once no
+ *  further changes have arrived for CONFIG_COMMIT_DELAY_MS, so a burst of
+ *  TCs costs one commit per changed value. The snapshot carries a CRC that
+ *  is checked before each commit, so a corrupted RAM copy is reloaded from
+ *  EEPROM rather than written to it.
+ *
+ *  Every value also has a schema entry (SCHEMA, NUM_FIELDS) giving a
+ *  permanent ID, its type and its allowed range, so that values can be read
+ *  and changed by ID (GetByID/SetByID) without a dedicated TC per value;
+ *  see the RATSCONFIGGET/RATSCONFIGSET TCs and the CONFIGGET/CONFIGSET
+ *  console commands (Console.cpp).
+ *  The values are also mirrored to a self-describing record list of
+ *  (id, type, value) at CONFIG_SHADOW_ADDRESS. When a CONFIG_VERSION change
+ *  makes TeensyEEPROM reload its defaults, every shadow record whose ID still
+ *  exists with the same type and an in-range value is carried over.
+ *
  *  To add a configuration value:
- *    1) Add a public EEPROMData<T> object in the header file
- *    2) Set the hard-coded backup value in the constructor
- *    3) Register the object in the RegisterAll method
- *    *note* maintain the order of objects in all three locations
+ *    1) Add a line to RATS_CONFIG_FIELDS, at the end (the order is the
+ *       EEPROM order) with a new ID, its type, name, hard-coded backup
+ *       value and range
+ *    2) Increment CONFIG_VERSION
+ *  Never reuse an ID. To force a value back to its default on update,
+ *  or to change its type or meaning, give it a new ID.
  */
 
 #ifndef RATSCONFIG_H
 #define RATSCONFIG_H
 
+#include <Arduino.h>
 #include "TeensyEEPROM.h"
 
+// Delay (ms) after the last Set() before changed values are committed
+#define CONFIG_COMMIT_DELAY_MS 2000
+
+// X(id, type, name, default, min, max)
+#define RATS_CONFIG_FIELDS(X) \
+    X(1,  uint16_t, decimate_factor,        1,      1,      65535)  \
+    X(2,  float,    ecu_tempC,              0.0f,   -100,   100)    \
+    X(3,  float,    deploy_velocity,        10.0f,  0.1f,   100)    /* revs/min */ \
+    X(4,  float,    retract_velocity,       10.0f,  0.1f,   100)    /* revs/min */ \
+    X(5,  uint16_t, motion_timeout,         10,     0,      65535)  /* s */ \
+    X(6,  bool,     real_time_mcb,          false,  0,      1)      \
+    X(7,  uint8_t,  paired_ecu,             0,      0,      255)    /* ECU ID to pair with */ \
+    X(9,  float,    full_retract_slow_revs, 5.0f,   0,      100)    /* Full retract: final revs run at the slow velocity */ \
+    X(10, float,    full_retract_slow_vel,  5.0f,   0.1f,   100)    /* Full retract: slow velocity, revs/min */ \
+    X(11, bool,     safety_full_retract,    true,   0,      1)      /* Full retract on entry to safety mode */ \
+    X(12, float,    deploy_acc,             1.0f,   0.01f,  100)    /* Last sent to the MCB; revs/s^2 assumed, unconfirmed */ \
+    X(13, float,    retract_acc,            1.0f,   0.01f,  100)    /* Last sent to the MCB; revs/s^2 assumed, unconfirmed */ \
+    X(15, bool,     clock_governor,         true,   0,      1)      /* Scale the core clock with the mode */ \
+    X(16, float,    profile_bin_m,          10.0f,  1,      1000)   /* Altitude bin for the per-motion profile product, m */ \
+    X(17, bool,     profile_raw,            true,   0,      1)      /* Also accumulate the raw ECU records during motions */ \
+    X(18, bool,     profile_autostart,      false,  0,      1)      /* Start the SD card reel profile at the first FL_MEASURE after power-on */ \
+    X(19, bool,     motion_supervisor,      false,  0,      1)      /* Cancel motions that leave the expected trajectory; replaces ID 14 */ \
+    X(20, bool,     mcb_delta_tm,           false,  0,      1)      /* Delta-encode MCB motion records in MCBREPORT; replaces ID 8 */ \
+    X(21, bool,     profile_ecu_on,         false,  0,      1)      /* Keep the ECU powered during motions, for the profile product */
+
+// Address of the (id, type, value) shadow records used to migrate values
+// across CONFIG_VERSION changes. Must lie beyond the TeensyEEPROM image.
+#define CONFIG_SHADOW_ADDRESS 0x0800
+#define CONFIG_SHADOW_MAGIC 0x5243
+#define CONFIG_SHADOW_MAX_FIELDS 32
+
+// Type codes in the schema and the shadow records
+enum RATSConfigType_t : uint8_t {
+    CFG_BOOL = 1,
+    CFG_U8 = 2,
+    CFG_U16 = 3,
+    CFG_FLOAT = 4,
+};
+
+template <typename T> struct RATSConfigTypeOf;
+template <> struct RATSConfigTypeOf<bool> { static const RATSConfigType_t code = CFG_BOOL; };
+template <> struct RATSConfigTypeOf<uint8_t> { static const RATSConfigType_t code = CFG_U8; };
+template <> struct RATSConfigTypeOf<uint16_t> { static const RATSConfigType_t code = CFG_U16; };
+template <> struct RATSConfigTypeOf<float> { static const RATSConfigType_t code = CFG_FLOAT; };
+
+struct RATSConfigField_t {
+    uint8_t id;
+    RATSConfigType_t type;
+    const char* name;
+    uint8_t offset;         // In RATSConfigValues_t
+    float min;
+    float max;
+};
+
+// The RAM snapshot of all configuration values
+struct RATSConfigValues_t {
+#define RATS_CONFIG_VALUE(id, type, name, dflt, min, max) type name;
+    RATS_CONFIG_FIELDS(RATS_CONFIG_VALUE)
+#undef RATS_CONFIG_VALUE
+};
+
 class RATSConfigs : public TeensyEEPROM {
 private:
     void RegisterAll();
 
+    // The EEPROM copies, registered in RATS_CONFIG_FIELDS order
+#define RATS_CONFIG_EEPROM(id, type, name, dflt, min, max) EEPROMData<type> name##_eeprom;
+    RATS_CONFIG_FIELDS(RATS_CONFIG_EEPROM)
+#undef RATS_CONFIG_EEPROM
+
+    // The snapshot that is read, and the values last committed to EEPROM
+    RATSConfigValues_t snapshot;
+    RATSConfigValues_t committed_snapshot;
+    uint32_t snapshot_crc;
+    bool dirty = false;
+    uint32_t last_set_ms = 0;
+
+    uint32_t SnapshotCRC() const;
+    // Reseal the snapshot after a change and schedule the commit
+    void MarkChanged();
+    // Reload both snapshots from EEPROM
+    void Refresh();
+
+    // Write the current values to the shadow records
+    void WriteShadow();
+    // Carry compatible shadow values into the snapshot; returns the number kept
+    uint8_t Migrate();
+    uint8_t migrated_count = 0;
+
+    // Keeps Set()'s value parameter from taking part in type deduction
+    template <typename T> struct Identity { typedef T type; };
+
 public:
     RATSConfigs();
 
     // constants, manually change version number here to force update
-    static const uint16_t CONFIG_VERSION = 0x000C;
+    static const uint16_t CONFIG_VERSION = 0x0015;
     static const uint16_t BASE_ADDRESS = 0x0000;
 
+    // Load EEPROM and the snapshot. Returns false if the version changed and
+    // the defaults were loaded; compatible values have then been migrated.
+    bool Initialize();
+    // Values carried over by the last Initialize()
+    uint8_t MigratedCount() const { return migrated_count; }
+
+    // ---------------------- Schema ----------------------
+    static const RATSConfigField_t SCHEMA[];
+    static const uint8_t NUM_FIELDS;
+    // nullptr if the ID is unknown
+    static const RATSConfigField_t* FindField(uint8_t id);
+
+    // Generic access by ID, with all types carried as float (exact for the
+    // integer types used here). GetByID returns false for an unknown ID;
+    // SetByID also returns false, and changes nothing, if the value is out of
+    // range. Note that SetByID only changes the stored value; values that are
+    // also sent elsewhere (e.g. the MCB accelerations) still need their TC.
+    bool GetByID(uint8_t id, float& value) const;
+    bool SetByID(uint8_t id, float value);
+
     // ------------------ Configurations ------------------
-    EEPROMData<uint16_t> decimate_factor;
-    EEPROMData<float> ecu_tempC;
-    EEPROMData<float> deploy_velocity;   // revs/min
-    EEPROMData<float> retract_velocity;  // revs/min
-    EEPROMData<uint16_t> motion_timeout;
-    EEPROMData<bool> real_time_mcb;
-    EEPROMData<uint8_t> paired_ecu;     // ECU ID to pair with
+    const RATSConfigValues_t& Values() const { return snapshot; }
+
+    // Change a value, e.g. Set(&RATSConfigValues_t::deploy_velocity, 12.0f).
+    // The EEPROM commit happens later, in Service() or Flush().
+    template <typename T>
+    void Set(T RATSConfigValues_t::* field, typename Identity<T>::type value)
+    {
+        snapshot.*field = value;
+        MarkChanged();
+    }
 
+    // Commit changed values once they have settled. Returns true if it did work.
+    bool Service();
+    // Commit changed values now, e.g. before reading back the EEPROM.
+    void Flush();
+    // Number of EEPROM value writes since boot
+    uint32_t CommitCount() const { return commit_count; }
+
+private:
+    uint32_t commit_count = 0;
 };
 
 #endif /* RATSCONFIG_H */
\ No newline at end of file
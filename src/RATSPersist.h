@@ -0,0 +1,182 @@
+#ifndef RATS_PERSIST_H
+#define RATS_PERSIST_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "ECUReport.h"
+#include "CRC32.h"
+
+// Keep in-progress accumulation data in RAM that survives a watchdog reset
+// or a hard fault.
+//
+// The image lives in DMAMEM (OCRAM), which the Teensy startup code does not
+// clear, so its contents are still present after a non-power-cycle reset.
+// The ECU records and the MCB TM buffer each carry a running CRC of their
+// used part, extended by the bytes each update appends, and a header CRC
+// covers the scalars and both running CRCs. Every update bumps the
+// generation counter and flushes the data cache for the header and the
+// bytes it changed, so that the RAM copy is complete even if the CPU resets
+// before the cache would have been evicted. An update costs time in
+// proportion to what it adds, not to what the image holds. After a reset,
+// Recover() accepts the image only if the magic, layout size and all three
+// CRCs match; random power-up contents are rejected.
+//
+// Usage:
+// 1. Define one Image_t with DMAMEM at file scope and pass it to the constructor.
+// 2. Call Recover() once at setup, before anything else touches the image.
+//    If it returns true, use the accessors to restore or flush the data.
+// 3. Call Reset() to start a fresh image.
+// 4. Call UpdateState() and the Save*() functions whenever the mirrored data changes.
+template <size_t N_ECU_REPORTS, size_t MCB_TM_BYTES>
+class RATSPersist
+{
+public:
+    // Scalar state that is mirrored alongside the buffers.
+    struct State_t
+    {
+        float reel_pos;             // Last reel position (revs)
+        uint32_t total_lora_count;  // LoRa messages received since boot
+        uint16_t mcb_tm_counter;    // MCB binary messages in the current motion
+    };
+
+    struct Image_t
+    {
+        uint32_t magic;
+        uint32_t image_size;        // sizeof(Image_t), catches layout changes between builds
+        uint32_t generation;        // Incremented on every update
+        uint32_t crc;               // CRC-32 of the fields after this one, up to ecu_records
+        uint32_t ecu_crc;           // Running CRC-32 (not complemented) of the used ECU records
+        uint32_t mcb_crc;           // Running CRC-32 (not complemented) of the used MCB TM bytes
+        State_t state;
+        uint16_t num_ecu_records;
+        uint16_t mcb_tm_len;
+        ECUReportBytes_t ecu_records[N_ECU_REPORTS];
+        uint8_t mcb_tm[MCB_TM_BYTES];
+    };
+
+    explicit RATSPersist(Image_t& image) : _image(image) { };
+
+    // Validate the image left by the previous boot. Returns true if it is
+    // intact; the accessors then describe what it holds.
+    bool Recover()
+    {
+        if (_image.magic != PERSIST_MAGIC || _image.image_size != sizeof(Image_t)) {
+            return false;
+        }
+        if (_image.num_ecu_records > N_ECU_REPORTS || _image.mcb_tm_len > MCB_TM_BYTES) {
+            return false;
+        }
+        if (_image.crc != headerCRC()) {
+            return false;
+        }
+        if (_image.ecu_crc != CRC32Update(CRC_INIT, (const uint8_t*)_image.ecu_records,
+                                          _image.num_ecu_records * sizeof(ECUReportBytes_t))) {
+            return false;
+        }
+        return _image.mcb_crc == CRC32Update(CRC_INIT, _image.mcb_tm, _image.mcb_tm_len);
+    }
+
+    // Discard the image contents, keeping the generation count running.
+    void Reset()
+    {
+        uint32_t generation = (_image.magic == PERSIST_MAGIC) ? _image.generation : 0;
+        memset(&_image, 0, sizeof(Image_t));
+        _image.magic = PERSIST_MAGIC;
+        _image.image_size = sizeof(Image_t);
+        _image.generation = generation;
+        _image.ecu_crc = CRC_INIT;
+        _image.mcb_crc = CRC_INIT;
+        seal(&_image, sizeof(Image_t));
+    }
+
+    const State_t& state() const { return _image.state; }
+    uint32_t generation() const { return _image.generation; }
+    uint16_t numECURecords() const { return _image.num_ecu_records; }
+    const ECUReportBytes_t& ecuRecord(uint16_t i) const { return _image.ecu_records[i]; }
+    uint16_t mcbTMLength() const { return _image.mcb_tm_len; }
+    const uint8_t* mcbTM() const { return _image.mcb_tm; }
+
+    // Update the mirrored scalar state. It is sealed by the next Save*() or
+    // ClearECURecords() call, which always follows a state change closely.
+    void UpdateState(const State_t& state)
+    {
+        _image.state = state;
+    }
+
+    // Mirror the record at index, which the report has just accepted.
+    // Records are normally appended; any other index re-checksums them all.
+    void SaveECURecord(uint16_t index, const ECUReportBytes_t& record)
+    {
+        if (index >= N_ECU_REPORTS) {
+            return;
+        }
+        _image.ecu_records[index] = record;
+        if (index == _image.num_ecu_records) {
+            _image.ecu_crc = CRC32Update(_image.ecu_crc, record.data(), sizeof(ECUReportBytes_t));
+        } else {
+            _image.ecu_crc = CRC32Update(CRC_INIT, (const uint8_t*)_image.ecu_records,
+                                         (index + 1) * sizeof(ECUReportBytes_t));
+        }
+        _image.num_ecu_records = index + 1;
+        seal(&_image.ecu_records[index], sizeof(ECUReportBytes_t));
+    }
+
+    // The report was sent and reset.
+    void ClearECURecords()
+    {
+        _image.num_ecu_records = 0;
+        _image.ecu_crc = CRC_INIT;
+        seal(nullptr, 0);
+    }
+
+    // Mirror the used part of the MCB TM buffer, of which the first from
+    // bytes are unchanged since the last call: only the rest is copied and
+    // checksummed. from = 0 saves the whole buffer.
+    void SaveMCBTM(const uint8_t* buf, uint16_t len, uint16_t from = 0)
+    {
+        if (len > MCB_TM_BYTES) {
+            len = MCB_TM_BYTES;
+        }
+        if (from > _image.mcb_tm_len) {
+            from = _image.mcb_tm_len;
+        }
+        if (from > len) {
+            from = len;
+        }
+        memcpy(_image.mcb_tm + from, buf + from, len - from);
+        if (from == _image.mcb_tm_len) {
+            _image.mcb_crc = CRC32Update(_image.mcb_crc, _image.mcb_tm + from, len - from);
+        } else {
+            _image.mcb_crc = CRC32Update(CRC_INIT, _image.mcb_tm, len);
+        }
+        _image.mcb_tm_len = len;
+        seal(_image.mcb_tm + from, len - from);
+    }
+
+protected:
+    static const uint32_t PERSIST_MAGIC = 0x52415453; // "RATS"
+    static const uint32_t CRC_INIT = 0xFFFFFFFF;
+
+    // Re-checksum the header and flush it, with the changed bytes at data
+    void seal(const void* data, size_t len)
+    {
+        _image.generation++;
+        _image.crc = headerCRC();
+        arm_dcache_flush(&_image, offsetof(Image_t, ecu_records));
+        if (len) {
+            arm_dcache_flush((void*)data, len);
+        }
+    }
+
+    // The scalars and the running CRCs of the buffers
+    uint32_t headerCRC() const
+    {
+        const uint8_t* start = (const uint8_t*)&_image.ecu_crc;
+        const uint8_t* end = (const uint8_t*)&_image.ecu_records;
+        return ~CRC32Update(CRC_INIT, start, end - start);
+    }
+
+    Image_t& _image;
+};
+
+#endif // RATS_PERSIST_H
@@ -10,6 +10,11 @@
 #include "etl/array.h"
 #include "etl/bit_stream.h"
 
+// Largest encoding of one receive time in the time column, and the escape
+// code that introduces it; see encodeTimeColumn().
+#define RATS_TIME_RECORD_MAX_BYTES 6
+#define RATS_TIME_ESCAPE 0x7FFF
+
 #ifndef DIV_ROUND_UP
 // Rounding up #define for CPP math
 #define DIV_ROUND_UP(Numerator, Denominator) (((Numerator) + (Denominator) - 1) / (Denominator))
@@ -24,7 +29,7 @@
 // Usage:
 // 1. Create an instance of RATSReport with the max number of ECU reports.
 // 2. Iterate as needed:
-//    Call addECUReport() to add ECU reports.
+//    Call addECUReport() to add ECU reports, with their receive times.
 // 3. Call fillReportHeader() to set the header values.
 // 4. Call getReportBytes() to fetch the TM binary payload.
 // 5. Call initReport() to reset the report for the next collection.
@@ -44,7 +49,7 @@ protected:
     // 6. Update RATSReportPrint() to print the new fields (scaled).
 
     // The RATS report header revision. Increment this whenever the header structure is modified.
-#define RATS_REPORT_REV 4
+#define RATS_REPORT_REV 6
 
     // The RATS report header structure.
     // The type of each field will be the next larger unsigned type that can hold the required number of bits.
@@ -69,12 +74,35 @@ protected:
         int32_t  gps_lon :         32;       // GPS Longitude*1e6 (degrees*1e6)
         uint16_t gps_alt:          16;       // GPS Altitude (meters)
         uint16_t reel_revs:        14;       // (-Reel revolutions+100)*10 (0-16383 : -100.0 revs to +1638.3 revs)    
+        uint8_t recovered :         1;       // The ECU records were recovered after a reset, not collected by this boot.
+        uint32_t collect_epoch :   32;       // Epoch time in seconds when the first ECU record was received.
+        uint16_t time_col_bytes :  11;       // The size of the receive time column after the ECU records.
     };
 
 //    You can use the copilot to create this sum by prompting: "sum of bitfield sizes in RATSReportHeader_t".
-#define RATS_REPORT_HEADER_SIZE_BITS (4 + 16 + 32 + 8 + 8 + 10 + 9 + 1 + 13 + 11 + 10 + 10 + 11 + 32 + 32 + 16 + 14)
+#define RATS_REPORT_HEADER_SIZE_BITS (4 + 16 + 32 + 8 + 8 + 10 + 9 + 1 + 13 + 11 + 10 + 10 + 11 + 32 + 32 + 16 + 14 + 1 + 32 + 11)
 #define RATS_REPORT_HEADER_SIZE_BYTES DIV_ROUND_UP(RATS_REPORT_HEADER_SIZE_BITS, 8)
 
+    // The header describes its own layout; make sure the values fit their fields.
+    // The field order, bit offsets and a reference vector are in docs/TM_specs.md.
+    static_assert(RATS_REPORT_REV < (1 << 4), "RATS_REPORT_REV must fit the 4-bit version field");
+    static_assert(RATS_REPORT_HEADER_SIZE_BYTES < (1 << 8), "Header size must fit header_size_bytes");
+    static_assert(N_ECU_REPORTS < (1 << 10), "N_ECU_REPORTS must fit num_ecu_records");
+    static_assert(ECU_DATA_REPORT_SIZE_BYTES < (1 << 9), "ECU record size must fit ecu_size_bytes");
+    static_assert(ECU_DATA_REPORT_SIZE_BYTES <= ECU_REPORT_SIZE_BYTES, "ECU data record is copied from ECUReportBytes_t");
+    static_assert(N_ECU_REPORTS * RATS_TIME_RECORD_MAX_BYTES < (1 << 11), "Time column must fit time_col_bytes");
+
+    // Truncate a scaled value into an unsigned field of the given width,
+    // saturating at 0 and the field maximum rather than wrapping.
+    static uint32_t scaledField(double scaled, uint8_t bits)
+    {
+        const double max = (double)((1UL << bits) - 1);
+        if (!(scaled > 0.0)) {
+            return 0;
+        }
+        return (scaled >= max) ? (uint32_t)max : (uint32_t)scaled;
+    }
+
     // Serialize the RATS report into the header bytes.
     // This should be called before sending the report.
     void serializeHeader()
@@ -103,10 +131,56 @@ protected:
         writer.write_unchecked(_header.gps_lon, 32);
         writer.write_unchecked(_header.gps_alt, 16);
         writer.write_unchecked(_header.reel_revs, 14);
+        writer.write_unchecked(_header.recovered, 1);
+        writer.write_unchecked(_header.collect_epoch, 32);
+        writer.write_unchecked(_header.time_col_bytes, 11);
     };
 
+    // Encode the receive times of the ECU records, as offsets in ms from
+    // collect_epoch, into out. Each record holds the change in the interval
+    // since the previous record (delta-of-delta), zigzag coded so that small
+    // negative changes stay small:
+    //   0zzzzzzz           change of -64..63 ms
+    //   1zzzzzzz zzzzzzzz  change of -16383..16383 ms
+    //   FF FF tttttttt     larger changes: escape, then the 32-bit offset
+    // Records arriving at a steady rate therefore cost one byte each.
+    size_t encodeTimeColumn(uint8_t* out) const
+    {
+        size_t n = 0;
+        uint32_t prev_t = 0;
+        int32_t prev_delta = 0;
+        for (size_t i = 0; i < _header.num_ecu_records; i++)
+        {
+            uint32_t t = _rx_ms[i];
+            int32_t delta = (int32_t)(t - prev_t);
+            int32_t dd = delta - prev_delta;
+            uint32_t z = ((uint32_t)dd << 1) ^ (uint32_t)(dd >> 31);
+            if (z < 0x80)
+            {
+                out[n++] = (uint8_t)z;
+            }
+            else if (z < RATS_TIME_ESCAPE)
+            {
+                out[n++] = (uint8_t)(0x80 | (z >> 8));
+                out[n++] = (uint8_t)z;
+            }
+            else
+            {
+                out[n++] = 0xFF;
+                out[n++] = 0xFF;
+                out[n++] = (uint8_t)(t >> 24);
+                out[n++] = (uint8_t)(t >> 16);
+                out[n++] = (uint8_t)(t >> 8);
+                out[n++] = (uint8_t)t;
+            }
+            prev_t = t;
+            prev_delta = delta;
+        }
+        return n;
+    }
+
 public:
-    void fillReportHeader(double lora_rssi, double lora_snr, double inst_imon_mA, uint16_t rats_id, uint8_t paired_ecu, float zephyr_lat, float zephyr_lon, float zephyr_alt, float reel_revs)
+    void fillReportHeader(double lora_rssi, double lora_snr, double inst_imon_mA, uint16_t rats_id, uint8_t paired_ecu, float zephyr_lat, float zephyr_lon, float zephyr_alt, float reel_revs, bool recovered = false)
     {
         // *** Modify this function whenever the RATSReportHeader_t struct is modified ***
 
@@ -114,15 +188,17 @@ public:
         _header.epoch = (uint32_t)time(nullptr);
         _header.paired_ecu = paired_ecu;
         _header.ecu_pwr_on = digitalRead(ECU_PWR_EN);
-        _header.v56 = 1000 * analogRead(V56_MON) * (3.3 / 1024.0) * (R8 + R9) / R8;
-        _header.cpu_temp = (tempmonGetTemp() + 100.0) * 10;
-        _header.lora_rssi = (lora_rssi + 100.0) * 10;
-        _header.lora_snr = (lora_snr + 70) * 10;
-        _header.inst_imon = (inst_imon_mA) * 10;
+        _header.v56 = scaledField(100 * analogRead(V56_MON) * (3.3 / 1024.0) * (R8 + R9) / R8, 13);
+        _header.cpu_temp = scaledField((tempmonGetTemp() + 100.0) * 10, 11);
+        _header.lora_rssi = scaledField((lora_rssi + 100.0) * 10, 10);
+        _header.lora_snr = scaledField((lora_snr + 70) * 10, 10);
+        _header.inst_imon = scaledField((inst_imon_mA) * 10, 11);
         _header.gps_lat = (int32_t)(zephyr_lat * 1e6);
         _header.gps_lon = (int32_t)(zephyr_lon * 1e6);
-        _header.gps_alt = (uint16_t)(zephyr_alt);
-        _header.reel_revs = (uint16_t)((-reel_revs + 100.0) * 10);
+        _header.gps_alt = scaledField(zephyr_alt, 16);
+        _header.reel_revs = scaledField((-reel_revs + 100.0) * 10, 14);
+        _header.recovered = recovered ? 1 : 0;
+        // collect_epoch is set by the first addECUReport()
     };
 
     void print(bool print_bin)
@@ -248,6 +324,24 @@ public:
         if (print_bin)            binPrint(_header.reel_revs, 14);
         SerialUSB.print(String((_header.reel_revs / 10.0) - 100.0) + " revs");
         SerialUSB.println();
+
+        // Recovered after reset
+        SerialUSB.print("recovered: ");
+        if (print_bin)            binPrint(_header.recovered, 1);
+        SerialUSB.print(String(_header.recovered));
+        SerialUSB.println();
+
+        // Collection start
+        SerialUSB.print("collect_epoch: ");
+        if (print_bin)            binPrint(_header.collect_epoch, 32);
+        SerialUSB.print(String(_header.collect_epoch) + "s");
+        SerialUSB.println();
+
+        // Receive time column size
+        SerialUSB.print("time_col_bytes: ");
+        if (print_bin)            binPrint(_header.time_col_bytes, 11);
+        SerialUSB.print(String(_header.time_col_bytes));
+        SerialUSB.println();
     };
 
     // Constructor to initialize the RATS report header with the number of ECU reports.
@@ -256,11 +350,19 @@ public:
         initReport(0, 0);
     };
 
-    void addECUReport(const ECUReportBytes_t &ecu_report_bytes)
+    // Add an ECU record, received at rx_ms (millis()). The first record of a
+    // collection sets collect_epoch; later ones are timed relative to it.
+    void addECUReport(const ECUReportBytes_t &ecu_report_bytes, uint32_t rx_ms)
     {
         if (_header.num_ecu_records < N_ECU_REPORTS)
         {
+            if (_header.num_ecu_records == 0)
+            {
+                _header.collect_epoch = (uint32_t)time(nullptr);
+                _collect_start_ms = rx_ms;
+            }
             _ecu_reports[_header.num_ecu_records] = ecu_report_bytes;
+            _rx_ms[_header.num_ecu_records] = rx_ms - _collect_start_ms;
             _header.num_ecu_records++;
         }
         else
@@ -271,8 +373,8 @@ public:
 
     auto& getReportBytes(uint& used_size)
     {
-        // The report bytes include the serialized header and the ECU reports.
-        this->serializeHeader();
+        // The report bytes include the serialized header, the ECU reports
+        // and the receive time column.
 
         // Append the ECU reports to the binary payload after the RATSReport header.
         for (size_t i = 0; i < _header.num_ecu_records; i++)
@@ -283,6 +385,12 @@ public:
             }
         }
         used_size = RATS_REPORT_HEADER_SIZE_BYTES + (_header.num_ecu_records * ECU_DATA_REPORT_SIZE_BYTES);
+
+        // Then the receive times, which the header gives the size of.
+        _header.time_col_bytes = encodeTimeColumn(_report_bytes.data() + used_size);
+        used_size += _header.time_col_bytes;
+
+        this->serializeHeader();
         return _report_bytes;
     };
 
@@ -301,6 +409,9 @@ public:
         _header.header_size_bytes = RATS_REPORT_HEADER_SIZE_BYTES;
         _header.num_ecu_records = 0;
         _header.ecu_size_bytes = ECU_DATA_REPORT_SIZE_BYTES;
+        _header.collect_epoch = 0;
+        _header.time_col_bytes = 0;
+        _collect_start_ms = 0;
         _report_bytes.fill(0);
     }
 
@@ -322,9 +433,14 @@ protected:
     // This will always be sized to hold the max number of ECU reports, but only the first num_ecu_records will be valid.
     ECUReportBytes_t _ecu_reports[N_ECU_REPORTS];
 
+    // Receive time of each ECU record, in ms after the first
+    uint32_t _rx_ms[N_ECU_REPORTS];
+    uint32_t _collect_start_ms;
+
     // The storage for the complete RATS report TM binary payload.
-    // The first bytes are the serialized RATS report header, followed by the ECU reports.
-    etl::array<uint8_t, RATS_REPORT_HEADER_SIZE_BYTES + (N_ECU_REPORTS * ECU_DATA_REPORT_SIZE_BYTES)> _report_bytes;
+    // The first bytes are the serialized RATS report header, followed by the ECU reports
+    // and their receive times.
+    etl::array<uint8_t, RATS_REPORT_HEADER_SIZE_BYTES + (N_ECU_REPORTS * (ECU_DATA_REPORT_SIZE_BYTES + RATS_TIME_RECORD_MAX_BYTES))> _report_bytes;
 };
 
 #endif // RATS_REPORT_H
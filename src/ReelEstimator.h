@@ -0,0 +1,149 @@
+#ifndef REEL_ESTIMATOR_H
+#define REEL_ESTIMATOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Estimate the reel position between MCB motion records.
+//
+// Each position sample from the MCB is stored with its millis() timestamp,
+// and consecutive samples within a motion give a filtered measured velocity.
+// While a motion is commanded the position is extrapolated from the last
+// sample, using the measured velocity once there is one and the commanded
+// velocity before that, and is never extrapolated past the commanded target.
+// When no motion is commanded the last sample is the estimate.
+//
+// Confidence (0-100) describes how much the estimate can be trusted:
+// 100 for a measured sample with the reel stopped, reduced for a position
+// restored from persisted state, and decaying to 0 over MAX_EXTRAPOLATION_MS
+// while extrapolating without new samples.
+//
+// Times are millis() values passed in by the caller, so this header has no
+// Arduino dependencies.
+class ReelEstimator
+{
+public:
+    static const uint32_t MAX_EXTRAPOLATION_MS = 10000;
+    static const uint8_t CONFIDENCE_MEASURED = 100;
+    static const uint8_t CONFIDENCE_RESTORED = 50;
+
+    ReelEstimator() { Reset(0.0f, 0, 0); }
+
+    // Start over from a known position, e.g. one restored after a reset.
+    void Reset(float pos, uint32_t now_ms, uint8_t confidence)
+    {
+        _pos = pos;
+        _sample_ms = now_ms;
+        _base_confidence = confidence;
+        _measured_vel = 0.0f;
+        _vel_valid = false;
+        _commanded_vel = 0.0f;
+        _target = pos;
+        _moving = false;
+    }
+
+    // A motion toward target was commanded at commanded_vel revs/s (signed,
+    // positive towards increasing reel position).
+    void StartMotion(float target, float commanded_vel, uint32_t now_ms)
+    {
+        // Restart extrapolation from the current estimate.
+        _pos = Position(now_ms);
+        _sample_ms = now_ms;
+        _target = target;
+        _commanded_vel = commanded_vel;
+        _vel_valid = false;
+        _moving = true;
+    }
+
+    // The motion finished or was cancelled; hold the current estimate until
+    // the next sample arrives.
+    void StopMotion(uint32_t now_ms)
+    {
+        if (_moving) {
+            _pos = Position(now_ms);
+            _base_confidence = Confidence(now_ms);
+            _sample_ms = now_ms;
+        }
+        _moving = false;
+        _commanded_vel = 0.0f;
+    }
+
+    // A position sample was received from the MCB.
+    void AddSample(float pos, uint32_t now_ms)
+    {
+        uint32_t dt_ms = now_ms - _sample_ms;
+        if (_moving && _base_confidence == CONFIDENCE_MEASURED && dt_ms > 0) {
+            float vel = (pos - _pos) * 1000.0f / (float) dt_ms;
+            _measured_vel = _vel_valid ? (VEL_FILTER * vel + (1.0f - VEL_FILTER) * _measured_vel) : vel;
+            _vel_valid = true;
+        }
+        _pos = pos;
+        _sample_ms = now_ms;
+        _base_confidence = CONFIDENCE_MEASURED;
+    }
+
+    // Estimated position (revs) at now_ms.
+    float Position(uint32_t now_ms) const
+    {
+        if (!_moving) {
+            return _pos;
+        }
+
+        uint32_t age_ms = now_ms - _sample_ms;
+        if (age_ms > MAX_EXTRAPOLATION_MS) {
+            age_ms = MAX_EXTRAPOLATION_MS;
+        }
+        float vel = _vel_valid ? _measured_vel : _commanded_vel;
+        float pos = _pos + vel * (float) age_ms / 1000.0f;
+
+        // Don't run past the target in the direction of travel.
+        if ((vel > 0.0f && pos > _target && _pos <= _target) ||
+            (vel < 0.0f && pos < _target && _pos >= _target)) {
+            pos = _target;
+        }
+        return pos;
+    }
+
+    // Velocity (revs/s) used for the estimate.
+    float Velocity() const
+    {
+        if (!_moving) {
+            return 0.0f;
+        }
+        return _vel_valid ? _measured_vel : _commanded_vel;
+    }
+
+    // Milliseconds since the last sample (or reset).
+    uint32_t Age(uint32_t now_ms) const { return now_ms - _sample_ms; }
+
+    uint8_t Confidence(uint32_t now_ms) const
+    {
+        if (!_moving) {
+            return _base_confidence;
+        }
+        uint32_t age_ms = Age(now_ms);
+        if (age_ms >= MAX_EXTRAPOLATION_MS) {
+            return 0;
+        }
+        return (uint8_t) ((uint32_t) _base_confidence * (MAX_EXTRAPOLATION_MS - age_ms) / MAX_EXTRAPOLATION_MS);
+    }
+
+    bool Moving() const { return _moving; }
+    bool MeasuredVelocityValid() const { return _vel_valid; }
+    float Target() const { return _target; }
+
+protected:
+    // Weight of the newest sample in the velocity filter.
+    static constexpr float VEL_FILTER = 0.5f;
+
+    float _pos;                 // Last sample, or the estimate when the motion state changed
+    uint32_t _sample_ms;        // millis() of _pos
+    uint8_t _base_confidence;   // Confidence of _pos
+    float _measured_vel;        // Filtered velocity from samples (revs/s)
+    bool _vel_valid;            // _measured_vel has at least one pair of samples
+    float _commanded_vel;       // Commanded velocity (revs/s)
+    float _target;              // Commanded end position (revs)
+    bool _moving;               // A motion is commanded
+};
+
+#endif // REEL_ESTIMATOR_H
@@ -0,0 +1,118 @@
+/*
+ *  ReelProfile.cpp
+ *
+ *  Profile script parser and SD loader. See ReelProfile.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ReelProfile.h"
+#include <SD.h>
+
+const char* ReelProfile::StepName(ReelStepType_t type)
+{
+    switch (type) {
+    case STEP_OUT:   return "OUT";
+    case STEP_IN:    return "IN";
+    case STEP_DWELL: return "DWELL";
+    default:         return "?";
+    }
+}
+
+bool ReelProfile::Parse(const char* text, char* err, size_t err_size)
+{
+    char line[64];
+    uint8_t line_num = 0;
+
+    Clear();
+
+    while (*text) {
+        // Copy one line, dropping any comment.
+        size_t n = 0;
+        bool comment = false;
+        while (*text && *text != '\n') {
+            if (*text == '#') {
+                comment = true;
+            }
+            if (!comment && n < sizeof(line) - 1) {
+                line[n++] = *text;
+            }
+            text++;
+        }
+        if (*text == '\n') {
+            text++;
+        }
+        line[n] = '\0';
+        line_num++;
+
+        char keyword[8];
+        float revs = 0.0f;
+        unsigned int secs = 0;
+        int fields = sscanf(line, "%7s", keyword);
+        if (fields != 1) {
+            continue; // blank line
+        }
+
+        if (num_steps >= REEL_PROFILE_MAX_STEPS) {
+            snprintf(err, err_size, "line %u: more than %u steps", line_num, REEL_PROFILE_MAX_STEPS);
+            Clear();
+            return false;
+        }
+
+        ReelStep_t& step = steps[num_steps];
+        bool ok = false;
+        if (0 == strcmp(keyword, "OUT") || 0 == strcmp(keyword, "IN")) {
+            step.type = (keyword[0] == 'O') ? STEP_OUT : STEP_IN;
+            ok = (sscanf(line, "%*s %f %u", &revs, &secs) == 2) && revs > 0.0f;
+        } else if (0 == strcmp(keyword, "DWELL")) {
+            step.type = STEP_DWELL;
+            ok = (sscanf(line, "%*s %u", &secs) == 1) && secs > 0;
+        }
+
+        if (!ok || secs > UINT16_MAX) {
+            snprintf(err, err_size, "line %u: bad step '%s'", line_num, line);
+            Clear();
+            return false;
+        }
+
+        step.revs = revs;
+        step.measure_secs = (uint16_t) secs;
+        num_steps++;
+    }
+
+    if (num_steps == 0) {
+        snprintf(err, err_size, "no steps");
+        return false;
+    }
+
+    return true;
+}
+
+bool ReelProfile::Load(char* err, size_t err_size)
+{
+    static char text[REEL_PROFILE_MAX_BYTES + 1];
+
+    Clear();
+
+    FsFile file = SD.sdfs.open(REEL_PROFILE_FILE, O_READ);
+    if (!file) {
+        snprintf(err, err_size, "unable to open %s", REEL_PROFILE_FILE);
+        return false;
+    }
+    if (file.size() > REEL_PROFILE_MAX_BYTES) {
+        file.close();
+        snprintf(err, err_size, "%s is larger than %u bytes", REEL_PROFILE_FILE, REEL_PROFILE_MAX_BYTES);
+        return false;
+    }
+
+    int n = file.read(text, REEL_PROFILE_MAX_BYTES);
+    file.close();
+    if (n < 0) {
+        snprintf(err, err_size, "unable to read %s", REEL_PROFILE_FILE);
+        return false;
+    }
+    text[n] = '\0';
+
+    return Parse(text, err, err_size);
+}
@@ -0,0 +1,71 @@
+/*
+ *  ReelProfile.h
+ *
+ *  A scripted sequence of reel motions and measurement windows, run
+ *  autonomously in flight mode by Flight_Profile().
+ *
+ *  The script is a text file on the SD card (REEL_PROFILE_FILE), one step
+ *  per line; blank lines and text after '#' are ignored:
+ *
+ *    OUT   <revs> <measure_secs>   reel out, then measure
+ *    IN    <revs> <measure_secs>   reel in, then measure
+ *    DWELL <measure_secs>          measure without moving
+ *
+ *  After each motion the ECU is powered back on and warmed up before the
+ *  measurement window starts, unless profile_ecu_on kept it running. A
+ *  measure_secs of 0 skips the window (and the warmup) so that consecutive
+ *  motions run back to back.
+ *
+ *  The file is loaded at boot, and again by the RATSPROFILELOAD TC (or the
+ *  PROFILELOAD console command). RATSPROFILESTART starts it from FL_MEASURE,
+ *  and RATSPROFILEABORT stops it after the current motion or warmup; with
+ *  profile_autostart set it starts at the first FL_MEASURE after power-on.
+ */
+
+#ifndef REEL_PROFILE_H
+#define REEL_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define REEL_PROFILE_FILE       "PROFILE.TXT"
+#define REEL_PROFILE_MAX_STEPS  16
+// Largest profile file accepted
+#define REEL_PROFILE_MAX_BYTES  1024
+
+enum ReelStepType_t : uint8_t {
+    STEP_OUT,
+    STEP_IN,
+    STEP_DWELL
+};
+
+struct ReelStep_t {
+    ReelStepType_t type;
+    float revs;             // Motion length, unused for STEP_DWELL
+    uint16_t measure_secs;  // Measurement window after the motion
+};
+
+class ReelProfile {
+public:
+    ReelProfile() { Clear(); }
+
+    void Clear() { num_steps = 0; }
+
+    // Parse a profile script. On failure the profile is left empty and err
+    // describes the first bad line.
+    bool Parse(const char* text, char* err, size_t err_size);
+
+    // Read and parse REEL_PROFILE_FILE from the SD card.
+    bool Load(char* err, size_t err_size);
+
+    uint8_t NumSteps() const { return num_steps; }
+    const ReelStep_t& Step(uint8_t i) const { return steps[i]; }
+
+    static const char* StepName(ReelStepType_t type);
+
+private:
+    ReelStep_t steps[REEL_PROFILE_MAX_STEPS];
+    uint8_t num_steps;
+};
+
+#endif /* REEL_PROFILE_H */
@@ -14,6 +14,21 @@ void StratoRATS::SafetyMode()
         inst_substate = SA_SEND_S;
         log_nominal("Entering SA_SEND_S");
         break;
+    case SA_RETRACT:
+        if (FullRetract(false)) {
+            inst_substate = SA_LOOP;
+            log_nominal("Entering SA_LOOP");
+        }
+        // A motion fault sets inst_substate to SA_ERROR
+        break;
+    case SA_ERROR:
+        // The full retract stopped on a motion fault, and FullRetract() has
+        // reported it. It is not retried; the reel stays where it stopped.
+        mcb_reeling_in = false;
+        SendRATSTextTM("Safety retract stopped by motion fault", CRIT);
+        inst_substate = SA_LOOP;
+        log_error("Entering SA_LOOP after motion fault");
+        break;
     case SA_SEND_S:
         log_nominal("Sending safety message");
         ZephyrTXpoke(ZEPHYRTX_S);
@@ -42,6 +57,14 @@ void StratoRATS::SafetyMode()
     case SA_LOOP:
         // nominal ops
         log_debug("SA loop");
+        // Once the safety message is acknowledged, bring the reel in before
+        // a possible termination. Only try once per entry to the mode.
+        if (!safety_retract_attempted && ratsConfigs.Values().safety_full_retract && !mcb_motion_ongoing) {
+            safety_retract_attempted = true;
+            FullRetract(true);
+            inst_substate = SA_RETRACT;
+            log_nominal("Entering SA_RETRACT");
+        }
         break;
     case SA_SHUTDOWN:
         RATS_Shutdown();
@@ -53,6 +76,13 @@ void StratoRATS::SafetyMode()
         break;
     case SA_EXIT:
         // perform cleanup
+        if (mcb_reeling_in) {
+            // Nothing monitors the motion outside of SA_RETRACT
+            mcbComm.TX_ASCII(MCB_CANCEL_MOTION);
+            mcb_reeling_in = false;
+            log_error("Full retract cancelled on SA exit");
+        }
+        safety_retract_attempted = false;
         log_nominal("Exiting SA");
         break;
     default:
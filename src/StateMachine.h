@@ -0,0 +1,231 @@
+#ifndef STATE_MACHINE_H
+#define STATE_MACHINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define SM_NONE 0xFF
+
+// A small hierarchical state machine driven by constant tables.
+//
+// The owner class declares a state table and a transition table (as static
+// members, so that they can name its private member functions) and a
+// StateMachine over them. Each state has an optional parent and, if it is
+// a composite state, the child entered with it. Entry, run and exit actions
+// and transition guards and actions are owner member functions, any of
+// which may be nullptr.
+//
+// Step() runs the active states' run actions, outermost first, then looks
+// for a transition: first from the active leaf, then from each of its
+// ancestors, taking the first in table order whose guard passes. A
+// transition exits the states up to and including its source (so a source
+// that is also its target is re-entered), runs its action, and enters the
+// target and then its initial children. A transition to an ancestor of the
+// source also exits and re-enters the ancestor. One transition is taken per
+// Step().
+//
+// The machine counts the entries to each state and the transitions taken,
+// and accumulates the time spent in each state, so that per-state timing is
+// available without instrumenting the actions.
+template <class Owner, uint8_t N_STATES, uint8_t N_TRANSITIONS>
+class StateMachine
+{
+public:
+    typedef void (Owner::*Action_t)();
+    typedef bool (Owner::*Guard_t)();
+
+    struct State_t {
+        const char* name;
+        uint8_t parent;         // SM_NONE at the top level
+        uint8_t initial;        // Child entered with this state, or SM_NONE
+        Action_t entry;
+        Action_t run;
+        Action_t exit;
+    };
+
+    struct Transition_t {
+        uint8_t from;
+        uint8_t to;
+        Guard_t guard;          // nullptr: always
+        Action_t action;
+    };
+
+    StateMachine(Owner* owner, const State_t* states, const Transition_t* transitions)
+        : _owner(owner), _states(states), _transitions(transitions), _current(SM_NONE)
+    {
+        ResetStats();
+    }
+
+    // Exit any active states and enter state, and its initial children
+    void Start(uint8_t state, uint32_t now_ms)
+    {
+        ExitTo(SM_NONE, now_ms);
+        EnterPath(state, SM_NONE, now_ms);
+    }
+
+    // Run the active states and take at most one transition. Returns true if
+    // a transition was taken.
+    bool Step(uint32_t now_ms)
+    {
+        if (_current == SM_NONE) {
+            return false;
+        }
+
+        RunFrom(_current);
+
+        for (uint8_t s = _current; s != SM_NONE; s = _states[s].parent) {
+            for (uint8_t t = 0; t < N_TRANSITIONS; t++) {
+                const Transition_t& tr = _transitions[t];
+                if (tr.from != s || (tr.guard && !(_owner->*tr.guard)())) {
+                    continue;
+                }
+                Take(t, now_ms);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint8_t Current() const { return _current; }
+    const char* CurrentName() const { return (_current == SM_NONE) ? "-" : _states[_current].name; }
+
+    // True if state is the active leaf or one of its ancestors
+    bool InState(uint8_t state) const { return IsAncestorOrSelf(state, _current); }
+
+    // Statistics
+    void ResetStats()
+    {
+        for (uint8_t i = 0; i < N_STATES; i++) {
+            _entries[i] = 0;
+            _time_ms[i] = 0;
+            _entered_ms[i] = 0;
+        }
+        for (uint8_t i = 0; i < N_TRANSITIONS; i++) {
+            _taken[i] = 0;
+        }
+    }
+    uint16_t Entries(uint8_t state) const { return _entries[state]; }
+    uint16_t Taken(uint8_t transition) const { return _taken[transition]; }
+    // Time in a state over all its entries, including the current one
+    uint32_t TimeIn(uint8_t state, uint32_t now_ms) const
+    {
+        uint32_t t = _time_ms[state];
+        if (InState(state)) {
+            t += now_ms - _entered_ms[state];
+        }
+        return t;
+    }
+
+    // e.g. "ATTEMPT 3.1s/1 CONFIG_SENT 2.0s/1 CONFIRM 1.1s/1" for the states entered
+    int FormatStats(char* buf, size_t size, uint32_t now_ms) const
+    {
+        int n = 0;
+        if (size > 0) {
+            buf[0] = '\0';
+        }
+        for (uint8_t i = 0; i < N_STATES && n >= 0 && (size_t) n < size; i++) {
+            if (_entries[i] == 0) {
+                continue;
+            }
+            n += snprintf(buf + n, size - n, "%s%s %.1fs/%u", n ? " " : "", _states[i].name,
+                          TimeIn(i, now_ms) / 1000.0f, _entries[i]);
+        }
+        return n;
+    }
+
+protected:
+    bool IsAncestorOrSelf(uint8_t ancestor, uint8_t state) const
+    {
+        for (uint8_t s = state; s != SM_NONE; s = _states[s].parent) {
+            if (s == ancestor) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Call(Action_t action)
+    {
+        if (action) {
+            (_owner->*action)();
+        }
+    }
+
+    // Run actions, outermost first
+    void RunFrom(uint8_t state)
+    {
+        if (state == SM_NONE) {
+            return;
+        }
+        RunFrom(_states[state].parent);
+        Call(_states[state].run);
+    }
+
+    // Exit active states, innermost first, up to but not including stop
+    void ExitTo(uint8_t stop, uint32_t now_ms)
+    {
+        while (_current != SM_NONE && _current != stop) {
+            _time_ms[_current] += now_ms - _entered_ms[_current];
+            Call(_states[_current].exit);
+            _current = _states[_current].parent;
+        }
+    }
+
+    // Enter state and its inactive ancestors below keep (outermost first),
+    // then its initial children
+    void EnterPath(uint8_t state, uint8_t keep, uint32_t now_ms)
+    {
+        EnterAncestors(state, keep, now_ms);
+        while (_current != SM_NONE && _states[_current].initial != SM_NONE) {
+            EnterOne(_states[_current].initial, now_ms);
+        }
+    }
+
+    void EnterAncestors(uint8_t state, uint8_t keep, uint32_t now_ms)
+    {
+        if (state == SM_NONE || state == keep) {
+            return;
+        }
+        EnterAncestors(_states[state].parent, keep, now_ms);
+        EnterOne(state, now_ms);
+    }
+
+    void EnterOne(uint8_t state, uint32_t now_ms)
+    {
+        _current = state;
+        _entries[state]++;
+        _entered_ms[state] = now_ms;
+        Call(_states[state].entry);
+    }
+
+    void Take(uint8_t t, uint32_t now_ms)
+    {
+        const Transition_t& tr = _transitions[t];
+
+        // The innermost ancestor of the source that also contains the target
+        // stays active; everything below it, including the source, is exited.
+        // It must be a proper ancestor of the target, so that a target that
+        // is an ancestor of the source is exited and entered again.
+        uint8_t keep = _states[tr.from].parent;
+        while (keep != SM_NONE && !IsAncestorOrSelf(keep, _states[tr.to].parent)) {
+            keep = _states[keep].parent;
+        }
+
+        ExitTo(keep, now_ms);
+        Call(tr.action);
+        _taken[t]++;
+        EnterPath(tr.to, keep, now_ms);
+    }
+
+    Owner* _owner;
+    const State_t* _states;
+    const Transition_t* _transitions;
+    uint8_t _current;
+    uint16_t _entries[N_STATES];
+    uint32_t _time_ms[N_STATES];
+    uint32_t _entered_ms[N_STATES];
+    uint16_t _taken[N_TRANSITIONS];
+};
+
+#endif // STATE_MACHINE_H
@@ -2,9 +2,18 @@
 #include <SPI.h>
 #include <TeensyID.h>
 
+// The persisted image must not be cleared by the startup code, so it lives
+// in DMAMEM rather than in the StratoRATS object.
+DMAMEM static RATSPersist_t::Image_t persist_image;
+
+// The MCB TM file staging ring, 32 KB, kept out of DTCM
+DMAMEM static TMFileWriter::Buffers_t mcb_tm_file_buffers;
+
 StratoRATS::StratoRATS()
     : StratoCore(&ZEPHYR_SERIAL, INSTRUMENT)
     , mcbComm(&MCB_SERIAL)
+    , mcbTMFile("MCB")
+    , persist(persist_image)
 {
 }
 
@@ -32,10 +41,6 @@ void StratoRATS::InstrumentSetup()
     snprintf(rats_id_str, sizeof(rats_id_str), "RATS ID: %u", rats_id);
     log_nominal(rats_id_str);
 
-    // Get the paired_ecu from flash config
-    paired_ecu = ratsConfigs.paired_ecu.Read();
-    log_nominal((String("Paired ECU ID: ") + String(paired_ecu)).c_str());
-
     // LoRa initialization
     if (!ECULoRaInit(
         LORA_FOLLOWER, 
@@ -59,17 +64,100 @@ void StratoRATS::InstrumentSetup()
     }; 
 
     if (!ratsConfigs.Initialize()) {
-        SendRATSTextTM("Error loading from EEPROM! Reconfigured", WARN);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Error loading from EEPROM! Reconfigured, %u of %u values migrated",
+                 ratsConfigs.MigratedCount(), RATSConfigs::NUM_FIELDS);
+        SendRATSTextTM(log_array, WARN);
     }
+    log_nominal((String("Paired ECU ID: ") + String(ratsConfigs.Values().paired_ecu)).c_str());
+
+    clock_gov.Begin(millis());
+    clock_gov.Enable(ratsConfigs.Values().clock_governor, millis());
 
     mcbComm.AssignBinaryRXBuffer(binary_mcb, MCB_BINARY_BUFFER_SIZE);
 
+    // StratoCore mounted the card in InitializeCore()
+    if (!mcbTMFile.Begin(SD.sdfs, mcb_tm_file_buffers)) {
+        SendRATSTextTM("WARN: MCB TM SD file unavailable", WARN);
+    }
+
+    // Load the reel profile, if there is one on the card, so that it can be
+    // started without a load command.
+    String profile_msg;
+    if (ProfileLoadCommand(profile_msg) == FINE) {
+        log_nominal((String("Reel profile loaded: ") + profile_msg).c_str());
+    } else {
+        log_nominal((String("No reel profile: ") + profile_msg).c_str());
+    }
+
+    // The MCB TM segment buffer always holds a segment header.
+    StartMCBSegment();
+
+    // Restore anything that was being accumulated when the previous boot reset.
+    RecoverPersistedData();
+}
+
+void StratoRATS::RecoverPersistedData()
+{
+    if (!persist.Recover()) {
+        log_nominal("No persisted data to recover");
+        persist.Reset();
+        PersistState();
+        return;
+    }
+
+    // Persisted data means this boot followed a reset, which may have been
+    // part way through the profile, so do not autostart it again.
+    profile_autostart_done = true;
+
+    const RATSPersist_t::State_t& state = persist.state();
+    reel_pos = state.reel_pos;
+    reel_est.Reset(reel_pos, millis(), ReelEstimator::CONFIDENCE_RESTORED);
+    total_lora_count = state.total_lora_count;
+    mcb_tm_counter = state.mcb_tm_counter;
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Recovered gen %lu: %u ECU recs, %u MCB bytes, reel %.1f",
+        (unsigned long) persist.generation(), persist.numECURecords(), persist.mcbTMLength(), reel_pos);
+    log_error(log_array);
+
+    // Anything after the segment header is motion data.
+    if (persist.mcbTMLength() > MCB_SEGMENT_HEADER_SIZE) {
+        memcpy(MCB_TM_buffer, persist.mcbTM(), persist.mcbTMLength());
+        MCB_TM_buffer_len = persist.mcbTMLength();
+        MCB_TM_buffer[6] |= MCB_SEGMENT_RECOVERED;
+        SendMCBTM("MCBREPORT", WARN, "MCB motion data recovered after reset");
+    }
+
+    if (persist.numECURecords()) {
+        rats_report.initReport(rats_id, ratsConfigs.Values().paired_ecu);
+        // The receive times are not persisted: the recovered records all
+        // get the recovery time.
+        uint32_t rx_ms = millis();
+        for (uint16_t i = 0; i < persist.numECURecords(); i++) {
+            rats_report.addECUReport(persist.ecuRecord(i), rx_ms);
+        }
+        SendRATSReportTM(true);
+        last_rats_report = now();
+    }
+
+    persist.Reset();
+    PersistState();
+}
 
+void StratoRATS::PersistState()
+{
+    RATSPersist_t::State_t state;
+    state.reel_pos = reel_pos;
+    state.total_lora_count = total_lora_count;
+    state.mcb_tm_counter = mcb_tm_counter;
+    persist.UpdateState(state);
 }
 
 void StratoRATS::InstrumentLoop()
 {
-    
+    // Loop period, including the wait for the control timer
+    LatencyEnd(LAT_LOOP);
+    LatencyStart(LAT_LOOP);
+
     WatchFlags();
 
     // Insure that the LoRa test tx is only operating in standby mode
@@ -80,6 +168,43 @@ void StratoRATS::InstrumentLoop()
     // Check for incoming LoRa messages
     LoRaRX();
 
+    // Send the profile product when a motion ends
+    ServiceProfile();
+
+    // Commands typed on the debug port
+    ServiceConsole();
+
+    // Follow the mode with the core clock
+    clock_gov.Enable(ratsConfigs.Values().clock_governor, millis());
+    if (clock_gov.Request(ClockPolicy(), millis())) {
+        clock_gov.Format(log_array, LOG_ARRAY_SIZE, millis());
+        log_nominal(log_array);
+    }
+}
+
+ClockLevel_t StratoRATS::ClockPolicy()
+{
+    // Reel motions are supervised sample by sample and the safety retract
+    // is a motion, so it takes precedence over the mode.
+    if (mcb_motion_ongoing) {
+        return CLOCK_HIGH;
+    }
+
+    switch (my_inst_mode) {
+    case MODE_LOWPOWER:
+    case MODE_SAFETY:
+    case MODE_EOF:
+        return CLOCK_LOW;
+    default:
+        return CLOCK_NOMINAL;
+    }
+}
+
+bool StratoRATS::IdleTask()
+{
+    bool did_work = mcbTMFile.Service();
+    did_work |= ratsConfigs.Service();
+    return did_work;
 }
 
 void StratoRATS::LoRaTx(char* ecu_cmd, bool immediate) {
@@ -91,7 +216,7 @@ void StratoRATS::LoRaTx(char* ecu_cmd, bool immediate) {
     payload[0] = 0;
 
     // Set the second byte to paired_ecu
-    payload[1] = static_cast<uint8_t>(paired_ecu);
+    payload[1] = ratsConfigs.Values().paired_ecu;
 
     // Copy the command string into the payload starting at byte 2
     for (size_t i = 0; i < cmd_len && (i + 2) < ECU_LORA_DATA_BUFSIZE; i++) {
@@ -109,7 +234,15 @@ void StratoRATS::LoRaRX()
             total_lora_count = lora_msg.count;
         }
 
-        ECUReportBytes_t payload;
+        // The length comes off the radio: reject anything that won't fit the
+        // report, and zero the tail of short messages so no stale stack
+        // contents reach the report or the deserializer.
+        ECUReportBytes_t payload = {0};
+        if (lora_msg.data_len == 0 || lora_msg.data_len > payload.size()
+            || lora_msg.data_len > sizeof(lora_msg.data)) {
+            LoRaReject();
+            return;
+        }
         for (uint8_t i = 0; i < lora_msg.data_len; i++) {
             payload[i] = lora_msg.data[i];
         }
@@ -125,7 +258,7 @@ void StratoRATS::LoRaRX()
 
             // See if it is one that we are interested in
             uint8_t ecu_id = rev_msg_type_id[2];
-            if (paired_ecu == 0 || ecu_id == paired_ecu) {
+            if (ratsConfigs.Values().paired_ecu == 0 || ecu_id == ratsConfigs.Values().paired_ecu) {
 
                 // It's from our paired ECU (or we accept any ECU)
                 ECU_REPORT_TYPE_t msg_type = static_cast<ECU_REPORT_TYPE_t>(rev_msg_type_id[1]);
@@ -134,8 +267,22 @@ void StratoRATS::LoRaRX()
 
                 // Process based on message type
                 if (msg_type == ECU_REPORT_DATA) { 
-                    // Add the LoRa message to the RATS report.
-                    ratsReportAccumulate(payload);
+                    // A truncated report would go into the RATS report
+                    // zero-filled, as if it had been measured
+                    if (lora_msg.data_len < ECU_DATA_REPORT_SIZE_BYTES) {
+                        LoRaReject();
+                        return;
+                    }
+
+                    // Add the LoRa message to the RATS report, via the
+                    // sending ECU's stream
+                    if (ratsConfigs.Values().paired_ecu != 0) {
+                        ratsReportAccumulate(payload, ecu_streams.Paired(ecu_id));
+                    } else {
+                        ratsReportAccumulate(payload, ecu_streams.Stream(ecu_id));
+                    }
+                    ProfileAddECUReport(ecu_id, payload);
+                    WarmupECUReport();
 
                     if (lora_msg.count % 30 == 0) {
                         // Every 30 messages, log some info about the message
@@ -154,7 +301,11 @@ void StratoRATS::LoRaRX()
                     ecu_report_print(ecu_report);
                     // Create and send a text TM with the raw data
                     String text_data;
-                    for (uint8_t i = 0; i < ecu_report.n_bytes; ++i) {
+                    uint8_t n_bytes = ecu_report.n_bytes;
+                    if (n_bytes > sizeof(ecu_report.raw)) {
+                        n_bytes = sizeof(ecu_report.raw);
+                    }
+                    for (uint8_t i = 0; i < n_bytes; ++i) {
                         text_data += (char)ecu_report.raw[i];
                     }
                     SendRATSTextTM(text_data, FINE);
@@ -164,6 +315,14 @@ void StratoRATS::LoRaRX()
     }
 }
 
+void StratoRATS::LoRaReject()
+{
+    lora_reject_count++;
+    snprintf(log_array, LOG_ARRAY_SIZE, "LoRa message rejected, length %u (%lu rejected)",
+             lora_msg.data_len, (unsigned long) lora_reject_count);
+    log_error(log_array);
+}
+
 void StratoRATS::ActionHandler(uint8_t action)
 {
     // for safety, ensure index doesn't exceed array size
@@ -175,6 +334,7 @@ void StratoRATS::ActionHandler(uint8_t action)
     // set the flag and reset the stale count
     action_flags[action].flag_value = true;
     action_flags[action].stale_count = 0;
+    action_set_ms[action] = millis();
 }
 
 bool StratoRATS::CheckAction(uint8_t action)
@@ -189,16 +349,34 @@ bool StratoRATS::CheckAction(uint8_t action)
     if (action_flags[action].flag_value) {
         action_flags[action].flag_value = false;
         action_flags[action].stale_count = 0;
+        if (IsCommandAction(action)) {
+            latency[LAT_ACTION].Add(millis() - action_set_ms[action]);
+        }
         return true;
     } else {
         return false;
     }
 }
 
+bool StratoRATS::IsCommandAction(uint8_t action)
+{
+    switch (action) {
+    case ACTION_REEL_OUT:
+    case ACTION_REEL_IN:
+    case ACTION_FULL_RETRACT:
+    case ACTION_MOTION_STOP:
+    case ACTION_PROFILE_START:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void StratoRATS::SetAction(uint8_t action)
 {
     action_flags[action].flag_value = true;
     action_flags[action].stale_count = 0;
+    action_set_ms[action] = millis();
 }
 
 void StratoRATS::WatchFlags()
@@ -268,7 +446,14 @@ bool StratoRATS::IsECUPowerEnabled()
     return (digitalRead(ECU_PWR_EN) == HIGH);
 }
 
-void StratoRATS::ratsReportAccumulate(ECUReportBytes_t& ecu_report_bytes) {
+void StratoRATS::ECUMotionPower()
+{
+    if (!ratsConfigs.Values().profile_ecu_on) {
+        ECUPowerControl(false);
+    }
+}
+
+void StratoRATS::ratsReportAccumulate(ECUReportBytes_t& ecu_report_bytes, ECUStream_t& stream) {
     // Must be called with an ecu report of type ECU_REPORT_DATA
 
     // Only STANDBY and FLIGHT accumulate ECU reports. Other modes flush the
@@ -279,17 +464,28 @@ void StratoRATS::ratsReportAccumulate(ECUReportBytes_t& ecu_report_bytes) {
         return;
     }
 
-    // Apply decimation: only accumulate every decimate_factor-th report
-    static uint16_t decimate_count = 0;
-    uint16_t factor = ratsConfigs.decimate_factor.Read();
-    if (++decimate_count < factor ) {
+    // Apply decimation: only accumulate every decimate_factor-th report of
+    // each ECU
+    if (!ecu_streams.Receive(stream, ecu_lora_rssi(), ecu_lora_snr(), ratsConfigs.Values().decimate_factor, millis())) {
+        return;
+    }
+    // During a motion the profile product can stand in for the raw records
+    if (profile_bins.Active() && !ratsConfigs.Values().profile_raw) {
         return;
     }
-    decimate_count = 0;
-    rats_report.addECUReport(ecu_report_bytes);
+    int n_before = rats_report.numECUrecords();
+    rats_report.addECUReport(ecu_report_bytes, millis());
+    if (rats_report.numECUrecords() > n_before) {
+        ecu_streams.Accumulated(stream);
+        PersistState();
+        persist.SaveECURecord(n_before, ecu_report_bytes);
+    }
 }
 
-void StratoRATS::SendRATSReportTM() {
+void StratoRATS::SendRATSReportTM(bool recovered) {
+
+    // Build the report at full speed; the governor drops back afterwards
+    clock_gov.Request(CLOCK_HIGH, millis());
 
     zephyrTX.clearTm();
 
@@ -297,14 +493,18 @@ void StratoRATS::SendRATSReportTM() {
 
     // First
     Message = "RATSREPORT";
-    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(1, recovered ? WARN : FINE);
     zephyrTX.setStateDetails(1, Message);
 
     // Second
     zephyrTX.setStateFlagValue(2, FINE);
-    Message = getStateName(my_inst_mode, inst_substate);
+    Message = recovered ? String("RECOVERED") : getStateName(my_inst_mode, inst_substate);
     Message += ", ECUrecs:" + String(rats_report.numECUrecords());
-    Message += ", Reel:" + String(reel_pos,1);
+    char reel_msg[40];
+    FormatReelEstimate(reel_msg, sizeof(reel_msg));
+    Message += ", " + String(reel_msg);
+    // SD staging backlog (bytes) and slowest sector write (ms)
+    Message += ", SD:" + String(mcbTMFile.Backlog()) + "B/" + String(mcbTMFile.MaxFlushMicros() / 1000) + "ms";
     zephyrTX.setStateDetails(2, Message);
 
     // Third: GPS Position
@@ -320,7 +520,7 @@ void StratoRATS::SendRATSReportTM() {
 
     // Add RATSReport to the TM
 
-    rats_report.fillReportHeader(ecu_lora_rssi(), ecu_lora_snr(), inst_imon_mA, rats_id, paired_ecu, zephyrRX.zephyr_gps.latitude, zephyrRX.zephyr_gps.longitude, zephyrRX.zephyr_gps.altitude, reel_pos);
+    rats_report.fillReportHeader(ecu_lora_rssi(), ecu_lora_snr(), inst_imon_mA, rats_id, ratsConfigs.Values().paired_ecu, zephyrRX.zephyr_gps.latitude, zephyrRX.zephyr_gps.longitude, zephyrRX.zephyr_gps.altitude, ReelPosition(), recovered);
     uint report_size;
     auto report_bytes = rats_report.getReportBytes(report_size);
     // Add the RATSReport to the TM
@@ -332,8 +532,24 @@ void StratoRATS::SendRATSReportTM() {
 
     SerialUSB.print("RATS report bytes: ");
     SerialUSB.println(report_size); 
+    // Last and slowest sector write; short enough for log_array at any values
+    snprintf(log_array, LOG_ARRAY_SIZE, "MCB SD: backlog %luB, flush %lu/%luus, dropped %luB, %lu sectors",
+        (unsigned long) mcbTMFile.Backlog(), (unsigned long) mcbTMFile.LastFlushMicros(),
+        (unsigned long) mcbTMFile.MaxFlushMicros(), (unsigned long) mcbTMFile.DroppedBytes(),
+        (unsigned long) mcbTMFile.SectorsWritten());
+    log_nominal(log_array);
     rats_report.print(false);
-    rats_report.initReport(rats_id, paired_ecu); // Reset the RATS report for the next collection
+
+    // With several ECUs in the report, say what came from each
+    if (ecu_streams.Active() > 1) {
+        ecu_streams.Format(log_array, LOG_ARRAY_SIZE);
+        log_nominal(log_array);
+        SendRATSTextTM(log_array, ecu_streams.Overflowed() ? WARN : FINE);
+    }
+    ecu_streams.Reset();
+
+    rats_report.initReport(rats_id, ratsConfigs.Values().paired_ecu); // Reset the RATS report for the next collection
+    persist.ClearECURecords();
 
 }
 
@@ -375,27 +591,41 @@ bool StratoRATS::StartMCBMotion()
 
     String msg;
 
+    // A one-shot override of the retract velocity, e.g. for the slow phase of a full retract
+    float retract_vel = (retract_velocity_cmd > 0.0f) ? retract_velocity_cmd : ratsConfigs.Values().retract_velocity;
+    retract_velocity_cmd = 0.0f;
+
     switch (mcb_motion) {
+    // Deployed positions are negative: reeling in moves towards zero.
     case MOTION_REEL_IN:
-        success = mcbComm.TX_Reel_In(retract_length, ratsConfigs.retract_velocity.Read());
-        max_reel_seconds = 60 * (retract_length / ratsConfigs.retract_velocity.Read()) + ratsConfigs.motion_timeout.Read();
+        reel_cmd_target = ReelPosition() + retract_length;
+        reel_cmd_vel = retract_vel / 60.0;
+        reel_cmd_acc = ratsConfigs.Values().retract_acc;
+        success = mcbComm.TX_Reel_In(retract_length, retract_vel);
+        max_reel_seconds = 60 * (retract_length / retract_vel) + ratsConfigs.Values().motion_timeout;
         msg = String("Reel in ") + String(retract_length,1) 
             + " revs, timeout " + String(max_reel_seconds) 
-            + "s, velocity " + String(ratsConfigs.retract_velocity.Read(),1);
+            + "s, velocity " + String(retract_vel,1);
         break;
     case MOTION_REEL_OUT:
-        success = mcbComm.TX_Reel_Out(deploy_length, ratsConfigs.deploy_velocity.Read());
-        max_reel_seconds = 60 * (deploy_length / ratsConfigs.deploy_velocity.Read()) + ratsConfigs.motion_timeout.Read();
+        reel_cmd_target = ReelPosition() - deploy_length;
+        reel_cmd_vel = -ratsConfigs.Values().deploy_velocity / 60.0;
+        reel_cmd_acc = ratsConfigs.Values().deploy_acc;
+        success = mcbComm.TX_Reel_Out(deploy_length, ratsConfigs.Values().deploy_velocity);
+        max_reel_seconds = 60 * (deploy_length / ratsConfigs.Values().deploy_velocity) + ratsConfigs.Values().motion_timeout;
         msg = String("Reel out ") + String(deploy_length,1) 
             + " revs, timeout " + String(max_reel_seconds) 
-            + "s, velocity " + String(ratsConfigs.deploy_velocity.Read(),1);
+            + "s, velocity " + String(ratsConfigs.Values().deploy_velocity,1);
         break;
     case MOTION_IN_NO_LW:
-        success = mcbComm.TX_In_No_LW(retract_length, ratsConfigs.retract_velocity.Read());
-        max_reel_seconds = 60 * (retract_length / ratsConfigs.retract_velocity.Read()) + ratsConfigs.motion_timeout.Read();
+        reel_cmd_target = ReelPosition() + retract_length;
+        reel_cmd_vel = retract_vel / 60.0;
+        reel_cmd_acc = ratsConfigs.Values().retract_acc;
+        success = mcbComm.TX_In_No_LW(retract_length, retract_vel);
+        max_reel_seconds = 60 * (retract_length / retract_vel) + ratsConfigs.Values().motion_timeout;
         msg = String("Reel in (no LW) ") + String(retract_length,1) 
             + " revs, timeout " + String(max_reel_seconds) 
-            + "s, velocity " + String(ratsConfigs.retract_velocity.Read(),1);
+            + "s, velocity " + String(retract_vel,1);
         break;
     default:
         mcb_motion = NO_MOTION;
@@ -406,25 +636,173 @@ bool StratoRATS::StartMCBMotion()
     SendRATSTextTM(msg, FINE);
     log_nominal(msg.c_str());
 
+    if (success) {
+        LatencyStart(LAT_MCB_ACK);
+    }
     return success;
 }
+
+void StratoRATS::LatencyStart(LatencyProbe_t probe)
+{
+    // 0 means "not started", so never store it
+    uint32_t now_ms = millis();
+    latency_start_ms[probe] = now_ms ? now_ms : 1;
+}
+
+void StratoRATS::LatencyEnd(LatencyProbe_t probe)
+{
+    if (latency_start_ms[probe]) {
+        latency[probe].Add(millis() - latency_start_ms[probe]);
+        latency_start_ms[probe] = 0;
+    }
+}
+
+void StratoRATS::SendLatencyTM()
+{
+    static const char* const names[NUM_LATENCY_PROBES] = { "TCMOTION", "MCBACK", "ACTION", "GPSTIME", "LOOP" };
+    for (uint8_t i = 0; i < NUM_LATENCY_PROBES; i++) {
+        if (latency[i].Count() == 0) {
+            continue;
+        }
+        latency[i].Format(names[i], log_array, LOG_ARRAY_SIZE);
+        SendRATSTextTM(log_array, FINE);
+    }
+}
+
+void StratoRATS::ProfileAddECUReport(uint8_t ecu_id, ECUReportBytes_t& ecu_report_bytes)
+{
+    if (!profile_bins.Active()) {
+        return;
+    }
+
+    ECUReport_t ecu_report = ecu_report_deserialize(ecu_report_bytes);
+    ProfileSample_t sample;
+    sample.alt_m = ecu_report.gps_valid ? ecu_report.gps_alt : NAN;
+    sample.reel_revs = ReelPosition();
+    sample.value[PV_TSEN_AIRT] = ecu_report.tsen_valid ? ecu_report.tsen_airt : NAN;
+    sample.value[PV_RS41_AIRT] = ecu_report.rs41_valid ? ecu_report.rs41_airt : NAN;
+    sample.value[PV_RS41_HUM] = ecu_report.rs41_valid ? ecu_report.rs41_hum : NAN;
+    sample.value[PV_RS41_PRES] = ecu_report.rs41_valid ? ecu_report.rs41_pres : NAN;
+    profile_bins.Add(ecu_id, sample);
+}
+
+void StratoRATS::ServiceProfile()
+{
+    if (!profile_bins.Active() || mcb_motion_ongoing) {
+        return;
+    }
+    // A NAK to the motion TM resends whatever zephyrTX holds, so wait until
+    // Flight_Reel() is done with it (at most one resend timeout)
+    if (reel_tm_ack_ms && millis() - reel_tm_ack_ms < 1000UL * ZEPHYR_RESEND_TIMEOUT) {
+        return;
+    }
+
+    profile_bins.Stop(ReelPosition());
+    if (profile_bins.Samples()) {
+        SendProfileTM();
+    }
+}
+
+void StratoRATS::SendProfileTM()
+{
+    size_t n_bytes = profile_bins.Serialize(profile_tm, sizeof(profile_tm));
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "%u bins, %u samples, %u bytes", profile_bins.BinsUsed(),
+             profile_bins.Samples(), (unsigned) n_bytes);
+    log_nominal(log_array);
+
+    zephyrTX.clearTm();
+    zephyrTX.setStateDetails(1, "RATSPROFILE");
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateDetails(2, log_array);
+    zephyrTX.setStateFlagValue(2, FINE);
+    zephyrTX.setStateDetails(3, getStateName(my_inst_mode, inst_substate));
+    zephyrTX.setStateFlagValue(3, FINE);
+    zephyrTX.addTm(profile_tm, n_bytes);
+
+    ZephyrTXpoke(ZEPHYRTX_TM);
+    TM_ack_flag = NO_ACK;
+}
+
+void StratoRATS::SuperviseMotion()
+{
+    MotionSupervisorFault_t fault = motion_sup.Check(reel_pos, millis());
+    if (MSUP_OK == fault) {
+        return;
+    }
+
+    // Stop the motor first, then report
+    motion_sup.Stop();
+    mcbComm.TX_ASCII(MCB_CANCEL_MOTION);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Motion fault %u %s: %.2f revs done, %.2f expected",
+             fault, MotionSupervisor::FaultName(fault), motion_sup.LastProgress(), motion_sup.LastExpected());
+    SendMCBTM("MCBREPORT", CRIT, log_array);
+    log_error(log_array);
+
+    // As for an MCB_MOTION_FAULT
+    inst_substate = MODE_ERROR;
+    log_error("Motion supervisor: Entering MODE_ERROR");
+}
+
+void StratoRATS::FormatReelEstimate(char* buf, size_t size)
+{
+    uint32_t now_ms = millis();
+    snprintf(buf, size, "Reel:%.2f %lus %u%%", reel_est.Position(now_ms),
+             (unsigned long) (reel_est.Age(now_ms) / 1000), reel_est.Confidence(now_ms));
+}
+
 void StratoRATS::InitMCBMotionTracking()
 {
+    LatencyEnd(LAT_TC_MOTION);
+    LatencyEnd(LAT_MCB_ACK);
     mcb_motion_ongoing = true;
     reel_motion_start = millis();
+    reel_est.StartMotion(reel_cmd_target, reel_cmd_vel, reel_motion_start);
+    if (ratsConfigs.Values().motion_supervisor) {
+        float start_pos = ReelPosition();
+        motion_sup.Start(start_pos, fabsf(reel_cmd_target - start_pos), (reel_cmd_vel < 0) ? -1 : 1,
+                         fabsf(reel_cmd_vel), reel_cmd_acc, reel_motion_start);
+    } else {
+        motion_sup.Stop();
+    }
+
+    profile_bins.Start((reel_cmd_vel < 0) ? ProfileBinner::PROFILE_DOWN : ProfileBinner::PROFILE_UP,
+                       ratsConfigs.Values().profile_bin_m, now(), ReelPosition());
 
     mcb_tm_counter = 0;
-    //zephyrTX.clearTm(); // empty the TM buffer for incoming MCB motion data
-    MCB_TM_buffer_idx = 0;
-    // Add the start time to the MCB TM Header if not in real-time mode
-    //if (!ratsConfigs.real_time_mcb.Read()) {
-        //zephyrTX.addTm((uint32_t) now()); // as a header, add the current seconds since epoch
-        uint32_t ProfileStartEpoch  = now();
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (ProfileStartEpoch >> 24);
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (ProfileStartEpoch >> 16);
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (ProfileStartEpoch >> 8);
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (ProfileStartEpoch & 0xFF);
-    //}
+    mcb_motion_summary.reset();
+    // Start the first segment of the profile, discarding anything collected
+    // outside of a motion. Every segment of this motion carries the same epoch.
+    mcb_profile_epoch = now();
+    mcb_segment = 0;
+    StartMCBSegment();
+    PersistState();
+    persist.SaveMCBTM(MCB_TM_buffer, MCB_TM_buffer_len);
+}
+
+void StratoRATS::StartMCBSegment()
+{
+    uint8_t* buf = MCB_TM_buffer;
+    buf[0] = (uint8_t) (mcb_profile_epoch >> 24);
+    buf[1] = (uint8_t) (mcb_profile_epoch >> 16);
+    buf[2] = (uint8_t) (mcb_profile_epoch >> 8);
+    buf[3] = (uint8_t) (mcb_profile_epoch & 0xFF);
+    buf[4] = (uint8_t) (mcb_segment >> 8);
+    buf[5] = (uint8_t) (mcb_segment & 0xFF);
+    buf[6] = 0;
+    MCB_TM_buffer_len = MCB_SEGMENT_HEADER_SIZE;
+    mcb_segment++;
+
+    // Each segment must be decodable on its own, so start with a key record.
+    mcb_codec.Reset();
+}
+
+void StratoRATS::SendMCBContinuation(uint8_t flags, const char* message)
+{
+    MCB_TM_buffer[6] |= flags;
+    SendMCBSegment("MCBREPORT", FINE, message);
+    StartMCBSegment();
 }
 
 void StratoRATS::AddMCBTM()
@@ -435,54 +813,83 @@ void StratoRATS::AddMCBTM()
         return;
     }
 
-    // Guard against MCB_TM_buffer overflow. Each record appends a 3-byte
-    // (sync + elapsed-time) header plus MOTION_TM_SIZE data bytes. If the next
-    // record won't fit, flush the accumulated buffer as a partial MCBREPORT;
-    // SendMCBTM() resets MCB_TM_buffer_idx so there is room to continue.
-    const uint16_t mcb_record_size = 3 + MOTION_TM_SIZE;
-    if ((uint32_t)MCB_TM_buffer_idx + mcb_record_size > sizeof(MCB_TM_buffer)) {
-        SendMCBTM("MCBREPORT", FINE, "MCB Partial Packet");
-        log_error("MCB_TM_buffer full, flushed partial packet");
+    // Each record is a sync byte, the elapsed time in tenths of seconds since
+    // the start of the motion, and either the full record (key) or the bytes
+    // that changed since the previous record (delta). See MCBMotionCodec.h.
+    const uint8_t* record = mcbComm.binary_rx.bin_buffer;
+    uint16_t elapsed_time = (uint16_t)((millis() - reel_motion_start) / 100);
+    bool allow_delta = ratsConfigs.Values().mcb_delta_tm;
+    uint8_t encoded[MCBMotionCodec_t::MAX_ENCODED_SIZE];
+    size_t encoded_len = mcb_codec.Encode(record, elapsed_time, allow_delta, encoded);
+
+    // Only the appended bytes need persisting, unless a new segment starts
+    uint16_t persist_from = MCB_TM_buffer_len;
+
+    // If the record won't fit, send the full segment and continue in a new one.
+    // The new segment starts with a key record, so encode again.
+    if ((uint32_t)MCB_TM_buffer_len + encoded_len > MCB_TM_BUFFER_SIZE) {
+        SendMCBContinuation(MCB_SEGMENT_CONTINUED, "MCB Partial Packet");
+        log_nominal("MCB TM segment full, continuing in next segment");
+        encoded_len = mcb_codec.Encode(record, elapsed_time, allow_delta, encoded);
+        persist_from = 0;
     }
 
-    // if not in real-time mode, add the sync and time
-    //if (!ratsConfigs.real_time_mcb.Read()) {
-        // sync byte        
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) 0xA5;
-                
-        // tenths of seconds since start
-        uint16_t elapsed_time = (uint16_t)((millis() - reel_motion_start) / 100);
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (elapsed_time >> 8);
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = (uint8_t) (elapsed_time & 0xFF);
-    //}
-
-    // add each byte of data to the message
-    for (int i = 0; i < MOTION_TM_SIZE; i++) {
-        MCB_TM_buffer[MCB_TM_buffer_idx++] = mcbComm.binary_rx.bin_buffer[i];
-    }
+    memcpy(&MCB_TM_buffer[MCB_TM_buffer_len], encoded, encoded_len);
+    MCB_TM_buffer_len += encoded_len;
+    mcb_codec.Commit(record, encoded);
 
-    // if real-time mode, send the TM packet
-    if (ratsConfigs.real_time_mcb.Read()) {
+    // if real-time mode, each record goes out in its own segment
+    if (ratsConfigs.Values().real_time_mcb) {
         String msg = String("MCB Real-time Packet ") + String(mcb_tm_counter++);
-        
-        // Put the time stamp at the beginning
-        uint32_t ProfileStartEpoch  = now();
-        MCB_TM_buffer[0] = (uint8_t) (ProfileStartEpoch >> 24);
-        MCB_TM_buffer[1] = (uint8_t) (ProfileStartEpoch >> 16);
-        MCB_TM_buffer[2] = (uint8_t) (ProfileStartEpoch >> 8);
-        MCB_TM_buffer[3] = (uint8_t) (ProfileStartEpoch & 0xFF);
-
-        SendMCBTM("MCBREPORT", FINE, msg.c_str());
+        SendMCBContinuation(MCB_SEGMENT_REALTIME, msg.c_str());
         log_nominal(msg.c_str());
+        persist_from = 0;
     }
+
+    PersistState();
+    persist.SaveMCBTM(MCB_TM_buffer, MCB_TM_buffer_len, persist_from);
+}
+
+void StratoRATS::AddMCBFaultRecord()
+{
+    static_assert(sizeof(motion_fault) / sizeof(motion_fault[0]) == MCBMotionCodec_t::FAULT_REGS,
+                  "motion_fault[] does not match the MCB TM fault record");
+
+    uint16_t elapsed_time = (uint16_t)((millis() - reel_motion_start) / 100);
+    uint8_t encoded[MCBMotionCodec_t::FAULT_RECORD_SIZE];
+    size_t encoded_len = MCBMotionCodec_t::EncodeFault(motion_fault, elapsed_time, encoded);
+
+    uint16_t persist_from = MCB_TM_buffer_len;
+    if ((uint32_t)MCB_TM_buffer_len + encoded_len > MCB_TM_BUFFER_SIZE) {
+        SendMCBContinuation(MCB_SEGMENT_CONTINUED, "MCB Partial Packet");
+        persist_from = 0;
+    }
+
+    memcpy(&MCB_TM_buffer[MCB_TM_buffer_len], encoded, encoded_len);
+    MCB_TM_buffer_len += encoded_len;
+    persist.SaveMCBTM(MCB_TM_buffer, MCB_TM_buffer_len, persist_from);
 }
 
 void StratoRATS::SendMCBTM(const char* TMname, StateFlag_t state_flag1, const char * message2)
 {
+    SendMCBSegment(TMname, state_flag1, message2);
+
+    // Outside of a motion, later segments are not part of any profile.
+    if (!mcb_motion_ongoing) {
+        mcb_profile_epoch = 0;
+        mcb_segment = 0;
+    }
+    StartMCBSegment();
 
+    PersistState();
+    persist.SaveMCBTM(MCB_TM_buffer, MCB_TM_buffer_len);
+}
+
+void StratoRATS::SendMCBSegment(const char* TMname, StateFlag_t state_flag1, const char * message2)
+{
     // use only the first flag to report the motion
     zephyrTX.clearTm();
-    zephyrTX.addTm(MCB_TM_buffer, MCB_TM_buffer_idx);
+    zephyrTX.addTm(MCB_TM_buffer, MCB_TM_buffer_len);
 
     zephyrTX.setStateDetails(1, TMname);
     zephyrTX.setStateFlagValue(1, state_flag1);
@@ -490,28 +897,22 @@ void StratoRATS::SendMCBTM(const char* TMname, StateFlag_t state_flag1, const ch
     zephyrTX.setStateDetails(2, message2);
     zephyrTX.setStateFlagValue(2, FINE);
 
-    zephyrTX.setStateDetails(3, (String("Reel: ") + String(reel_pos, 2)).c_str());
+    char reel_msg[40];
+    FormatReelEstimate(reel_msg, sizeof(reel_msg));
+    zephyrTX.setStateDetails(3, reel_msg);
     zephyrTX.setStateFlagValue(3, FINE);
 
     TM_ack_flag = NO_ACK;
     ZephyrTXpoke(ZEPHYRTX_TM);
 
-    //reset the MCB buffer pointer
-    MCB_TM_buffer_idx = 0;
-
-    // HandleMCBAck() calls InitMotionTracking() sets these bytes to now(), but it's not clear
-    // if that function will always be called before the first call to SendMCBTM(), 
-    // so set these bytes here just in case. 
-    // TODO: Track down what is really intended with the MCB tracking. Seems like RACHUTS has 
-    // two different formats the MCB binary payload; was thois really necessary?
-    MCB_TM_buffer[MCB_TM_buffer_idx++] = 0;
-    MCB_TM_buffer[MCB_TM_buffer_idx++] = 0;
-    MCB_TM_buffer[MCB_TM_buffer_idx++] = 0;
-    MCB_TM_buffer[MCB_TM_buffer_idx++] = 0;
-
-    if (!WriteFileTM("MCB")) {
-        log_error("Unable to write MCB TM to SD file");
+    // Stage the payload for the SD card; the card write happens in IdleTask().
+    char label[LOG_ARRAY_SIZE];
+    snprintf(label, sizeof(label), "%s:%s", TMname, message2);
+    if (!mcbTMFile.Write(label, MCB_TM_buffer, MCB_TM_buffer_len)) {
+        log_error("Unable to stage MCB TM for SD file");
     }
+
+    MCB_TM_buffer_len = 0;
 }
 
 void StratoRATS::SendMCBEEPROM()
@@ -535,6 +936,9 @@ void StratoRATS::SendMCBEEPROM()
 
 void StratoRATS::SendRATSEEPROM()
 {
+    // Commit any pending changes so that the EEPROM matches the running values
+    ratsConfigs.Flush();
+
     // create a buffer from the EEPROM (cheat, and use the preallocated MCBComm Binary RX buffer)
     mcbComm.binary_rx.bin_length = ratsConfigs.Bufferize(mcbComm.binary_rx.bin_buffer, MAX_MCB_BINARY);
 
@@ -560,11 +964,31 @@ void StratoRATS::SendRATSEEPROM()
     log_nominal("Sent RATS EEPROM as TM");
 }
 
-uint32_t StratoRATS::lora_count_check(bool reset) {
-    if (reset) {
-        lora_count = total_lora_count;;
-    } 
-    return total_lora_count - lora_count;
+StateFlag_t StratoRATS::ConfigGetCommand(uint8_t id, String& detail)
+{
+    const RATSConfigField_t* field = RATSConfigs::FindField(id);
+    float value = 0;
+    if (!field || !ratsConfigs.GetByID(field->id, value)) {
+        detail = "Unknown config ID";
+        return WARN;
+    }
+    detail = String(field->name) + "=" + String(value, 3) + " [" + String(field->min, 2) + "," + String(field->max, 2) + "]";
+    return FINE;
+}
+
+StateFlag_t StratoRATS::ConfigSetCommand(uint8_t id, float value, String& detail)
+{
+    const RATSConfigField_t* field = RATSConfigs::FindField(id);
+    if (!field) {
+        detail = "Unknown config ID";
+        return WARN;
+    }
+    if (!ratsConfigs.SetByID(field->id, value)) {
+        detail = String(field->name) + " out of range [" + String(field->min, 2) + "," + String(field->max, 2) + "]";
+        return WARN;
+    }
+    detail = String(field->name) + " set";
+    return FINE;
 }
 
 String StratoRATS::getStateName(const uint8_t mode, const uint8_t substate) {
@@ -582,6 +1006,7 @@ String StratoRATS::getStateName(const uint8_t mode, const uint8_t substate) {
         case FL_WARMUP:     return "mode:FLIGHT:FL_WARMUP";
         case FL_MEASURE:    return "mode:FLIGHT:FL_MEASURE";
         case FL_REEL:       return "mode:FLIGHT:FL_REEL";
+        case FL_PROFILE:    return "mode:FLIGHT:FL_PROFILE";
         case FL_ERROR:      return "mode:FLIGHT:FL_ERROR";
         case FL_SHUTDOWN:   return "mode:FLIGHT:FL_SHUTDOWN";
         case FL_EXIT:       return "mode:FLIGHT:FL_EXIT";
@@ -609,6 +1034,8 @@ String StratoRATS::getStateName(const uint8_t mode, const uint8_t substate) {
         case SA_LOOP:       return "mode:SAFETY:SA_LOOP";
         case SA_SEND_S:     return "mode:SAFETY:SA_SEND_S";
         case SA_ACK_WAIT:   return "mode:SAFETY:SA_ACK_WAIT";
+        case SA_RETRACT:    return "mode:SAFETY:SA_RETRACT";
+        case SA_ERROR:      return "mode:SAFETY:SA_ERROR";
         case SA_SHUTDOWN:   return "mode:SAFETY:SA_SHUTDOWN";
         case SA_EXIT:       return "mode:SAFETY:SA_EXIT";
         }
@@ -644,6 +1071,6 @@ void StratoRATS::ZephyrTXpoke(ZephyrTXMsgType_t msg_type)
 void StratoRATS::InitializeReelPosition() {
     // Do a tiny tiny reel motion so that we get an MCB message, which will
     // initialize the reel position.
-    bool success = mcbComm.TX_Reel_Out(0.001, ratsConfigs.deploy_velocity.Read());
+    bool success = mcbComm.TX_Reel_Out(0.001, ratsConfigs.Values().deploy_velocity);
     log_nominal((String("Initial Reel Out Command Sent: ") + (success ? "Success" : "Failure")).c_str());
 }
@@ -9,6 +9,19 @@
 #include "ECULoRa.h"
 #include "ECUReport.h"
 #include "RATSReport.h"
+#include "TMFileWriter.h"
+#include "RATSPersist.h"
+#include "MCBMotionCodec.h"
+#include "MCBMotionRecord.h"
+#include "ReelEstimator.h"
+#include "ReelProfile.h"
+#include "MotionSupervisor.h"
+#include "ClockGovernor.h"
+#include "StateMachine.h"
+#include "LatencyStats.h"
+#include "ECUStreams.h"
+#include "ProfileBinner.h"
+#include "TechnosoftRegs.h"
 #include "etl/bit_stream.h"
 #include "etl/array.h"
 
@@ -21,14 +34,16 @@
 #define EXTRA_LOGGING false
 
 // RATSReport reporting period, when scheduled by ACTION_RATS_REPORT.
+#ifndef RATS_REPORT_PERIOD_SECS
 #define RATS_REPORT_PERIOD_SECS 600
+#endif
 
 // Send a RATSReport when NUM_ECU_REPORTS have been received.
 // But if RATS_REPORT_PERIOD_SECS has elapsed, the report will be sent regardless.
 #define NUM_ECU_REPORTS 175
 
 // RATS_REPORT_MAX_BYTES is the maximum size of a RATS report in bytes. 
-#define RATS_REPORT_MAX_BYTES (RATS_HEADER_SIZE_BYTES+(NUM_ECU_REPORTS+1)*ECU_REPORT_SIZE_BYTES)
+#define RATS_REPORT_MAX_BYTES (RATS_REPORT_HEADER_SIZE_BYTES+(NUM_ECU_REPORTS+1)*ECU_REPORT_SIZE_BYTES+NUM_ECU_REPORTS*RATS_TIME_RECORD_MAX_BYTES)
 
 // Verify that a RATS report will fit in the TM message buffer.
 #if RATS_REPORT_MAX_BYTES > 8192
@@ -49,13 +64,28 @@
 // Our instrument name
 #define INSTRUMENT      RATS
 
-// Number of LoRa messages to wait for before moving on
-#define LORA_MSG_COUNT  3
-// Seconds to wait for all LoRa messages to be received during warmup
+// ECU reports that must follow the one carrying the warmup config out
+#define WARMUP_CONFIRM_REPORTS  1
+// Seconds allowed for each warmup attempt
+#ifndef LORA_WARMUP_MSG_TIMEOUT
 #define LORA_WARMUP_MSG_TIMEOUT 15
+#endif
 
 #define MCB_SERIAL_BUFFER_SIZE    4096
 
+// The size of the buffer used to collect MCB motion data for an MCBREPORT TM.
+#define MCB_TM_BUFFER_SIZE 8192
+
+// Each MCBREPORT payload starts with a segment header:
+// profile start epoch (uint32), segment number (uint16), flags (uint8).
+#define MCB_SEGMENT_HEADER_SIZE   7
+// More segments of this motion follow (the buffer filled).
+#define MCB_SEGMENT_CONTINUED     0x01
+// Sent in real-time MCB reporting mode.
+#define MCB_SEGMENT_REALTIME      0x02
+// Recovered after a reset.
+#define MCB_SEGMENT_RECOVERED     0x04
+
 // Buffers for msg reception and transmission to/from Zephyr. Should be large enough
 // to hold a complete TM, some of which which will contain the measurement data.
 #define ZEPHYR_SERIAL_BUFFER_SIZE (2*8192)
@@ -88,7 +118,6 @@ enum ScheduleAction_t : uint8_t {
 
     ACTION_START_TELEMETRY,
     ACTION_GPS_WAIT_MSG,
-    ACTION_LORA_COUNT_MSGS,
     ACTION_RATS_REPORT,
     ACTION_REEL_OUT,
     ACTION_REEL_IN,
@@ -97,6 +126,8 @@ enum ScheduleAction_t : uint8_t {
     ACTION_MOTION_STOP,
     ACTION_MOTION_TIMEOUT,
     ACTION_MCB_INIT_MOTION,
+    ACTION_PROFILE_START,
+    ACTION_FULL_RETRACT,
 
     NUM_ACTIONS
 };
@@ -122,6 +153,12 @@ enum ZephyrTXMsgType_t : uint8_t {
     ZEPHYRTX_IMR
 };
 
+// Key/delta encoder for MCB motion records in the MCB TM segment buffers.
+typedef MCBMotionCodec<MOTION_TM_SIZE> MCBMotionCodec_t;
+
+// Reset-surviving copies of the RATS report and MCB TM segment buffer.
+typedef RATSPersist<NUM_ECU_REPORTS, MCB_TM_BUFFER_SIZE> RATSPersist_t;
+
 class StratoRATS : public StratoCore {
     
 public:
@@ -137,6 +174,21 @@ public:
     // called in each main loop
     void RunMCBRouter();
 
+    // Called repeatedly while the main loop waits for its timer tick. Does
+    // deferrable work such as draining staged SD writes. Returns true if
+    // it did something, false if there was nothing to do.
+    bool IdleTask();
+
+    // Called after each core clock change, e.g. to re-derive timer periods
+    // that depend on the peripheral bus clock.
+    void SetClockChangeHandler(ClockGovernor::ChangeHandler_t handler) { clock_gov.SetChangeHandler(handler); }
+
+    // Get the "mode:NAME:SUBSTATE" label for the given mode/substate, e.g.
+    // "mode:FLIGHT:FL_MEASURE". Substate values are per-mode enums that reuse
+    // the same numbers, so the mode is required to disambiguate; unmapped
+    // substates are shown as their raw numeric value.
+    String getStateName(const uint8_t mode, const uint8_t substate);
+
 private:
     // internal serial interface objects for the MCB and ECU
     MCBComm mcbComm;
@@ -144,6 +196,10 @@ private:
     // EEPROM interface object
     RATSConfigs ratsConfigs;
 
+    // Staged SD writer for MCB TMs. SendMCBTM() only stages the TM in RAM;
+    // the card writes happen in IdleTask().
+    TMFileWriter mcbTMFile;
+
     // Initialize the flight mode status values
     void FlightModeInit();
 
@@ -170,6 +226,7 @@ private:
         FL_WARMUP,
         FL_MEASURE,
         FL_REEL,
+        FL_PROFILE,
         FL_ERROR = MODE_ERROR,
         FL_SHUTDOWN = MODE_SHUTDOWN,
         FL_EXIT = MODE_EXIT
@@ -198,6 +255,8 @@ private:
         SA_LOOP,
         SA_SEND_S,
         SA_ACK_WAIT,
+        SA_RETRACT,
+        SA_ERROR = MODE_ERROR,
         SA_SHUTDOWN = MODE_SHUTDOWN,
         SA_EXIT = MODE_EXIT
     };
@@ -220,9 +279,18 @@ private:
     // to do. As it is, the complete state machine logic is split up
     // among multiple files (via inst_state), making it very hard to 
     // see the logic in one place.
+    // Only the states inside Flight_Warmup() are table-driven so far
+    // (StateMachine.h); the dispatch between the flight sub-states, and
+    // the other sub-sub state machines, still work as described above.
     //
     // A sub-sub state machine to manage reel operations.
     bool Flight_Reel(bool restart);
+    // Set when Flight_Reel() returned because of a commanded motion stop
+    // rather than the end of the motion
+    bool reel_motion_stopped = false;
+    // millis() when Flight_Reel() sent its motion TM, 0 once that TM has
+    // been acked or resent
+    uint32_t reel_tm_ack_ms = 0;
     // A sub-sub state machine to manage the warmup operations.
     bool Flight_Warmup(bool restart);
 
@@ -240,6 +308,22 @@ private:
     void WatchFlags();
     // Used by StratoRATS action logic (I wonder why this logic is not in the StratoCore class?)
     ActionFlag_t action_flags[NUM_ACTIONS] = {{0}}; // initialize all flags to false
+    // millis() when each action flag was last set, for LAT_ACTION
+    uint32_t action_set_ms[NUM_ACTIONS] = {0};
+    // The actions set on the TC path to a reel motion, which LAT_ACTION
+    // measures; the scheduler's flags would dilute them
+    static bool IsCommandAction(uint8_t action);
+
+    // *** Latency probes ***
+    LatencyHistogram latency[NUM_LATENCY_PROBES];
+    // millis() at the start event of each probe, 0 when not started
+    uint32_t latency_start_ms[NUM_LATENCY_PROBES] = {0};
+    // Mark the start event of a probe (restarting it if already started)
+    void LatencyStart(LatencyProbe_t probe);
+    // Mark the end event: record the latency if the probe was started
+    void LatencyEnd(LatencyProbe_t probe);
+    // Send one text TM per probe with samples
+    void SendLatencyTM();
 
 
     // Global variable to track flight_substate_map[inst_subst] during flight mode
@@ -248,27 +332,71 @@ private:
     // *** LoRa support ***
     // Call this during every loop to check for incoming LoRa messages.
     void LoRaRX();
+    // Count, and log, a LoRa message dropped for its length.
+    void LoRaReject();
     // The most recently received LoRa message.
     ECULoRaMsg_t lora_msg;
     // The total number of LoRa messages received since the application started.
     uint32_t total_lora_count = 0;
-    // A temporary counter to track the number of LoRa messages received during warmup.
-    uint32_t lora_count = 0;
-    // Count incoming lora messages. If reset is set, the
-    // count is set to 0. 
-    // Return the current count.
-    // Uses the global variable lora_count.
-    uint32_t lora_count_check(bool reset=false);
+    // LoRa messages dropped because their length was invalid, including
+    // data reports too short to hold a whole record.
+    uint32_t lora_reject_count = 0;
+    // Per-ECU decimation and reception statistics
+    ECUStreams ecu_streams;
+
+    // *** Profile binning ***
+    // ECU measurements binned by altitude during each reel motion
+    ProfileBinner profile_bins;
+    uint8_t profile_tm[PROFILE_MAX_BYTES];
+    // Bin an ECU data report if a profile is being collected
+    void ProfileAddECUReport(uint8_t ecu_id, ECUReportBytes_t& ecu_report_bytes);
+    // Finish the profile once the motion has ended, and send it
+    void ServiceProfile();
+    // Send a RATSPROFILE TM with the profile product
+    void SendProfileTM();
     // Set to true to enable LoRa TX test mode
     bool lora_tx_test = false;
 
     // ECU control
     void ECUPowerControl(bool enable);
     bool IsECUPowerEnabled();
+    // At the start of a motion: turn the ECU off, unless profile_ecu_on keeps
+    // it running so that the motion's profile product gets samples.
+    void ECUMotionPower();
 
     // *** Warmup state machine ***
-    // LoRa message timeout counter
-    uint32_t LoRaMsg_timer_start = 0;
+    // The warmup state machine, defined by the tables in Flight_Warmup.cpp
+    enum WarmupState_t : uint8_t {
+        WS_ATTEMPT,         // Parent of WS_CONFIG_SENT and WS_CONFIRM
+        WS_CONFIG_SENT,
+        WS_CONFIRM,
+        WS_DONE,
+        WS_FAILED,
+        NUM_WARMUP_STATES
+    };
+    static const uint8_t NUM_WARMUP_TRANSITIONS = 4;
+    typedef StateMachine<StratoRATS, NUM_WARMUP_STATES, NUM_WARMUP_TRANSITIONS> WarmupSM_t;
+    static const WarmupSM_t::State_t WARMUP_STATES[NUM_WARMUP_STATES];
+    static const WarmupSM_t::Transition_t WARMUP_TRANSITIONS[NUM_WARMUP_TRANSITIONS];
+    WarmupSM_t warmup_sm{this, WARMUP_STATES, WARMUP_TRANSITIONS};
+    // Warmup state actions and guards
+    void WarmupSendConfig();
+    void WarmupRetry();
+    void WarmupComplete();
+    void WarmupFail();
+    bool WarmupConfigCarried();
+    bool WarmupConfirmed();
+    bool WarmupAttemptExpired();
+    bool WarmupLastAttemptExpired();
+    // Called by LoRaRX() for each data report from the paired ECU
+    void WarmupECUReport();
+    // Reports from the paired ECU since the config was queued
+    uint32_t warmup_reports = 0;
+    // millis() at the start of warmup, and of the current attempt
+    uint32_t warmup_start_ms = 0;
+    uint32_t warmup_attempt_ms = 0;
+    // Duration (ms) of the last completed warmup
+    uint32_t warmup_ms = 0;
     // The warmup status
     WarmupStatus_t warmup_status = WARMUP_INPROCESS;
     // Number of warmup cycles
@@ -282,6 +410,65 @@ private:
     // uint32_t start time of the current reel motion, in millis
     uint32_t reel_motion_start = 0;
 
+    // Velocity (revs/min) for the next reel-in motion started by StartMCBMotion(),
+    // or 0 to use ratsConfigs.Values().retract_velocity. Cleared when the motion starts.
+    float retract_velocity_cmd = 0.0f;
+
+    // *** Full retract (FullRetract.cpp) ***
+    // Retract the deployed length computed from the reel position estimate:
+    // a fast reel-in at the retract velocity, then the final
+    // full_retract_slow_revs without the level wind at full_retract_slow_vel.
+    // If the position is unknown, as it is after a boot that has not yet
+    // been through the standby init motion, it is first requested from the
+    // MCB. Returns true when finished, refused, or stopped by CANCELMOTION.
+    // On a motion fault, Flight_Reel() sets inst_substate to MODE_ERROR and
+    // this returns false.
+    bool FullRetract(bool restart_state);
+    // millis() at the start of the full retract
+    uint32_t full_retract_start_ms = 0;
+    // Set in SafetyMode() so that a full retract is tried only once per entry
+    bool safety_retract_attempted = false;
+
+    // *** Reel profile sequencer (Flight_Profile.cpp) ***
+    // Run the loaded reel profile. Returns true when it completes or is aborted.
+    bool Flight_Profile(bool restart_state);
+    // Report the timing of the current step and advance to the next one.
+    void FinishProfileStep();
+    // The profile commands, shared by the TCs and the debug console. Each
+    // puts the outcome in detail and returns the flag for the TC ack.
+    StateFlag_t ProfileLoadCommand(String& detail);
+    StateFlag_t ProfileStartCommand(String& detail);
+    StateFlag_t ProfileAbortCommand(String& detail);
+    // True once per power-on, in FL_MEASURE, if profile_autostart is set and
+    // a profile is loaded. A reset that recovers persisted data does not
+    // restart the profile.
+    bool ProfileAutostart();
+    // The profile script, loaded from the SD card at boot or by command.
+    ReelProfile reel_profile;
+    // Set by command to stop the profile once any motion or warmup in
+    // progress has finished.
+    bool profile_abort = false;
+    // Set when the autostart has been used, or is not wanted for this boot
+    bool profile_autostart_done = false;
+    // Index of the step being run
+    uint8_t profile_step = 0;
+    // millis() at the start of the profile, the current step, and its measurement window
+    uint32_t profile_start_ms = 0;
+    uint32_t step_start_ms = 0;
+    uint32_t measure_start_ms = 0;
+    // Time spent in the current step's motion and ECU warmup (ms)
+    uint32_t step_reel_ms = 0;
+    uint32_t step_warmup_ms = 0;
+
+    // *** Debug console (Console.cpp) ***
+    // Read line commands from the debug serial port, for the operations
+    // whose TCs are not yet in StratoCore. Not available when the debug
+    // port carries the Zephyr traffic.
+    void ServiceConsole();
+    void ConsoleCommand(char* line);
+    char console_line[64];
+    uint8_t console_len = 0;
+
     // *** MCB support ***
     // Handle ASCII messages from the MCB (in MCBRouter.cpp)
     void HandleMCBASCII();
@@ -293,59 +480,89 @@ private:
     void HandleMCBString();
     // Start any type of MCB motion
     bool StartMCBMotion();
+    // Current estimated reel position (revs), see ReelEstimator.h
+    float ReelPosition() { return reel_est.Position(millis()); }
+    // Format the reel estimate for a TM message: "Reel:<pos> <age>s <conf>%"
+    void FormatReelEstimate(char* buf, size_t size);
 
     // MCB motion tracking and TM functions. 
     // These are used to track the progress of a reel motion, and to build and send TMs 
     // with the motion data. The motion data is received from the MCB in binary messages, 
-    // which are processed in HandleMCBBin() and added to the MCB_TM_buffer via AddMCBTM().
+    // which are processed in HandleMCBBin() and added to the segment buffer via AddMCBTM().
     //
-    // If in real-time MCB reporting mode, the MCB binary messages are sent immediately as 
-    // MCBREPORT TMs.
+    // Motion data is collected in segments. Every MCBREPORT payload is one segment,
+    // which starts with a MCB_SEGMENT_HEADER_SIZE header: the profile start epoch
+    // (the same for every segment of a motion, zero outside a motion), the segment
+    // number within the motion, and MCB_SEGMENT_* flags. The motion records follow.
     //
-    // If not in real-time MCB reporting mode, the MCB binary messages are 
-    // collected in MCB_TM_buffer, and sent as a single MCBREPORT TM when a certain
-    // condition is met. The condition could be the completion of the motion, a timeout, 
-    // reception of an MCB error message, or something else.
+    // Records are added to the segment buffer. When it is full, or after every
+    // record in real-time MCB reporting mode, the segment is sent and a new one
+    // is started in its place. SendMCBTM() sends the segment for TMs that report
+    // an event (motion complete, fault, ack, ...) together with the data
+    // collected so far. A segment is sent in the pass that fills it: there is
+    // one zephyrTX TM buffer, so a NAK resends only the TM most recently sent.
     //
-    // It seems like there is an opportunity for a MCM_TM_buffer to overflow,
-    // because the value if MCM_TM_buffer_idx is never checked against the size of MCB_TM_buffer. 
-    // However, in practice this might not be an issue, because the MCB binary messages are 
-    // expected to be small and infrequent, and the MCB_TM_buffer is large (8192 bytes). 
-    // We could add a check in AddMCBTM() to ensure that we don't 
-    // write past the end of the buffer. We could also consider implementing some logic to 
-    // handle the case where the buffer does fill up, such as sending a TM with the data 
-    // collected so far and then clearing the buffer to make room for more data.
-    //
-    // Set variables and initialize the TM for MCB binary data collection.
+    // Set variables and start the first segment for MCB binary data collection.
     void InitMCBMotionTracking();
-    // **If we are not in real-time mcb reporting mode, data from mcbComm.binary_rx.bin_buffer 
-    // will be appended to MCB_TM_buffer.**
-    // **If we are in real-time mcb reporting mode, data from mcbComm.binary_rx.bin_buffer 
-    // will be sent immediately as a MCBREPORT TM.**
+    // Append the motion record in mcbComm.binary_rx.bin_buffer to the segment buffer.
     void AddMCBTM();
+    // Append the raw motion_fault[] registers to the segment buffer as a fault record.
+    void AddMCBFaultRecord();
     // Send an MCBREPORT TM with a StateMessage1 message, and the aggregated 
-    // data in MCB_TM_buffer.
+    // data in the segment buffer.
     void SendMCBTM(const char* TMname, StateFlag_t state_flag, const char * message);
+    // Write a new segment header into the (empty) segment buffer.
+    void StartMCBSegment();
+    // Send the segment with MCB_SEGMENT_* flags added, and start the next one.
+    void SendMCBContinuation(uint8_t flags, const char* message);
+    // Send the segment in MCB_TM_buffer as a TM and stage it for the SD card.
+    void SendMCBSegment(const char* TMname, StateFlag_t state_flag, const char* message);
     bool mcb_low_power = false;
     // Set when a reel motion is initiated, cleared when the motion is complete.
     bool mcb_motion_ongoing = false;
     // The maximum time allowed for a reel motion to complete.
     uint32_t max_reel_seconds = 0;
-    // TODO: Will be used in the safety mode, which has been implemented yet
+    // Set while a full retract is in progress (FullRetract.cpp)
     bool mcb_reeling_in = false;
     // The buffer used to receive binary data from each incoming MCB message.
-    // The data will be copied to the MCB_TM_buffer for TM transmission.
+    // The data will be copied to the MCB TM segment buffers for TM transmission.
     uint8_t binary_mcb[MCB_BINARY_BUFFER_SIZE];
     // Counts the number of MCB binary messages received during a motion
     uint16_t mcb_tm_counter = 0;
     // The current reel position in revs, extracted from the MCB binary message.
     float reel_pos = 0.0;
+    // Reel position estimate between MCB motion records. Use ReelPosition()
+    // rather than reel_pos when reporting.
+    ReelEstimator reel_est;
+    // Commanded end position (revs) and velocity (revs/s) of the motion
+    // being started, set in StartMCBMotion().
+    float reel_cmd_target = 0.0;
+    float reel_cmd_vel = 0.0;
+    // Commanded acceleration magnitude (revs/s^2) of the motion being started
+    float reel_cmd_acc = 0.0;
+    // Checks the reel position samples of a motion against its expected trajectory
+    MotionSupervisor motion_sup;
+    // Selects the core clock for the current mode (see ClockPolicy())
+    ClockGovernor clock_gov;
+    // The clock level wanted for the current mode and substate
+    ClockLevel_t ClockPolicy();
+    // Check the latest reel position with motion_sup, and cancel the motion on a fault.
+    void SuperviseMotion();
+    // Record count and reel position range of the current motion.
+    MCBMotionSummary_t mcb_motion_summary = {0};
     // array of error values for MCB motion fault
     uint16_t motion_fault[8] = {0};
-    // A buffer to collect MCB binary data for the MCB TM.
-    uint8_t MCB_TM_buffer[8192] = {0};
-    // Next available index in the MCB TM buffer.
-    uint16_t MCB_TM_buffer_idx = 0;
+    // The segment buffer used to collect MCB binary data for MCB TMs.
+    uint8_t MCB_TM_buffer[MCB_TM_BUFFER_SIZE] = {0};
+    // Number of bytes used in the segment buffer.
+    uint16_t MCB_TM_buffer_len = 0;
+    // Profile start epoch written into every segment header of the current motion.
+    uint32_t mcb_profile_epoch = 0;
+    // Number of the next segment of the current motion.
+    uint16_t mcb_segment = 0;
+    // Encodes each motion record as a key or delta record relative to the
+    // previous record in the segment buffer.
+    MCBMotionCodec_t mcb_codec;
     // tracks the current type of motion
     MCBMotion_t mcb_motion = NO_MOTION;
 
@@ -358,18 +575,16 @@ private:
     void SendMCBEEPROM();
     // Send a TM with RATS EEPROM contents
     void SendRATSEEPROM();
+    // Read or change a config value by ID, for the TCs and the debug
+    // console. Each puts the outcome in detail and returns the ack flag.
+    StateFlag_t ConfigGetCommand(uint8_t id, String& detail);
+    StateFlag_t ConfigSetCommand(uint8_t id, float value, String& detail);
     // Send a TM
     void SendTM(String details1, StateFlag_t state_flag1, 
         String details2, StateFlag_t state_flag2, 
         String details3, StateFlag_t state_flag3);
     // Send a RATSTEXT TM with text data
     void SendRATSTextTM(String text_data, StateFlag_t state_flag);
-    // Map set bits in a Technosoft MER (Motion Error Register) to a comma-separated string
-    String MERmap(uint16_t mer);
-    // Map set bits in a Technosoft SRL (Status Register Low) to a comma-separated string
-    String SRLmap(uint16_t srl);
-    // Map set bits in a Technosoft SRH (Status Register High) to a comma-separated string
-    String SRHmap(uint16_t srh);
 
     // A running sum of the voltage for inst_imon.
     float a3_v_sum = 0.0;
@@ -378,38 +593,38 @@ private:
 
     // *** RatsReports ***
     // Accumulate RATS reports for transmission
-    void ratsReportAccumulate(ECUReportBytes_t& ecu_report_bytes);
+    void ratsReportAccumulate(ECUReportBytes_t& ecu_report_bytes, ECUStream_t& stream);
     // Check if it's time for a ratsReport and send a TM if true.
     // If immediate is true, the report will be sent immediately.
     void ratsReportCheck(bool immediate);
-    // Send a TM with the ratsReport message
-    void SendRATSReportTM();
+    // Send a TM with the ratsReport message. recovered marks a report that
+    // holds ECU records restored after a reset.
+    void SendRATSReportTM(bool recovered = false);
     // Time of last RATS report
     time_t last_rats_report = 0;
     // Build and manage the RATS data report here. ECUReports are accumulated
     // into this report until it is sent.
     RATSReport<NUM_ECU_REPORTS> rats_report;
 
+    // *** Reset-surviving copies of the accumulation buffers ***
+    // Mirrors rats_report records, the MCB TM segment buffer and key state into DMAMEM.
+    RATSPersist_t persist;
+    // Called from InstrumentSetup(). If the previous boot left valid data, restore
+    // the reel position and counters, and flush the recovered ECU records and
+    // MCB motion data as TMs flagged as recovered.
+    void RecoverPersistedData();
+    // Copy the scalar state (reel_pos, counters) into the persisted image.
+    void PersistState();
+
     // The Teensy MAC address set during InstrumentSetup().
     uint8_t mac_address[6];
 
     // The RATS ID number, set during InstrumentSetup().
     uint16_t rats_id;
 
-    // The paired ECU ID. It is stored in ratsConfigs.paired_ecu, but cached here
-    // so that we don't keep reading it from the program flash. Any time that
-    // ratsConfigs.paired_ecu_id is updated, this variable should also be updated.
-    uint8_t paired_ecu;
-
     // Prepend the RATS message header to a string and send to ECU via LoRa.
     void LoRaTx(char* ecu_cmd, bool immediate=false);
 
-    // Get the "mode:NAME:SUBSTATE" label for the given mode/substate, e.g.
-    // "mode:FLIGHT:FL_MEASURE". Substate values are per-mode enums that reuse
-    // the same numbers, so the mode is required to disambiguate; unmapped
-    // substates are shown as their raw numeric value.
-    String getStateName(const uint8_t mode, const uint8_t substate);
-
     // Send a tiny command to the MCB so that we will get an MCB message containing
     // the reel position. This will cause reel_pos to be initialized.
     void InitializeReelPosition();
@@ -50,6 +50,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
             deploy_length = mcbParam.deployLen;
             msg2 += ": " + String(deploy_length, 1) + " revs";
             SetAction(ACTION_REEL_OUT);
+            LatencyStart(LAT_TC_MOTION);
         } else {
             msg3 = "Cannot deploy, not in FL_MEASURE";
             msg1_flag = WARN;
@@ -57,12 +58,15 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         break;
     case DEPLOYv:
         msg2 = "TC Deploy Velocity: " + String(mcbParam.deployVel);
-        ratsConfigs.deploy_velocity.Write(mcbParam.deployVel);
+        ratsConfigs.Set(&RATSConfigValues_t::deploy_velocity, mcbParam.deployVel);
         break;
     case DEPLOYa:
         msg2 = "TC Deploy Acceleration: " + String(mcbParam.deployAcc);
         if (!mcbComm.TX_Out_Acc(mcbParam.deployAcc)) {
             msg3 = "Error sending deploy acc to MCB";
+        } else {
+            // Kept for the motion supervisor's expected trajectory
+            ratsConfigs.Set(&RATSConfigValues_t::deploy_acc, mcbParam.deployAcc);
         }
         break;
     case RETRACTx:
@@ -70,6 +74,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (inst_substate == FL_MEASURE) {
             retract_length = mcbParam.retractLen;
             SetAction(ACTION_REEL_IN);
+            LatencyStart(LAT_TC_MOTION);
             msg2 +=  ": " + String(retract_length, 1) + " revs";
         } else {
             msg3 = "Cannot retract, not in FL_MEASURE";
@@ -78,26 +83,59 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         break;
     case RETRACTv:
         msg2 = "TC Retract Velocity: " + String(mcbParam.retractVel);
-        ratsConfigs.retract_velocity.Write(mcbParam.retractVel);
+        ratsConfigs.Set(&RATSConfigValues_t::retract_velocity, mcbParam.retractVel);
         break;
     case RETRACTa:
         msg2 = "TC Retract Acceleration: " + String(mcbParam.retractAcc);
         if (!mcbComm.TX_In_Acc(mcbParam.retractAcc)) {
             msg3 = "Error sending retract acc to MCB";
             msg1_flag = WARN;
+        } else {
+            // Kept for the motion supervisor's expected trajectory
+            ratsConfigs.Set(&RATSConfigValues_t::retract_acc, mcbParam.retractAcc);
         }
         break;
     case FULLRETRACT:
-        // todo: determine implementation
         msg2 = "TC Full Retract";
-        msg3 = "TC Full Retract not implemented";
-        msg1_flag = WARN;
+        if (inst_substate == FL_MEASURE) {
+            msg2 += ": " + String(-ReelPosition(), 1) + " revs";
+            SetAction(ACTION_FULL_RETRACT);
+            LatencyStart(LAT_TC_MOTION);
+        } else {
+            msg3 = "Cannot full retract, not in FL_MEASURE";
+            msg1_flag = WARN;
+        }
         break;
     case CANCELMOTION:
         msg2 = "TC Cancel Motion";
         mcbComm.TX_ASCII(MCB_CANCEL_MOTION); // no matter what, attempt to send (irrespective of mode)
         SetAction(ACTION_MOTION_STOP);
+        // A cancelled motion also ends a running profile
+        if (inst_substate == FL_PROFILE) {
+            profile_abort = true;
+        }
+        break;
+    case RATSPROFILELOAD:
+        msg2 = "TC Load reel profile";
+        msg1_flag = ProfileLoadCommand(msg3);
         break;
+    case RATSPROFILESTART:
+        msg2 = "TC Start reel profile";
+        msg1_flag = ProfileStartCommand(msg3);
+        break;
+    case RATSPROFILEABORT:
+        msg2 = "TC Abort reel profile";
+        msg1_flag = ProfileAbortCommand(msg3);
+        break;
+    case RATSCONFIGGET:
+        msg2 = "TC Get config " + String(ratsParam.config_id);
+        msg1_flag = ConfigGetCommand(ratsParam.config_id, msg3);
+        break;
+    case RATSCONFIGSET:
+        msg2 = "TC Set config " + String(ratsParam.config_id) + ": " + String(ratsParam.config_value, 3);
+        msg1_flag = ConfigSetCommand(ratsParam.config_id, ratsParam.config_value, msg3);
+        break;
+
     case ZEROREEL:
         msg2 = "TC Zero Reel";
         if (mcb_motion_ongoing) {
@@ -154,7 +192,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
     // RATS Telecommands -----------------------------------
     case RATSECUDECIMATEFACTOR:
         msg2 = "TC set decimate factor:" + String(ratsParam.decimate_factor);
-        ratsConfigs.decimate_factor.Write(ratsParam.decimate_factor);
+        ratsConfigs.Set(&RATSConfigValues_t::decimate_factor, ratsParam.decimate_factor);
         break;
     case RATSREALTIMEMCBON:
         msg2 = "TC Enabled real-time MCB mode";
@@ -162,7 +200,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
             msg3 = "Can't start real-time MCB mode while reel is in motion";
             msg1_flag = WARN;
         } else {
-            ratsConfigs.real_time_mcb.Write(true);
+            ratsConfigs.Set(&RATSConfigValues_t::real_time_mcb, true);
         }
         break;
     case RATSREALTIMEMCBOFF:
@@ -171,7 +209,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
             msg3 = "Can't start real-time MCB mode off while reel is in motion";
             msg1_flag = WARN;
         } else {
-            ratsConfigs.real_time_mcb.Write(false);
+            ratsConfigs.Set(&RATSConfigValues_t::real_time_mcb, false);
         }
         break;
     case RATSLORATXTESTON:
@@ -195,11 +233,11 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
     case RATSECUTEMP:
         msg2 = "TC set ECU temp: " + String(ratsParam.ecu_tempC);
         // Save the ECU temp to EEPROM
-        ratsConfigs.ecu_tempC.Write(ratsParam.ecu_tempC);
+        ratsConfigs.Set(&RATSConfigValues_t::ecu_tempC, ratsParam.ecu_tempC);
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
-            ecu_json["tempC"] = ratsConfigs.ecu_tempC.Read();
-            sendEcuJson(paired_ecu);
+            ecu_json["tempC"] = ratsConfigs.Values().ecu_tempC;
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "TC Cannot send ECU temp, ECU power is off";
             msg1_flag = WARN;
@@ -224,7 +262,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["rs41Regen"] = true;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
             LoRaTx(ecu_json_str);
         } else {
             msg3 = "TC Cannot send RS41 regen, ECU power is off";
@@ -236,7 +274,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["rs41Metadata"] = true;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "TC Cannot send RS41 metadata request, ECU power is off";
             msg1_flag = WARN;
@@ -247,7 +285,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["rs41Enable"] = true;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "TC Cannot send RS41 enable, ECU power is off";
             msg1_flag = WARN;
@@ -258,7 +296,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["rs41Enable"] = false;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "TC Cannot send RS41 enable off, ECU power is off";
             msg1_flag = WARN;
@@ -269,7 +307,7 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["tsenPower"] = true;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "TC Cannot send TSEN power on, ECU power is off";
             msg1_flag = WARN;
@@ -280,16 +318,15 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         if (IsECUPowerEnabled()) {
             ecu_json.clear();
             ecu_json["tsenPower"] = false;
-            sendEcuJson(paired_ecu);
+            sendEcuJson(ratsConfigs.Values().paired_ecu);
         } else {
             msg3 = "Cannot send TSEN power off, ECU power is off";
             msg1_flag = WARN;
         }
         break;
     case RATSPAIREDCEU:
-        ratsConfigs.paired_ecu.Write(ratsParam.paired_ecu);
-        paired_ecu = ratsParam.paired_ecu;
-        msg2 = "TC set the paired ECU ID: " + String(ratsConfigs.paired_ecu.Read());
+        ratsConfigs.Set(&RATSConfigValues_t::paired_ecu, ratsParam.paired_ecu);
+        msg2 = "TC set the paired ECU ID: " + String(ratsConfigs.Values().paired_ecu);
         break;
     case RATSINFO:
         msg2 = "TC get version";
@@ -353,6 +390,13 @@ bool StratoRATS::TCHandler(Telecommand_t telecommand)
         version_json["pwr"] = lora_config.power;
         serializeJson(version_json, version_str, sizeof(version_str));
         SendRATSTextTM(version_str, FINE);
+
+        // Time spent at each core clock level
+        clock_gov.Format(log_array, LOG_ARRAY_SIZE, millis());
+        SendRATSTextTM(log_array, FINE);
+
+        // Latency summaries
+        SendLatencyTM();
     }
 
     return true;
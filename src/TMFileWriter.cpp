@@ -0,0 +1,191 @@
+/*
+ *  TMFileWriter.cpp
+ *
+ *  Staged, sector-aligned SD card writer for TM records. See TMFileWriter.h.
+ */
+
+#include "TMFileWriter.h"
+#include <TimeLib.h>
+#include "StratoGroundPort.h"
+
+TMFileWriter::TMFileWriter(const char* file_prefix)
+    : prefix(file_prefix)
+{ }
+
+bool TMFileWriter::Begin(SdFs& card, Buffers_t& buffers)
+{
+    stage = buffers.stage;
+    pad_sector = buffers.pad_sector;
+    if (card.fatType() == 0) {
+        log_error("TMFileWriter: SD card not mounted");
+        return false;
+    }
+    sd = &card;
+    return OpenNextFile();
+}
+
+bool TMFileWriter::OpenNextFile()
+{
+    if (file_open) {
+        // Trim the unused preallocation so the file size matches its contents.
+        file.truncate(file_pos);
+        file.close();
+        file_open = false;
+    }
+
+    char name[24];
+    char msg[64];
+    // Never overwrite an old file; skip to the first unused name. Once all
+    // the names are used, stop writing rather than reuse one.
+    bool found = false;
+    while (file_index < TM_FILE_MAX_FILES) {
+        snprintf(name, sizeof(name), "%s_%04u.DAT", prefix, file_index++);
+        if (!sd->exists(name)) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        snprintf(msg, sizeof(msg), "TMFileWriter: all %u %s files used, not writing", TM_FILE_MAX_FILES, prefix);
+        log_error(msg);
+        return false;
+    }
+
+    file = sd->open(name, O_RDWR | O_CREAT | O_EXCL);
+    if (!file) {
+        snprintf(msg, sizeof(msg), "TMFileWriter: unable to open %s", name);
+        log_error(msg);
+        return false;
+    }
+
+    // Contiguous preallocation keeps each sector write a single card operation.
+    if (!file.preAllocate(TM_FILE_PREALLOC_BYTES)) {
+        snprintf(msg, sizeof(msg), "TMFileWriter: unable to preallocate %s", name);
+        log_error(msg);
+    }
+
+    file_open = true;
+    file_pos = 0;
+    partial_head = 0;
+
+    snprintf(msg, sizeof(msg), "TMFileWriter: writing %s", name);
+    log_nominal(msg);
+    return true;
+}
+
+void TMFileWriter::Stage(const uint8_t* data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        stage[(head + i) % STAGE_BYTES] = data[i];
+    }
+    head += len;
+}
+
+bool TMFileWriter::Write(const char* label, const uint8_t* data, uint16_t data_len)
+{
+    size_t label_strlen = strlen(label);
+    uint8_t label_len = (uint8_t) (label_strlen > 255 ? 255 : label_strlen);
+    uint32_t record_len = 2 + 4 + 4 + 1 + label_len + 2 + data_len;
+
+    if (!file_open || (head - tail) + record_len > STAGE_BYTES) {
+        dropped_bytes += record_len;
+        return false;
+    }
+
+    uint32_t epoch = now();
+    uint32_t ms = millis();
+    uint8_t hdr[11] = {
+        0xA5, 0x5A,
+        (uint8_t) (epoch >> 24), (uint8_t) (epoch >> 16), (uint8_t) (epoch >> 8), (uint8_t) epoch,
+        (uint8_t) (ms >> 24), (uint8_t) (ms >> 16), (uint8_t) (ms >> 8), (uint8_t) ms,
+        label_len
+    };
+    uint8_t len_bytes[2] = { (uint8_t) (data_len >> 8), (uint8_t) data_len };
+
+    Stage(hdr, sizeof(hdr));
+    Stage((const uint8_t*) label, label_len);
+    Stage(len_bytes, sizeof(len_bytes));
+    Stage(data, data_len);
+
+    last_write_ms = millis();
+    return true;
+}
+
+bool TMFileWriter::WriteSector(const uint8_t* sector)
+{
+    if (file_pos + TM_FILE_SECTOR_SIZE > TM_FILE_PREALLOC_BYTES) {
+        if (!OpenNextFile()) {
+            return false;
+        }
+    }
+
+    uint32_t start = micros();
+    bool ok = file.seekSet(file_pos)
+        && (file.write(sector, TM_FILE_SECTOR_SIZE) == TM_FILE_SECTOR_SIZE);
+    last_flush_us = micros() - start;
+    if (last_flush_us > max_flush_us) {
+        max_flush_us = last_flush_us;
+    }
+    if (ok) {
+        sectors_written++;
+    } else {
+        log_error("TMFileWriter: sector write failed");
+    }
+    return ok;
+}
+
+bool TMFileWriter::WriteStagedSector()
+{
+    if (!WriteSector(&stage[tail % STAGE_BYTES])) {
+        return false;
+    }
+    tail += TM_FILE_SECTOR_SIZE;
+    file_pos += TM_FILE_SECTOR_SIZE;
+    return true;
+}
+
+bool TMFileWriter::Service()
+{
+    if (!file_open) {
+        return false;
+    }
+
+    // A whole sector is staged: write it and release it from the ring.
+    if (head - tail >= TM_FILE_SECTOR_SIZE) {
+        WriteStagedSector();
+        return true;
+    }
+
+    // Only a partial sector remains. Write it once things have gone quiet,
+    // then commit the directory entry so the data survives a reset.
+    if (head != tail && head != partial_head
+        && (millis() - last_write_ms) >= TM_FILE_IDLE_FLUSH_MS) {
+        uint32_t n = head - tail;
+        memset(pad_sector, 0, TM_FILE_SECTOR_SIZE);
+        for (uint32_t i = 0; i < n; i++) {
+            pad_sector[i] = stage[(tail + i) % STAGE_BYTES];
+        }
+        if (WriteSector(pad_sector)) {
+            file.sync();
+            partial_head = head;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void TMFileWriter::Flush()
+{
+    if (!file_open) {
+        return;
+    }
+    while (head - tail >= TM_FILE_SECTOR_SIZE) {
+        if (!WriteStagedSector()) {
+            return;
+        }
+    }
+    // Force the trailing partial sector out now.
+    last_write_ms = millis() - TM_FILE_IDLE_FLUSH_MS;
+    Service();
+}
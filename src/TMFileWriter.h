@@ -0,0 +1,132 @@
+/*
+ *  TMFileWriter.h
+ *
+ *  Staged, sector-aligned SD card writer for TM records.
+ *
+ *  Write() only copies a record into a RAM staging ring; it never touches the
+ *  SD card, so it is safe to call from the TM paths in the main loop. The ring
+ *  is drained one 512-byte sector at a time by Service(), which is intended to
+ *  be called from otherwise idle loop time (see WaitForControlTimer() in the
+ *  sketch). Sectors are written sequentially into a file that was preallocated
+ *  when it was opened, so the card never has to extend the FAT chain in the
+ *  middle of a write.
+ *
+ *  A partially filled sector is only written after the staged data has been
+ *  idle for TM_FILE_IDLE_FLUSH_MS (or when Flush() is called). It is padded
+ *  with zeros, and the file position is left at the start of that sector so
+ *  that it is rewritten in place once the sector fills.
+ *
+ *  The staging ring is large, so it is not part of the writer: the owner
+ *  defines a Buffers_t with DMAMEM at file scope and hands it to Begin(),
+ *  along with the SD card, which must already be mounted.
+ *
+ *  File record format (all multi-byte values big-endian):
+ *    0xA5 0x5A              sync
+ *    uint32                 epoch seconds when the record was staged
+ *    uint32                 millis() when the record was staged
+ *    uint8   n              label length, followed by n label bytes
+ *    uint16  m              payload length, followed by m payload bytes
+ *  The rest of the sector after the last record is zero padding. Beyond it,
+ *  preallocated space is not zeroed; it is trimmed when a file is closed, but
+ *  a file left open by a reset still holds whatever the card held there. The
+ *  format is also described in docs/TM_specs.md.
+ */
+
+#ifndef TMFILEWRITER_H
+#define TMFILEWRITER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+// SD sector size; all card writes are whole, aligned sectors.
+#define TM_FILE_SECTOR_SIZE     512
+// Staging ring size in sectors. Must hold the largest single record
+// (a full MCB TM segment buffer plus the record header), with room to spare,
+// and must be a power of two so the ring indices can wrap freely.
+#define TM_FILE_STAGE_SECTORS   64
+// Space preallocated for each file. A new file is started when it fills.
+#define TM_FILE_PREALLOC_BYTES  (8UL*1024UL*1024UL)
+// Number of file names, PREFIX_0000.DAT to PREFIX_9999.DAT. When they are
+// all used the writer stops (and counts drops) rather than overwrite one.
+#define TM_FILE_MAX_FILES       10000
+// Write out a trailing partial sector after the staged data has been idle this long.
+#define TM_FILE_IDLE_FLUSH_MS   5000
+
+class TMFileWriter {
+public:
+    static const uint32_t STAGE_BYTES = TM_FILE_STAGE_SECTORS * TM_FILE_SECTOR_SIZE;
+
+    // The staging ring and the sector used to pad a partial sector
+    struct Buffers_t {
+        uint8_t stage[STAGE_BYTES];
+        uint8_t pad_sector[TM_FILE_SECTOR_SIZE];
+    };
+
+    // file_prefix is used to name the files, e.g. "MCB" -> MCB_0003.DAT
+    explicit TMFileWriter(const char* file_prefix);
+
+    // Open the first free file on a mounted card, staging through buffers.
+    // Returns false if the card or file is unavailable; Write() will then
+    // just count drops.
+    bool Begin(SdFs& card, Buffers_t& buffers);
+
+    // Stage a record for writing. Returns false (and counts the bytes as
+    // dropped) if the writer is not open or the staging ring is full.
+    bool Write(const char* label, const uint8_t* data, uint16_t data_len);
+
+    // Write at most one sector to the card. Returns true if a card write
+    // was performed, so the caller can decide whether to yield.
+    bool Service();
+
+    // Write everything that is staged, including a padded partial sector.
+    void Flush();
+
+    // Bytes staged in RAM that are not yet written to the card as whole sectors.
+    uint32_t Backlog() const { return head - tail; }
+    // Duration of the most recent and the slowest sector write (us).
+    uint32_t LastFlushMicros() const { return last_flush_us; }
+    uint32_t MaxFlushMicros() const { return max_flush_us; }
+    // Bytes rejected because the ring was full or the card was unavailable.
+    uint32_t DroppedBytes() const { return dropped_bytes; }
+    // Total sectors written to the card.
+    uint32_t SectorsWritten() const { return sectors_written; }
+
+private:
+    // Copy bytes into the ring at head. Caller has checked for space.
+    void Stage(const uint8_t* data, uint32_t len);
+    // Write one sector at file_pos and time it.
+    bool WriteSector(const uint8_t* sector);
+    // Write the sector at tail and release it from the ring.
+    bool WriteStagedSector();
+    // Close the current file (trimming unused preallocation) and open the next.
+    bool OpenNextFile();
+
+    const char* prefix;
+    SdFs* sd = nullptr;
+    FsFile file;
+    bool file_open = false;
+    uint16_t file_index = 0;
+
+    // Offset in the file of the next whole sector.
+    uint32_t file_pos = 0;
+    // Value of head when a padded partial sector was last written, so an
+    // unchanged partial sector is not rewritten on every idle pass.
+    uint32_t partial_head = 0;
+
+    // Ring indices; they increase monotonically and are reduced modulo
+    // STAGE_BYTES when used. tail is always sector aligned.
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    // millis() of the last Write(), used for the idle partial flush.
+    uint32_t last_write_ms = 0;
+
+    uint32_t last_flush_us = 0;
+    uint32_t max_flush_us = 0;
+    uint32_t dropped_bytes = 0;
+    uint32_t sectors_written = 0;
+
+    uint8_t* stage = nullptr;
+    uint8_t* pad_sector = nullptr;
+};
+
+#endif /* TMFILEWRITER_H */
@@ -0,0 +1,138 @@
+#ifndef TECHNOSOFT_REGS_H
+#define TECHNOSOFT_REGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Decode Technosoft drive status and error registers into text.
+//
+// Each register has a constant 16-entry table of bit names (nullptr for
+// reserved or unused bits). TechnosoftDecode() writes the names of the set
+// bits, comma separated, into a caller-provided buffer; nothing is
+// allocated. The header has no Arduino dependencies so that ground tools
+// can use the same tables to decode the raw registers in the MCB TM.
+//
+// Register references:
+//   MER https://www.technosoftmotion.com/ESM-um-html/tml_mer.htm
+//   SRL https://www.technosoftmotion.com/ESM-um-html/tml_srl.htm
+//   SRH https://www.technosoftmotion.com/ESM-um-html/tml_srh.htm
+
+enum TechnosoftReg_t : uint8_t {
+    TS_REG_SRL,     // Status Register Low
+    TS_REG_SRH,     // Status Register High
+    TS_REG_MER,     // Motion Error Register
+    TS_NUM_REGS
+};
+
+// Order of the registers in the MCB_MOTION_FAULT message (motion_fault[8]).
+// TS_REG_NONE marks the MCB-specific detailed error words, which have no bit map.
+#define TS_REG_NONE TS_NUM_REGS
+static const uint8_t TS_MOTION_FAULT_REGS[8] = {
+    TS_REG_SRL,     // [0] Reel SRL
+    TS_REG_SRH,     // [1] Reel SRH
+    TS_REG_NONE,    // [2] Reel detailed error
+    TS_REG_MER,     // [3] Reel MER
+    TS_REG_SRL,     // [4] Level wind SRL
+    TS_REG_SRH,     // [5] Level wind SRH
+    TS_REG_NONE,    // [6] Level wind detailed error
+    TS_REG_MER,     // [7] Level wind MER
+};
+
+static const char* const TS_BIT_NAMES[TS_NUM_REGS][16] = {
+    // TS_REG_SRL; only the bits of interest are named
+    {
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        "CALLWRG",  // 7:  Cancelable call warning
+        "CALLSST",  // 8:  Function running via cancelable call
+        nullptr,
+        "MOTS",     // 10: Motion complete
+        nullptr, nullptr, nullptr,
+        "EVNS",     // 14: Last programmed event reached
+        "AXISST",   // 15: Axis on
+    },
+    // TS_REG_SRH
+    {
+        "ENDINIT",  // 0:  Drive/motor initialization complete
+        "PTRG1",    // 1:  Position trigger 1 active
+        "PTRG2",    // 2:  Position trigger 2 active
+        "PTRG3",    // 3:  Position trigger 3 active
+        "PTRG4",    // 4:  Position trigger 4 active
+        "AUTORUN",  // 5:  AUTORUN mode enabled
+        "LSWPS",    // 6:  Positive limit switch event
+        "LSWNS",    // 7:  Negative limit switch event
+        "PCAPS",    // 8:  Capture event triggered
+        "TRGR",     // 9:  Target command achieved
+        "I2TWRGM",  // 10: Motor I2T warning
+        "I2TWRGD",  // 11: Drive I2T warning
+        "INGEAR",   // 12: Electronic gearing ratio achieved
+        nullptr,    // 13: Reserved
+        "INCAM",    // 14: Absolute electronic camming position reached
+        "FAULT",    // 15: Drive/motor in fault
+    },
+    // TS_REG_MER
+    {
+        "CANBER",   // 0:  CAN bus error
+        "SCER",     // 1:  Short-circuit protection
+        "STPTBL",   // 2:  Invalid setup table
+        "CTRER",    // 3:  Control error
+        "SCIER",    // 4:  Serial/internal communication error
+        "WRPSER",   // 5:  Hall/resolver/BiSS/wrap-around error
+        "LSPST",    // 6:  Positive limit switch active
+        "LSNST",    // 7:  Negative limit switch active
+        "OCER",     // 8:  Over-current error
+        "I2TER",    // 9:  I2T protection error
+        "OTERM",    // 10: Motor over-temperature error
+        "OTERD",    // 11: Drive over-temperature error
+        "OVER",     // 12: Over-voltage error
+        "UVER",     // 13: Under-voltage error
+        "CMDER",    // 14: Command error
+        "ENST",     // 15: Drive/motor disabled
+    },
+};
+
+// Write the names of the bits set in value, e.g. "OCER,I2TER", or "none",
+// into buf (size bytes, always terminated). Names that don't fit are
+// dropped and the text ends with "+". Returns the length written.
+inline size_t TechnosoftDecode(TechnosoftReg_t reg, uint16_t value, char* buf, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    buf[0] = '\0';
+    if (reg >= TS_NUM_REGS) {
+        return 0;
+    }
+
+    size_t n = 0;
+    for (uint8_t i = 0; i < 16; i++) {
+        const char* name = TS_BIT_NAMES[reg][i];
+        if (!name || !(value & (1u << i))) {
+            continue;
+        }
+        size_t len = strlen(name);
+        size_t sep = (n > 0) ? 1 : 0;
+        // Keep room for the terminator and a possible "+"
+        if (n + sep + len + 2 > size) {
+            if (n + 2 <= size) {
+                buf[n++] = '+';
+                buf[n] = '\0';
+            }
+            return n;
+        }
+        if (sep) {
+            buf[n++] = ',';
+        }
+        memcpy(&buf[n], name, len);
+        n += len;
+        buf[n] = '\0';
+    }
+
+    if (n == 0 && size > 4) {
+        memcpy(buf, "none", 5);
+        n = 4;
+    }
+    return n;
+}
+
+#endif // TECHNOSOFT_REGS_H
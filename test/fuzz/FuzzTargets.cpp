@@ -0,0 +1,180 @@
+/*
+ *  FuzzTargets.cpp
+ *
+ *  Fuzz targets for LoRa packets, MCB messages, reel profiles and MCB motion
+ *  payloads; see FuzzTargets.h.
+ */
+
+#include "FuzzTargets.h"
+#include "sim/FlightSim.h"
+#include "src/ReelProfile.h"
+#include "src/MCBMotionRecord.h"
+
+// Fail so that the fuzzer keeps the input
+#define FUZZ_CHECK(cond) do { if (!(cond)) { __builtin_trap(); } } while (0)
+
+// One loop, throwing away everything sent so that a long run doesn't grow
+static void Step(StratoRATS& rats)
+{
+    RunFirmwareLoop(rats);
+    host::Advance(500);
+    host::zephyr_tx.clear();
+    host::mcb_tx.clear();
+    host::lora_tx.clear();
+    host::log_lines.clear();
+    Serial.Output().clear();
+    ZEPHYR_SERIAL.Output().clear();
+    MCB_SERIAL.Output().clear();
+}
+
+// The instrument for the LoRa and MCB targets, in flight mode so that ECU
+// reports and motion records go into TMs
+static StratoRATS& Instrument()
+{
+    static StratoRATS* rats = nullptr;
+    if (!rats) {
+        host::Reset();
+        host::EraseEEPROM();
+        host::sd_files.clear();
+        host::SetEpoch(1700000000);
+        rats = new StratoRATS();
+        rats->InitializeCore();
+        rats->InstrumentSetup();
+        host::QueueModeChange(MODE_FLIGHT);
+        host::QueueGPS(40.5f, -105.1f, 19000.0f, 1700000000);
+        for (int i = 0; i < 4; i++) {
+            Step(*rats);
+        }
+    }
+    return *rats;
+}
+
+int FuzzLoRa(const uint8_t* data, size_t size)
+{
+    StratoRATS& rats = Instrument();
+    size_t packets = 0;
+    while (size > 0) {
+        size_t len = data[0];
+        if (len > size - 1) {
+            len = size - 1;
+        }
+        host::QueueLoRa(data + 1, len);
+        data += len + 1;
+        size -= len + 1;
+        packets++;
+    }
+    // LoRaRX() takes one packet per loop
+    for (size_t i = 0; i <= packets && !host::lora_rx.empty(); i++) {
+        Step(rats);
+    }
+    FUZZ_CHECK(host::lora_rx.empty());
+    return 0;
+}
+
+int FuzzMCB(const uint8_t* data, size_t size)
+{
+    StratoRATS& rats = Instrument();
+    if (size < 1) {
+        return 0;
+    }
+    if (data[0] & 0x01) {
+        mcbParam.deployLen = 1.0f;
+        host::QueueTC(DEPLOYx);
+        Step(rats);
+    }
+    data++;
+    size--;
+
+    size_t messages = 0;
+    while (size >= 3) {
+        HostMCBMessage_t m = {};
+        m.type = (SerialMessage_t) (ASCII_MESSAGE + data[0] % 4);
+        m.id = data[1];
+        size_t len = data[2];
+        data += 3;
+        size -= 3;
+        if (len > size) {
+            len = size;
+        }
+        if (m.type == BIN_MESSAGE) {
+            m.bin.assign(data, data + len);
+        } else if (m.id == MCB_VOLTAGES) {
+            memcpy(m.voltages, data, (len < sizeof(m.voltages)) ? len : sizeof(m.voltages));
+        } else if (m.id == MCB_MOTION_FAULT) {
+            memcpy(m.fault, data, (len < sizeof(m.fault)) ? len : sizeof(m.fault));
+        } else {
+            m.error.assign((const char*) data, len);
+        }
+        data += len;
+        size -= len;
+        host::mcb_rx.push_back(m);
+        messages++;
+    }
+    for (size_t i = 0; i <= messages && !host::mcb_rx.empty(); i++) {
+        Step(rats);
+    }
+    FUZZ_CHECK(host::mcb_rx.empty());
+    return 0;
+}
+
+int FuzzReelProfile(const uint8_t* data, size_t size)
+{
+    std::string text((const char*) data, size);
+    char err[80];
+    ReelProfile profile;
+    if (profile.Parse(text.c_str(), err, sizeof(err))) {
+        FUZZ_CHECK(profile.NumSteps() <= REEL_PROFILE_MAX_STEPS);
+        for (uint8_t i = 0; i < profile.NumSteps(); i++) {
+            FUZZ_CHECK(profile.Step(i).type <= STEP_DWELL);
+        }
+    } else {
+        FUZZ_CHECK(profile.NumSteps() == 0);
+        FUZZ_CHECK(memchr(err, '\0', sizeof(err)) != nullptr);
+    }
+
+    // And from the card, where the file may be longer than the profile
+    // buffer or hold NULs
+    host::sd_files[REEL_PROFILE_FILE] = std::make_shared<HostFileData_t>(data, data + size);
+    if (profile.Load(err, sizeof(err))) {
+        FUZZ_CHECK(size <= REEL_PROFILE_MAX_BYTES);
+    }
+    return 0;
+}
+
+int FuzzMotionCodec(const uint8_t* data, size_t size)
+{
+    MCBMotionCodec_t codec;
+    uint8_t record[MOTION_TM_SIZE];
+    uint16_t regs[MCBMotionCodec_t::FAULT_REGS];
+    uint16_t elapsed;
+
+    while (size > 0) {
+        size_t n;
+        if (data[0] == MCBMotionCodec_t::FAULT_SYNC) {
+            n = MCBMotionCodec_t::DecodeFault(data, size, regs, elapsed);
+        } else {
+            n = codec.Decode(data, size, record, elapsed);
+            if (n) {
+                float reel_pos;
+                FUZZ_CHECK(MCBMotionReelPos(record, sizeof(record), reel_pos));
+
+                // A record re-encodes to itself
+                MCBMotionCodec_t key;
+                uint8_t encoded[MCBMotionCodec_t::MAX_ENCODED_SIZE];
+                uint8_t again[MOTION_TM_SIZE];
+                uint16_t again_elapsed;
+                size_t len = key.Encode(record, elapsed, false, encoded);
+                FUZZ_CHECK(len <= sizeof(encoded));
+                FUZZ_CHECK(key.Decode(encoded, len, again, again_elapsed) == len);
+                FUZZ_CHECK(memcmp(record, again, sizeof(record)) == 0 && again_elapsed == elapsed);
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        FUZZ_CHECK(n <= size);
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
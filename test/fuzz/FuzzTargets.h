@@ -0,0 +1,37 @@
+/*
+ *  FuzzTargets.h
+ *
+ *  Fuzz targets for the paths that parse bytes RATS does not control. Each
+ *  takes one fuzzer input and returns 0, as LLVMFuzzerTestOneInput() does,
+ *  and traps if it finds an invariant broken:
+ *
+ *  - FuzzLoRa: radio packets, through LoRaRX(). The input is a sequence of
+ *    <length byte><packet>.
+ *  - FuzzMCB: MCB messages, through RunMCBRouter(). The input is a flags
+ *    byte (bit 0: start a reel motion first), then a sequence of
+ *    <type byte><id byte><length byte><data>, where the data is the binary
+ *    message, the voltages or fault words, or the error text.
+ *  - FuzzReelProfile: a profile script, through ReelProfile::Parse() and
+ *    Load().
+ *  - FuzzMotionCodec: an MCBREPORT payload, through MCBMotionCodec and
+ *    MCBMotionReelPos().
+ *
+ *  The LoRa and MCB targets drive one StratoRATS, on the host shims, that
+ *  lives for the whole run. Seed inputs are in corpus/<target>.
+ *
+ *  fuzz_main.cpp builds one target for libFuzzer ("pio run -e fuzz_lora"),
+ *  and test_fuzz runs every target over its seeds in "pio test -e native".
+ */
+
+#ifndef FUZZ_TARGETS_H
+#define FUZZ_TARGETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+int FuzzLoRa(const uint8_t* data, size_t size);
+int FuzzMCB(const uint8_t* data, size_t size);
+int FuzzReelProfile(const uint8_t* data, size_t size);
+int FuzzMotionCodec(const uint8_t* data, size_t size);
+
+#endif // FUZZ_TARGETS_H
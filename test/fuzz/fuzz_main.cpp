@@ -0,0 +1,13 @@
+/*
+ *  fuzz_main.cpp
+ *
+ *  libFuzzer entry point for the target named by FUZZ_TARGET; see the
+ *  fuzz_* environments in platformio.ini.
+ */
+
+#include "FuzzTargets.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    return FUZZ_TARGET(data, size);
+}
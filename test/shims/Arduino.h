@@ -0,0 +1,283 @@
+/*
+ *  Arduino.h (host shim)
+ *
+ *  The part of the Teensy Arduino core that the RATS sources use, for the
+ *  env:native build. Time comes from a virtual clock that only moves when
+ *  a test or the simulator advances it (or delay() is called), so runs are
+ *  deterministic and can be much faster than real time. Pins and analog
+ *  inputs are plain arrays that tests can set and read.
+ */
+
+#ifndef ARDUINO_HOST_SHIM_H
+#define ARDUINO_HOST_SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <array>
+#include <deque>
+#include <string>
+
+typedef unsigned int uint;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define HEX 16
+#define DEC 10
+
+#define A3 17
+#define A17 41
+
+#define DMAMEM
+#define EXTMEM
+#define FLASHMEM
+#define FASTRUN
+#define PROGMEM
+
+#define F_CPU 150000000
+extern volatile uint32_t F_CPU_ACTUAL;
+extern volatile uint32_t F_BUS_ACTUAL;
+
+// ---------------------------------------------------------------------------
+// String
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& c) : s(c) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v, int base = DEC) : s(Integer((long long) v, base)) {}
+    String(unsigned int v, int base = DEC) : s(Integer((long long) v, base)) {}
+    String(long v, int base = DEC) : s(Integer((long long) v, base)) {}
+    String(unsigned long v, int base = DEC) : s(Integer((long long) v, base)) {}
+    String(unsigned char v, int base = DEC) : s(Integer((long long) v, base)) {}
+    String(float v, int decimals = 2) : s(Fixed(v, decimals)) {}
+    String(double v, int decimals = 2) : s(Fixed(v, decimals)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int) s.size(); }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char o) { s += o; return *this; }
+    bool concat(const String& o) { s += o.s; return true; }
+    bool concat(const char* o) { s += o; return true; }
+    bool concat(char o) { s += o; return true; }
+    bool concat(float v) { s += Fixed(v, 2); return true; }
+    bool concat(int v) { s += Integer(v, DEC); return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a) + b.s); }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == o; }
+    bool operator!=(const char* o) const { return s != o; }
+
+private:
+    static std::string Integer(long long v, int base)
+    {
+        char b[72];
+        if (base == HEX) {
+            snprintf(b, sizeof(b), "%llX", (unsigned long long) v);
+        } else {
+            snprintf(b, sizeof(b), "%lld", v);
+        }
+        return b;
+    }
+    static std::string Fixed(double v, int decimals)
+    {
+        char b[64];
+        snprintf(b, sizeof(b), "%.*f", decimals, v);
+        return b;
+    }
+
+    std::string s;
+};
+
+// ---------------------------------------------------------------------------
+// Print / Stream / serial ports
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t n)
+    {
+        for (size_t i = 0; i < n; i++) {
+            write(buf[i]);
+        }
+        return n;
+    }
+    size_t write(char c) { return write((uint8_t) c); }
+    size_t write(const char* str) { return write((const uint8_t*) str, strlen(str)); }
+
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+    size_t println() { return write("\r\n"); }
+
+    int printf(const char* format, ...)
+    {
+        char b[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(b, sizeof(b), format, args);
+        va_end(args);
+        write(b);
+        return n;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+// A serial port. What the firmware writes is kept in Output() (and echoed to
+// stdout if echo is set); what a test puts with Inject() is read back, and
+// passed to rx_tap if one is set.
+class HostSerial : public Stream {
+public:
+    using Print::write;
+    void begin(uint32_t) {}
+    void end() {}
+    void addMemoryForRead(void*, size_t) {}
+    void addMemoryForWrite(void*, size_t) {}
+    operator bool() const { return true; }
+
+    size_t write(uint8_t c) override
+    {
+        tx.push_back((char) c);
+        if (echo) {
+            fputc(c, stdout);
+        }
+        return 1;
+    }
+    int available() override { return (int) rx.size(); }
+    int read() override
+    {
+        if (rx.empty()) {
+            return -1;
+        }
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    int peek() override { return rx.empty() ? -1 : rx.front(); }
+
+    void Inject(const char* text) { Inject((const uint8_t*) text, strlen(text)); }
+    void Inject(const uint8_t* buf, size_t n)
+    {
+        rx.insert(rx.end(), buf, buf + n);
+        if (rx_tap) {
+            rx_tap(buf, n);
+        }
+    }
+    std::string& Output() { return tx; }
+
+    bool echo = false;
+    void (*rx_tap)(const uint8_t* buf, size_t n) = nullptr;
+
+private:
+    std::deque<uint8_t> rx;
+    std::string tx;
+};
+
+extern HostSerial Serial, Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7, Serial8;
+#define SerialUSB Serial
+
+// ---------------------------------------------------------------------------
+// Time
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+class elapsedMillis {
+public:
+    elapsedMillis() : start(millis()) {}
+    elapsedMillis(uint32_t v) : start(millis() - v) {}
+    operator uint32_t() const { return millis() - start; }
+    elapsedMillis& operator=(uint32_t v) { start = millis() - v; return *this; }
+private:
+    uint32_t start;
+};
+
+class elapsedMicros {
+public:
+    elapsedMicros() : start(micros()) {}
+    elapsedMicros(uint32_t v) : start(micros() - v) {}
+    operator uint32_t() const { return micros() - start; }
+    elapsedMicros& operator=(uint32_t v) { start = micros() - v; return *this; }
+private:
+    uint32_t start;
+};
+
+// ---------------------------------------------------------------------------
+// I/O
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+float tempmonGetTemp();
+
+extern "C" uint32_t set_arm_clock(uint32_t frequency);
+void arm_dcache_flush(void* addr, uint32_t size);
+void arm_dcache_flush_delete(void* addr, uint32_t size);
+void noInterrupts();
+void interrupts();
+
+struct CrashReportClass {
+    operator bool() const { return false; }
+    void clear() {}
+};
+extern CrashReportClass CrashReport;
+
+template <class T> T min(T a, T b) { return (a < b) ? a : b; }
+template <class T> T max(T a, T b) { return (a > b) ? a : b; }
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+// ---------------------------------------------------------------------------
+// Host controls, for tests and the simulator
+
+namespace host {
+
+// Move the virtual clock on
+void Advance(uint32_t ms);
+void AdvanceMicros(uint32_t us);
+// Reset the clock, pins, analog inputs, serial ports and the epoch
+void Reset();
+// The value now() returns at millis() == 0
+void SetEpoch(uint32_t epoch);
+
+extern uint8_t pins[64];
+extern uint16_t analog[64];
+extern float cpu_temp;
+
+}
+
+#endif // ARDUINO_HOST_SHIM_H
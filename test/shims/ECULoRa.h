@@ -0,0 +1,63 @@
+/*
+ *  ECULoRa.h (host shim)
+ *
+ *  The ECUComm LoRa link. Messages for the RATS are queued in host::lora_rx
+ *  and handed out in order by ecu_lora_rx(); what the RATS sends is kept in
+ *  host::lora_tx. The link quality that the RATS reads is host::lora_rssi
+ *  and host::lora_snr.
+ */
+
+#ifndef ECULORA_HOST_SHIM_H
+#define ECULORA_HOST_SHIM_H
+
+#include "Arduino.h"
+#include "SPI.h"
+#include <vector>
+
+#define ECU_LORA_DATA_BUFSIZE 240
+
+#define LORA_LEADER   0
+#define LORA_FOLLOWER 1
+
+struct ECULoRaMsg_t {
+    unsigned long count;
+    unsigned long id;
+    uint8_t data_len;
+    uint8_t data[ECU_LORA_DATA_BUFSIZE];
+};
+
+struct ECULoRaConfig_t {
+    uint32_t frequency;
+    uint32_t bandwidth;
+    uint8_t sf;
+    uint8_t power;
+};
+
+bool ECULoRaInit(int role, int timeout_ms, int cs, int rst, int irq, SPIClass* spi, int sck, int miso, int mosi,
+                 long frequency, double bandwidth, int sf, int power);
+bool ecu_lora_rx(ECULoRaMsg_t* msg);
+void ecu_lora_tx(uint8_t* payload, size_t len, bool immediate = false);
+int ecu_lora_rssi();
+float ecu_lora_snr();
+long ecu_lora_frequency_error();
+ECULoRaConfig_t ecu_lora_get_config();
+
+namespace host {
+
+extern std::deque<ECULoRaMsg_t> lora_rx;
+extern std::vector<std::vector<uint8_t>> lora_tx;
+extern int lora_rssi;
+extern float lora_snr;
+extern bool lora_init_ok;
+
+// Queue a packet for the RATS, numbered as the radio numbers them. Packets
+// longer than ECU_LORA_DATA_BUFSIZE are cut, as the radio would.
+void QueueLoRa(const uint8_t* data, size_t len);
+// Messages queued since host::Reset()
+extern uint32_t lora_count;
+// Called with each message as ecu_lora_rx() hands it out, for recording
+extern void (*lora_rx_tap)(const ECULoRaMsg_t& m);
+
+}
+
+#endif // ECULORA_HOST_SHIM_H
@@ -0,0 +1,56 @@
+/*
+ *  ECUReport.h (host shim)
+ *
+ *  ECU report (de)serialization from the ECUComm library. The byte layout
+ *  here is the shim's own: the first three bytes (revision, message type,
+ *  ECU ID) are as on the ECU, the rest is little-endian and only has to
+ *  round-trip through ecu_report_serialize(), which the real library does
+ *  not have.
+ */
+
+#ifndef ECUREPORT_HOST_SHIM_H
+#define ECUREPORT_HOST_SHIM_H
+
+#include "Arduino.h"
+
+#define ECU_REPORT_REV              1
+#define ECU_REPORT_SIZE_BYTES       40
+#define ECU_DATA_REPORT_SIZE_BYTES  36
+
+typedef std::array<uint8_t, ECU_REPORT_SIZE_BYTES> ECUReportBytes_t;
+
+enum ECU_REPORT_TYPE_t : uint8_t {
+    ECU_REPORT_DATA = 1,
+    ECU_REPORT_RAW = 2,
+};
+
+struct ECUReport_t {
+    uint8_t rev;
+    ECU_REPORT_TYPE_t msg_type;
+    uint8_t id;
+
+    // ECU_REPORT_DATA
+    bool gps_valid;
+    bool rs41_valid;
+    bool tsen_valid;
+    float gps_alt;
+    float rs41_airt;
+    float rs41_hum;
+    float rs41_pres;
+    float tsen_airt;
+    float tsen_ptemp;
+    float tsen_pres;
+
+    // ECU_REPORT_RAW
+    uint8_t n_bytes;
+    uint8_t raw[ECU_REPORT_SIZE_BYTES - 4];
+};
+
+std::array<uint8_t, 3> ecu_report_deserialize_rev_msg_type_id(ECUReportBytes_t& bytes);
+ECUReport_t ecu_report_deserialize(ECUReportBytes_t& bytes);
+void ecu_report_print(ECUReport_t& report);
+
+// Host only: the bytes the ECU would send for report
+ECUReportBytes_t ecu_report_serialize(const ECUReport_t& report);
+
+#endif // ECUREPORT_HOST_SHIM_H
@@ -0,0 +1,56 @@
+/*
+ *  EEPROM.h (host shim)
+ *
+ *  The Teensy 4.1's 4284 byte emulated EEPROM, in RAM. host::Reset() does
+ *  not clear it, so a simulated reboot keeps the configuration; call
+ *  host::EraseEEPROM() for a blank part.
+ */
+
+#ifndef EEPROM_HOST_SHIM_H
+#define EEPROM_HOST_SHIM_H
+
+#include "Arduino.h"
+
+#define E2END 4283
+
+class EEPROMClass {
+public:
+    uint8_t read(int addr) const { return Valid(addr) ? bytes[addr] : 0xFF; }
+    void write(int addr, uint8_t value)
+    {
+        if (Valid(addr)) {
+            bytes[addr] = value;
+        }
+    }
+    void update(int addr, uint8_t value) { write(addr, value); }
+    template <typename T> T& get(int addr, T& t) const
+    {
+        uint8_t* p = (uint8_t*) &t;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            p[i] = read(addr + (int) i);
+        }
+        return t;
+    }
+    template <typename T> const T& put(int addr, const T& t)
+    {
+        const uint8_t* p = (const uint8_t*) &t;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            write(addr + (int) i, p[i]);
+        }
+        return t;
+    }
+    uint16_t length() const { return E2END + 1; }
+
+    uint8_t bytes[E2END + 1];
+
+private:
+    static bool Valid(int addr) { return addr >= 0 && addr <= E2END; }
+};
+
+extern EEPROMClass EEPROM;
+
+namespace host {
+void EraseEEPROM();
+}
+
+#endif // EEPROM_HOST_SHIM_H
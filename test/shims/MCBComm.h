@@ -0,0 +1,145 @@
+/*
+ *  MCBComm.h (host shim)
+ *
+ *  The MCB serial protocol. Every TX_* call is recorded in host::mcb_tx and
+ *  passed to host::mcb_device, if one is set, which stands in for the MCB
+ *  and answers by queueing messages in host::mcb_rx. RX() hands those out
+ *  one per call, as the real parser does once a message is complete.
+ */
+
+#ifndef MCBCOMM_HOST_SHIM_H
+#define MCBCOMM_HOST_SHIM_H
+
+#include "Arduino.h"
+#include <vector>
+
+#define MAX_MCB_BINARY  8192
+#define MOTION_TM_SIZE  41
+
+enum SerialMessage_t {
+    NO_MESSAGE,
+    ASCII_MESSAGE,
+    ACK_MESSAGE,
+    BIN_MESSAGE,
+    STRING_MESSAGE,
+};
+
+enum MCBMessages_t : uint8_t {
+    MCB_NO_MESSAGE = 0,
+    // Commands to the MCB
+    MCB_GO_LOW_POWER,
+    MCB_REEL_IN,
+    MCB_REEL_OUT,
+    MCB_IN_NO_LW,
+    MCB_FULL_RETRACT,
+    MCB_CANCEL_MOTION,
+    MCB_ZERO_REEL,
+    MCB_TEMP_LIMITS,
+    MCB_TORQUE_LIMITS,
+    MCB_CURR_LIMITS,
+    MCB_IGNORE_LIMITS,
+    MCB_USE_LIMITS,
+    MCB_GET_EEPROM,
+    MCB_GET_VOLTAGES,
+    MCB_OUT_ACC,
+    MCB_IN_ACC,
+    MCB_CONTROLLERS_ON,
+    MCB_CONTROLLERS_OFF,
+    // Messages from the MCB
+    MCB_MOTION_FINISHED,
+    MCB_MOTION_FAULT,
+    MCB_VOLTAGES,
+    MCB_ERROR,
+    MCB_MOTION_TM,
+    MCB_EEPROM,
+};
+
+// A command sent to the MCB, with up to two parameters
+struct HostMCBCommand_t {
+    uint32_t ms;
+    uint8_t id;
+    float param[2];
+};
+
+// A message from the MCB
+struct HostMCBMessage_t {
+    SerialMessage_t type;
+    uint8_t id;
+    std::vector<uint8_t> bin;       // BIN_MESSAGE
+    float voltages[4];              // MCB_VOLTAGES
+    uint16_t fault[8];              // MCB_MOTION_FAULT
+    std::string error;              // MCB_ERROR
+};
+
+class HostMCBDevice {
+public:
+    virtual ~HostMCBDevice() {}
+    virtual void Command(const HostMCBCommand_t& cmd) = 0;
+};
+
+class MCBComm {
+public:
+    MCBComm(Stream* serial_port) : ack_id(0), rx_buffer(nullptr), rx_buffer_size(0) { (void) serial_port; }
+
+    SerialMessage_t RX();
+
+    bool TX_ASCII(uint8_t msg_id);
+    bool TX_Reel_Out(float num_revs, float speed);
+    bool TX_Reel_In(float num_revs, float speed);
+    bool TX_In_No_LW(float num_revs, float speed);
+    bool TX_Full_Retract(float num_revs, float speed);
+    bool TX_Out_Acc(float acc);
+    bool TX_In_Acc(float acc);
+    bool TX_Torque_Limits(float reel, float lw);
+    bool TX_Curr_Limits(float reel, float lw);
+
+    bool RX_Voltages(float* v1, float* v2, float* v3, float* v4);
+    bool RX_Motion_Fault(uint16_t* f1, uint16_t* f2, uint16_t* f3, uint16_t* f4,
+                         uint16_t* f5, uint16_t* f6, uint16_t* f7, uint16_t* f8);
+    bool RX_Error(char* error, uint16_t size);
+
+    void AssignBinaryRXBuffer(uint8_t* buffer, uint16_t size)
+    {
+        rx_buffer = buffer;
+        rx_buffer_size = size;
+        binary_rx.bin_buffer = buffer;
+    }
+
+    uint8_t ack_id;
+    struct {
+        uint8_t msg_id;
+    } ascii_rx = {0};
+    struct {
+        uint8_t bin_id;
+        uint16_t bin_length;
+        uint8_t* bin_buffer;
+    } binary_rx = {0, 0, nullptr};
+    struct {
+        uint8_t str_id;
+    } string_rx = {0};
+
+private:
+    bool TX(uint8_t id, float p1 = 0, float p2 = 0);
+
+    uint8_t* rx_buffer;
+    uint16_t rx_buffer_size;
+    HostMCBMessage_t last;
+};
+
+namespace host {
+
+extern std::deque<HostMCBMessage_t> mcb_rx;
+extern std::vector<HostMCBCommand_t> mcb_tx;
+extern HostMCBDevice* mcb_device;
+// TX_* calls return false while set
+extern bool mcb_tx_fail;
+// Called with each message as RX() hands it out, for recording
+extern void (*mcb_rx_tap)(const HostMCBMessage_t& m);
+
+void QueueMCBAck(uint8_t id);
+void QueueMCBASCII(uint8_t id);
+void QueueMCBBin(uint8_t id, const uint8_t* data, size_t len);
+
+}
+
+#endif // MCBCOMM_HOST_SHIM_H
@@ -0,0 +1,129 @@
+/*
+ *  SD.h (host shim)
+ *
+ *  An in-RAM SD card with the SdFat calls that the RATS sources use. Files
+ *  are kept in host::sd_files, so tests can put a profile on the card or
+ *  look at what was written. Clearing host::sd_present unmounts the card:
+ *  SD.begin() fails and fatType() is 0.
+ */
+
+#ifndef SD_HOST_SHIM_H
+#define SD_HOST_SHIM_H
+
+#include "Arduino.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+#define BUILTIN_SDCARD 254
+#define FAT_TYPE_EXFAT 64
+
+#define O_READ      0x00
+#define O_RDONLY    0x00
+#define O_WRONLY    0x01
+#define O_RDWR      0x02
+#define O_CREAT     0x40
+#define O_EXCL      0x80
+#define O_TRUNC     0x200
+#define O_APPEND    0x400
+#define FILE_READ   O_READ
+#define FILE_WRITE  (O_RDWR | O_CREAT | O_APPEND)
+
+typedef std::vector<uint8_t> HostFileData_t;
+
+class FsFile {
+public:
+    FsFile() : pos(0) {}
+    explicit FsFile(std::shared_ptr<HostFileData_t> d) : data(d), pos(0) {}
+
+    bool isOpen() const { return (bool) data; }
+    operator bool() const { return isOpen(); }
+    bool close() { data.reset(); return true; }
+    bool sync() { return isOpen(); }
+
+    uint64_t size() const { return data ? data->size() : 0; }
+    uint64_t curPosition() const { return pos; }
+    bool seekSet(uint64_t p)
+    {
+        if (!data) {
+            return false;
+        }
+        pos = p;
+        return true;
+    }
+    // Space is only reserved on a real card; the file stays the same size
+    bool preAllocate(uint64_t) { return isOpen(); }
+    bool truncate() { return truncate(pos); }
+    bool truncate(uint64_t length)
+    {
+        if (!data) {
+            return false;
+        }
+        data->resize(length);
+        if (pos > length) {
+            pos = length;
+        }
+        return true;
+    }
+
+    size_t write(const void* buf, size_t n);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    int read(void* buf, size_t n)
+    {
+        if (!data) {
+            return -1;
+        }
+        size_t left = (pos < data->size()) ? data->size() - pos : 0;
+        if (n > left) {
+            n = left;
+        }
+        if (n) {
+            memcpy(buf, data->data() + pos, n);
+        }
+        pos += n;
+        return (int) n;
+    }
+    int read()
+    {
+        uint8_t c;
+        return (read(&c, 1) == 1) ? c : -1;
+    }
+    int available() const { return (data && pos < data->size()) ? (int) (data->size() - pos) : 0; }
+
+private:
+    std::shared_ptr<HostFileData_t> data;
+    uint64_t pos;
+};
+
+class SdFs {
+public:
+    FsFile open(const char* path, int oflag = O_READ);
+    bool exists(const char* path) const;
+    bool remove(const char* path);
+    // 0 when the card is not mounted
+    uint8_t fatType() const;
+};
+
+class SDClass {
+public:
+    bool begin(uint8_t) { return SdPresent(); }
+    bool exists(const char* path) { return sdfs.exists(path); }
+    FsFile open(const char* path, int oflag = O_READ) { return sdfs.open(path, oflag); }
+    bool remove(const char* path) { return sdfs.remove(path); }
+    SdFs sdfs;
+private:
+    static bool SdPresent();
+};
+
+extern SDClass SD;
+
+namespace host {
+extern std::map<std::string, std::shared_ptr<HostFileData_t>> sd_files;
+extern bool sd_present;
+// Writes fail (return 0) while set, as on a full or failing card
+extern bool sd_write_fail;
+// Put a text file on the card
+void WriteSDFile(const char* path, const char* text);
+}
+
+#endif // SD_HOST_SHIM_H
@@ -0,0 +1,20 @@
+/*
+ *  SPI.h (host shim)
+ */
+
+#ifndef SPI_HOST_SHIM_H
+#define SPI_HOST_SHIM_H
+
+#include "Arduino.h"
+
+class SPIClass {
+public:
+    void begin() {}
+    void setMISO(uint8_t) {}
+    void setMOSI(uint8_t) {}
+    void setSCK(uint8_t) {}
+};
+
+extern SPIClass SPI, SPI1;
+
+#endif // SPI_HOST_SHIM_H
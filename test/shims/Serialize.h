@@ -0,0 +1,26 @@
+/*
+ *  Serialize.h (host shim)
+ *
+ *  The StratoCore buffer packing helpers. Each reads or writes one value at
+ *  *curr_index, in the host's byte order, and advances the index; false if
+ *  it would run past buf_size.
+ */
+
+#ifndef SERIALIZE_HOST_SHIM_H
+#define SERIALIZE_HOST_SHIM_H
+
+#include <stdint.h>
+
+bool BufferAddUInt8(uint8_t data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferAddUInt16(uint16_t data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferAddUInt32(uint32_t data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferAddInt16(int16_t data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferAddFloat(float data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+
+bool BufferGetUInt8(uint8_t* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferGetUInt16(uint16_t* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferGetUInt32(uint32_t* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferGetInt16(int16_t* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+bool BufferGetFloat(float* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index);
+
+#endif // SERIALIZE_HOST_SHIM_H
@@ -0,0 +1,226 @@
+/*
+ *  StratoCore.h (host shim)
+ *
+ *  The StratoCore base class, with the Zephyr link replaced by queues:
+ *
+ *  - What the instrument sends (TM, S, IMR, TC acks) is kept in
+ *    host::zephyr_tx, with its state details, flags and payload.
+ *  - What the OBC sends (mode changes, shutdown warnings, GPS, TCs and the
+ *    TM/S/RA acks) is queued in host::zephyr_rx and handled in RunRouter().
+ *
+ *  Mode handling follows StratoCore: a mode change runs the old mode once
+ *  with MODE_EXIT, then the new one from MODE_ENTRY, and a shutdown warning
+ *  sets MODE_SHUTDOWN. Scheduled actions are passed to ActionHandler() by
+ *  RunScheduler() once the virtual clock reaches them.
+ */
+
+#ifndef STRATOCORE_HOST_SHIM_H
+#define STRATOCORE_HOST_SHIM_H
+
+#include "Arduino.h"
+#include "TimeLib.h"
+#include "SD.h"
+#include "StratoGroundPort.h"
+#include <vector>
+
+#define LOG_ARRAY_SIZE 101
+#define NO_SCHEDULED_ACTION 0
+
+enum Instrument_t : uint8_t {
+    FLOATS,
+    RACHUTS,
+    LPC,
+    RATS,
+};
+
+enum InstMode_t : uint8_t {
+    MODE_STANDBY,
+    MODE_FLIGHT,
+    MODE_LOWPOWER,
+    MODE_SAFETY,
+    MODE_EOF,
+    NUM_MODES,
+};
+
+// Substates common to every mode
+#define MODE_ENTRY      0
+#define MODE_ERROR      252
+#define MODE_SHUTDOWN   253
+#define MODE_EXIT       254
+
+enum StateFlag_t : uint8_t { FINE, WARN, CRIT, NOMESS };
+enum AckFlag_t : uint8_t { NO_ACK, ACK, NAK };
+
+enum Telecommand_t : uint8_t {
+    NO_TELECOMMAND = 0,
+    // MCB telecommands
+    DEPLOYx, DEPLOYv, DEPLOYa, RETRACTx, RETRACTv, RETRACTa, FULLRETRACT, CANCELMOTION, ZEROREEL,
+    TORQUELIMITS, CURRLIMITS, IGNORELIMITS, USELIMITS, GETMCBEEPROM, GETMCBVOLTS, CONTROLLERSON,
+    CONTROLLERSOFF,
+    // RATS telecommands
+    RATSECUDECIMATEFACTOR, RATSREALTIMEMCBON, RATSREALTIMEMCBOFF, RATSLORATXTESTON, RATSLORATXTESTOFF,
+    RATSGETEEPROM, RATSECUTEMP, RATSECUPWRON, RATSECUPWROFF, RATSRS41REGEN, RATSECURS41METADATA,
+    RATSRS41ENON, RATSRS41ENOFF, RATSTSENPOWON, RATSTSENPOWOFF, RATSPAIREDCEU, RATSINFO,
+    RATSPROFILELOAD, RATSPROFILESTART, RATSPROFILEABORT, RATSCONFIGGET, RATSCONFIGSET,
+};
+
+struct ActionFlag_t {
+    bool flag_value;
+    uint8_t stale_count;
+};
+
+// Telecommand parameters, filled in before TCHandler() is called
+struct MCBParam_t {
+    float deployLen, deployVel, deployAcc;
+    float retractLen, retractVel, retractAcc;
+    float torqueLimits[2];
+    float currLimits[2];
+};
+
+struct RATSParam_t {
+    uint16_t decimate_factor;
+    float ecu_tempC;
+    uint8_t paired_ecu;
+    uint8_t config_id;
+    float config_value;
+};
+
+extern MCBParam_t mcbParam;
+extern RATSParam_t ratsParam;
+extern char log_array[LOG_ARRAY_SIZE];
+
+class Scheduler {
+public:
+    // Call ActionHandler(action) seconds from now
+    bool AddAction(uint8_t action, uint32_t seconds);
+    // Pop one action that is due; NO_SCHEDULED_ACTION if none
+    uint8_t NextDue(uint32_t now_ms);
+    void Clear() { pending.clear(); }
+
+private:
+    struct Pending_t {
+        uint32_t due_ms;
+        uint8_t action;
+    };
+    std::vector<Pending_t> pending;
+};
+
+struct GPSData_t {
+    float longitude;
+    float latitude;
+    float altitude;
+    float solar_zenith_angle;
+};
+
+class XMLReader {
+public:
+    GPSData_t zephyr_gps = {0, 0, 0, 0};
+};
+
+class XMLWriter {
+public:
+    void clearTm();
+    void addTm(const uint8_t* buffer, uint16_t size);
+    void addTm(uint8_t data);
+    void addTm(uint16_t data);
+    void addTm(uint32_t data);
+    void setStateDetails(uint8_t flag, String details);
+    void setStateFlagValue(uint8_t flag, StateFlag_t value);
+    void TM();
+    void S();
+    void IMR();
+
+private:
+    std::vector<uint8_t> payload;
+    String details[3];
+    StateFlag_t flags[3] = {NOMESS, NOMESS, NOMESS};
+};
+
+class StratoCore {
+public:
+    StratoCore(Stream* zephyr_serial, Instrument_t instrument);
+    virtual ~StratoCore() {}
+
+    void InitializeCore();
+    void RunMode();
+    void RunRouter();
+    void RunScheduler();
+    void KickWatchdog() {}
+
+    // Host only: the current mode, which StratoCore keeps private
+    InstMode_t HostMode() const { return inst_mode; }
+    uint8_t HostSubstate() const { return inst_substate; }
+
+protected:
+    virtual void InstrumentSetup() = 0;
+    virtual void InstrumentLoop() = 0;
+    virtual void StandbyMode() = 0;
+    virtual void FlightMode() = 0;
+    virtual void LowPowerMode() = 0;
+    virtual void SafetyMode() = 0;
+    virtual void EndOfFlightMode() = 0;
+    virtual bool TCHandler(Telecommand_t telecommand) = 0;
+    virtual void ActionHandler(uint8_t action) = 0;
+
+    XMLWriter zephyrTX;
+    XMLReader zephyrRX;
+    Scheduler scheduler;
+
+    uint8_t inst_substate = MODE_ENTRY;
+    bool time_valid = false;
+
+    AckFlag_t TM_ack_flag = NO_ACK;
+    AckFlag_t S_ack_flag = NO_ACK;
+    AckFlag_t RA_ack_flag = NO_ACK;
+
+private:
+    void ChangeMode(InstMode_t new_mode);
+
+    InstMode_t inst_mode = MODE_STANDBY;
+};
+
+namespace host {
+
+// A message from the instrument to the OBC
+struct ZephyrTX_t {
+    uint32_t ms;
+    std::string type;           // "TM", "S", "IMR" or "TCACK"
+    std::string details[3];
+    StateFlag_t flags[3];
+    std::vector<uint8_t> payload;
+    bool ack;                   // TCACK
+};
+
+// A message from the OBC to the instrument
+struct ZephyrRX_t {
+    enum Type_t : uint8_t { IM, SW, GPS, TC, TM_ACK, S_ACK, RA_ACK } type;
+    InstMode_t mode;            // IM
+    float lat, lon, alt;        // GPS
+    uint32_t epoch;             // GPS
+    Telecommand_t tc;           // TC; set mcbParam/ratsParam first
+    MCBParam_t mcb_param;       // TC: mcbParam and ratsParam when queued
+    RATSParam_t rats_param;
+    AckFlag_t ack;              // *_ACK
+};
+
+extern std::vector<ZephyrTX_t> zephyr_tx;
+extern std::deque<ZephyrRX_t> zephyr_rx;
+
+// Called with each message as RunRouter() takes it from zephyr_rx, and as
+// the instrument sends one, for recording (sim/Recording.h)
+extern void (*zephyr_rx_tap)(const ZephyrRX_t& m);
+extern void (*zephyr_tx_tap)(const ZephyrTX_t& m);
+
+void QueueModeChange(InstMode_t mode);
+void QueueShutdownWarning();
+void QueueGPS(float lat, float lon, float alt, uint32_t epoch);
+void QueueTC(Telecommand_t tc);
+void QueueTMAck(AckFlag_t ack);
+void QueueSAck(AckFlag_t ack);
+
+// Messages of type (and with details[0] containing text, if given)
+size_t CountZephyrTX(const char* type, const char* text = nullptr);
+
+}
+
+#endif // STRATOCORE_HOST_SHIM_H
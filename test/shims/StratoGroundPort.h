@@ -0,0 +1,42 @@
+/*
+ *  StratoGroundPort.h (host shim)
+ *
+ *  The StratoCore debug log. Messages are kept in host::log_lines, with the
+ *  virtual time, and printed to stdout while host::log_echo is set.
+ */
+
+#ifndef STRATOGROUNDPORT_HOST_SHIM_H
+#define STRATOGROUNDPORT_HOST_SHIM_H
+
+#include "Arduino.h"
+#include <deque>
+
+extern Print* debug_serial;
+
+void log_nominal(const char* msg);
+void log_error(const char* msg);
+void log_debug(const char* msg);
+
+namespace host {
+
+enum LogLevel_t : uint8_t { LOG_DEBUG, LOG_NOMINAL, LOG_ERROR };
+
+struct LogLine_t {
+    uint32_t ms;
+    LogLevel_t level;
+    std::string text;
+};
+
+// The most recent log_max_lines lines
+extern std::deque<LogLine_t> log_lines;
+extern size_t log_max_lines;
+extern bool log_echo;
+// Lines at this level and above are kept
+extern LogLevel_t log_level;
+
+// Number of log lines containing text
+size_t CountLog(const char* text);
+
+}
+
+#endif // STRATOGROUNDPORT_HOST_SHIM_H
@@ -0,0 +1,125 @@
+/*
+ *  TeensyEEPROM.h (host shim)
+ *
+ *  The TeensyEEPROM base class on the EEPROM shim: a version word at the
+ *  base address, then each registered value in registration order. If the
+ *  stored version differs, Initialize() writes the defaults and returns
+ *  false.
+ */
+
+#ifndef TEENSYEEPROM_HOST_SHIM_H
+#define TEENSYEEPROM_HOST_SHIM_H
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+class EEPROMDataBase {
+public:
+    virtual ~EEPROMDataBase() {}
+    virtual uint16_t Size() const = 0;
+    // Attach to an EEPROM address; load from it, or store the default there
+    virtual void Attach(uint16_t addr, bool load) = 0;
+    virtual void Bufferize(uint8_t* buf) const = 0;
+};
+
+template <typename T>
+class EEPROMData : public EEPROMDataBase {
+public:
+    EEPROMData(T default_value) : value(default_value), address(0), attached(false) {}
+
+    T Read() const { return value; }
+    bool Write(T new_value)
+    {
+        value = new_value;
+        if (attached) {
+            EEPROM.put(address, value);
+        }
+        return true;
+    }
+
+    uint16_t Size() const override { return sizeof(T); }
+    void Attach(uint16_t addr, bool load) override
+    {
+        address = addr;
+        attached = true;
+        if (load) {
+            EEPROM.get(address, value);
+        } else {
+            EEPROM.put(address, value);
+        }
+    }
+    void Bufferize(uint8_t* buf) const override { memcpy(buf, &value, sizeof(T)); }
+
+private:
+    T value;
+    uint16_t address;
+    bool attached;
+};
+
+class TeensyEEPROM {
+public:
+    TeensyEEPROM(uint16_t version, uint16_t base_address)
+        : version(version), base_address(base_address), num_data(0) {}
+    virtual ~TeensyEEPROM() {}
+
+    bool Initialize()
+    {
+        num_data = 0;
+        RegisterAll();
+
+        uint16_t stored = 0;
+        EEPROM.get(base_address, stored);
+        bool load = (stored == version);
+
+        uint16_t addr = base_address + sizeof(version);
+        for (uint8_t i = 0; i < num_data; i++) {
+            data[i]->Attach(addr, load);
+            addr += data[i]->Size();
+        }
+        if (!load) {
+            EEPROM.put(base_address, version);
+        }
+        return load;
+    }
+
+    // The values in registration order, after the version. Returns the
+    // length, or 0 if it does not fit.
+    uint16_t Bufferize(uint8_t* buf, uint16_t size)
+    {
+        uint16_t n = 0;
+        if (size < sizeof(version)) {
+            return 0;
+        }
+        memcpy(buf, &version, sizeof(version));
+        n += sizeof(version);
+        for (uint8_t i = 0; i < num_data; i++) {
+            if (n + data[i]->Size() > size) {
+                return 0;
+            }
+            data[i]->Bufferize(buf + n);
+            n += data[i]->Size();
+        }
+        return n;
+    }
+
+protected:
+    virtual void RegisterAll() = 0;
+
+    bool Register(EEPROMDataBase* d)
+    {
+        if (num_data >= MAX_DATA) {
+            return false;
+        }
+        data[num_data++] = d;
+        return true;
+    }
+
+private:
+    static const uint8_t MAX_DATA = 64;
+    uint16_t version;
+    uint16_t base_address;
+    EEPROMDataBase* data[MAX_DATA];
+    uint8_t num_data;
+};
+
+#endif // TEENSYEEPROM_HOST_SHIM_H
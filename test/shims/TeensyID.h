@@ -0,0 +1,17 @@
+/*
+ *  TeensyID.h (host shim)
+ */
+
+#ifndef TEENSYID_HOST_SHIM_H
+#define TEENSYID_HOST_SHIM_H
+
+#include "Arduino.h"
+
+// Fills in host::mac, 04:E9:E5:00:00:01 unless a test changes it
+void teensyMAC(uint8_t* mac);
+
+namespace host {
+extern uint8_t mac[6];
+}
+
+#endif // TEENSYID_HOST_SHIM_H
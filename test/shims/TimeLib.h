@@ -0,0 +1,16 @@
+/*
+ *  TimeLib.h (host shim)
+ *
+ *  now() follows the virtual clock in Arduino.h, from the epoch set with
+ *  host::SetEpoch().
+ */
+
+#ifndef TIMELIB_HOST_SHIM_H
+#define TIMELIB_HOST_SHIM_H
+
+#include "Arduino.h"
+
+time_t now();
+void setTime(time_t t);
+
+#endif // TIMELIB_HOST_SHIM_H
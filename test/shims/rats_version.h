@@ -0,0 +1,4 @@
+#ifndef RATS_VERSION_H
+#define RATS_VERSION_H
+#define RATS_VERSION "native"
+#endif // RATS_VERSION_H
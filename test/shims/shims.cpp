@@ -0,0 +1,730 @@
+/*
+ *  shims.cpp
+ *
+ *  Definitions for the host shims in this directory.
+ */
+
+#include "Arduino.h"
+#include "TimeLib.h"
+#include "SPI.h"
+#include "SD.h"
+#include "EEPROM.h"
+#include "TeensyID.h"
+#include "Serialize.h"
+#include "StratoGroundPort.h"
+#include "StratoCore.h"
+#include "MCBComm.h"
+#include "ECULoRa.h"
+#include "ECUReport.h"
+
+// ---------------------------------------------------------------------------
+// Arduino core
+
+HostSerial Serial, Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7, Serial8;
+CrashReportClass CrashReport;
+SPIClass SPI, SPI1;
+
+volatile uint32_t F_CPU_ACTUAL = F_CPU;
+volatile uint32_t F_BUS_ACTUAL = F_CPU / 4;
+
+static uint64_t now_us = 0;
+static uint32_t epoch_at_zero = 0;
+
+namespace host {
+uint8_t pins[64];
+uint16_t analog[64];
+float cpu_temp = 40.0f;
+uint8_t mac[6] = {0x04, 0xE9, 0xE5, 0x00, 0x00, 0x01};
+
+void Advance(uint32_t ms) { now_us += (uint64_t) ms * 1000; }
+void AdvanceMicros(uint32_t us) { now_us += us; }
+void SetEpoch(uint32_t epoch) { epoch_at_zero = epoch; }
+}
+
+uint32_t millis() { return (uint32_t) (now_us / 1000); }
+uint32_t micros() { return (uint32_t) now_us; }
+void delay(uint32_t ms) { host::Advance(ms); }
+void delayMicroseconds(uint32_t us) { host::AdvanceMicros(us); }
+void yield() {}
+
+time_t now() { return (time_t) (epoch_at_zero + (uint32_t) (now_us / 1000000)); }
+void setTime(time_t t) { epoch_at_zero = (uint32_t) t - (uint32_t) (now_us / 1000000); }
+
+// On the Teensy time() reads the RTC that setTime() sets, so here it follows
+// the virtual clock too, in place of the host's
+time_t time(time_t* t) noexcept
+{
+    time_t epoch = now();
+    if (t) {
+        *t = epoch;
+    }
+    return epoch;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t value) { host::pins[pin & 63] = value ? HIGH : LOW; }
+int digitalRead(uint8_t pin) { return host::pins[pin & 63]; }
+int analogRead(uint8_t pin) { return host::analog[pin & 63]; }
+float tempmonGetTemp() { return host::cpu_temp; }
+
+// As on the Teensy 4.x, the peripheral bus runs at up to 150 MHz from an
+// integer divider of the core clock.
+extern "C" uint32_t set_arm_clock(uint32_t frequency)
+{
+    uint32_t div = (frequency + 150000000 - 1) / 150000000;
+    if (div < 1) {
+        div = 1;
+    }
+    F_CPU_ACTUAL = frequency;
+    F_BUS_ACTUAL = frequency / div;
+    return frequency;
+}
+
+void arm_dcache_flush(void*, uint32_t) {}
+void arm_dcache_flush_delete(void*, uint32_t) {}
+void noInterrupts() {}
+void interrupts() {}
+
+void teensyMAC(uint8_t* mac) { memcpy(mac, host::mac, sizeof(host::mac)); }
+
+// ---------------------------------------------------------------------------
+// EEPROM and SD card
+
+EEPROMClass EEPROM;
+SDClass SD;
+
+namespace host {
+std::map<std::string, std::shared_ptr<HostFileData_t>> sd_files;
+bool sd_present = true;
+bool sd_write_fail = false;
+
+void EraseEEPROM() { memset(EEPROM.bytes, 0xFF, sizeof(EEPROM.bytes)); }
+
+void WriteSDFile(const char* path, const char* text)
+{
+    sd_files[path] = std::make_shared<HostFileData_t>(text, text + strlen(text));
+}
+}
+
+static struct EEPROMEraser {
+    EEPROMEraser() { host::EraseEEPROM(); }
+} eeprom_eraser;
+
+size_t FsFile::write(const void* buf, size_t n)
+{
+    if (!data || host::sd_write_fail) {
+        return 0;
+    }
+    if (pos + n > data->size()) {
+        data->resize(pos + n);
+    }
+    memcpy(data->data() + pos, buf, n);
+    pos += n;
+    return n;
+}
+
+FsFile SdFs::open(const char* path, int oflag)
+{
+    if (!host::sd_present) {
+        return FsFile();
+    }
+    auto it = host::sd_files.find(path);
+    if (it == host::sd_files.end()) {
+        if (!(oflag & O_CREAT)) {
+            return FsFile();
+        }
+        auto d = std::make_shared<HostFileData_t>();
+        host::sd_files[path] = d;
+        return FsFile(d);
+    }
+    if ((oflag & O_CREAT) && (oflag & O_EXCL)) {
+        return FsFile();
+    }
+    if (oflag & O_TRUNC) {
+        it->second->clear();
+    }
+    FsFile f(it->second);
+    if (oflag & O_APPEND) {
+        f.seekSet(f.size());
+    }
+    return f;
+}
+
+bool SdFs::exists(const char* path) const
+{
+    return host::sd_present && host::sd_files.count(path) != 0;
+}
+
+bool SdFs::remove(const char* path)
+{
+    return host::sd_present && host::sd_files.erase(path) != 0;
+}
+
+bool SDClass::SdPresent() { return host::sd_present; }
+uint8_t SdFs::fatType() const { return host::sd_present ? FAT_TYPE_EXFAT : 0; }
+
+// ---------------------------------------------------------------------------
+// StratoCore: Serialize
+
+template <typename T>
+static bool Add(T data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index)
+{
+    if (*curr_index + sizeof(T) > buf_size) {
+        return false;
+    }
+    memcpy(buffer + *curr_index, &data, sizeof(T));
+    *curr_index += sizeof(T);
+    return true;
+}
+
+template <typename T>
+static bool Get(T* data, uint8_t* buffer, uint16_t buf_size, uint16_t* curr_index)
+{
+    if (*curr_index + sizeof(T) > buf_size) {
+        return false;
+    }
+    memcpy(data, buffer + *curr_index, sizeof(T));
+    *curr_index += sizeof(T);
+    return true;
+}
+
+bool BufferAddUInt8(uint8_t d, uint8_t* b, uint16_t s, uint16_t* i) { return Add(d, b, s, i); }
+bool BufferAddUInt16(uint16_t d, uint8_t* b, uint16_t s, uint16_t* i) { return Add(d, b, s, i); }
+bool BufferAddUInt32(uint32_t d, uint8_t* b, uint16_t s, uint16_t* i) { return Add(d, b, s, i); }
+bool BufferAddInt16(int16_t d, uint8_t* b, uint16_t s, uint16_t* i) { return Add(d, b, s, i); }
+bool BufferAddFloat(float d, uint8_t* b, uint16_t s, uint16_t* i) { return Add(d, b, s, i); }
+bool BufferGetUInt8(uint8_t* d, uint8_t* b, uint16_t s, uint16_t* i) { return Get(d, b, s, i); }
+bool BufferGetUInt16(uint16_t* d, uint8_t* b, uint16_t s, uint16_t* i) { return Get(d, b, s, i); }
+bool BufferGetUInt32(uint32_t* d, uint8_t* b, uint16_t s, uint16_t* i) { return Get(d, b, s, i); }
+bool BufferGetInt16(int16_t* d, uint8_t* b, uint16_t s, uint16_t* i) { return Get(d, b, s, i); }
+bool BufferGetFloat(float* d, uint8_t* b, uint16_t s, uint16_t* i) { return Get(d, b, s, i); }
+
+// ---------------------------------------------------------------------------
+// StratoCore: log
+
+Print* debug_serial = &Serial;
+
+namespace host {
+std::deque<LogLine_t> log_lines;
+size_t log_max_lines = 100000;
+bool log_echo = false;
+LogLevel_t log_level = LOG_NOMINAL;
+
+size_t CountLog(const char* text)
+{
+    size_t n = 0;
+    for (const LogLine_t& l : log_lines) {
+        if (l.text.find(text) != std::string::npos) {
+            n++;
+        }
+    }
+    return n;
+}
+}
+
+static void Log(host::LogLevel_t level, const char* msg)
+{
+    if (level < host::log_level) {
+        return;
+    }
+    host::log_lines.push_back({millis(), level, msg});
+    if (host::log_lines.size() > host::log_max_lines) {
+        host::log_lines.pop_front();
+    }
+    if (host::log_echo) {
+        printf("%10.3f %s%s\n", millis() / 1000.0, (level == host::LOG_ERROR) ? "ERR: " : "", msg);
+    }
+}
+
+void log_nominal(const char* msg) { Log(host::LOG_NOMINAL, msg); }
+void log_error(const char* msg) { Log(host::LOG_ERROR, msg); }
+void log_debug(const char* msg) { Log(host::LOG_DEBUG, msg); }
+
+// ---------------------------------------------------------------------------
+// StratoCore: Zephyr link, scheduler and modes
+
+MCBParam_t mcbParam;
+RATSParam_t ratsParam;
+char log_array[LOG_ARRAY_SIZE];
+
+namespace host {
+std::vector<ZephyrTX_t> zephyr_tx;
+std::deque<ZephyrRX_t> zephyr_rx;
+void (*zephyr_rx_tap)(const ZephyrRX_t& m) = nullptr;
+void (*zephyr_tx_tap)(const ZephyrTX_t& m) = nullptr;
+
+static void Queue(ZephyrRX_t::Type_t type, ZephyrRX_t m = ZephyrRX_t())
+{
+    m.type = type;
+    zephyr_rx.push_back(m);
+}
+
+void QueueModeChange(InstMode_t mode) { ZephyrRX_t m = {}; m.mode = mode; Queue(ZephyrRX_t::IM, m); }
+void QueueShutdownWarning() { Queue(ZephyrRX_t::SW); }
+void QueueGPS(float lat, float lon, float alt, uint32_t epoch)
+{
+    ZephyrRX_t m = {};
+    m.lat = lat;
+    m.lon = lon;
+    m.alt = alt;
+    m.epoch = epoch;
+    Queue(ZephyrRX_t::GPS, m);
+}
+void QueueTC(Telecommand_t tc)
+{
+    ZephyrRX_t m = {};
+    m.tc = tc;
+    m.mcb_param = mcbParam;
+    m.rats_param = ratsParam;
+    Queue(ZephyrRX_t::TC, m);
+}
+void QueueTMAck(AckFlag_t ack) { ZephyrRX_t m = {}; m.ack = ack; Queue(ZephyrRX_t::TM_ACK, m); }
+void QueueSAck(AckFlag_t ack) { ZephyrRX_t m = {}; m.ack = ack; Queue(ZephyrRX_t::S_ACK, m); }
+
+size_t CountZephyrTX(const char* type, const char* text)
+{
+    size_t n = 0;
+    for (const ZephyrTX_t& t : zephyr_tx) {
+        if (t.type == type && (!text || t.details[0].find(text) != std::string::npos)) {
+            n++;
+        }
+    }
+    return n;
+}
+}
+
+bool Scheduler::AddAction(uint8_t action, uint32_t seconds)
+{
+    pending.push_back({millis() + seconds * 1000, action});
+    return true;
+}
+
+uint8_t Scheduler::NextDue(uint32_t now_ms)
+{
+    for (size_t i = 0; i < pending.size(); i++) {
+        if ((int32_t) (now_ms - pending[i].due_ms) >= 0) {
+            uint8_t action = pending[i].action;
+            pending.erase(pending.begin() + i);
+            return action;
+        }
+    }
+    return NO_SCHEDULED_ACTION;
+}
+
+void XMLWriter::clearTm()
+{
+    payload.clear();
+    for (int i = 0; i < 3; i++) {
+        details[i] = "";
+        flags[i] = NOMESS;
+    }
+}
+
+void XMLWriter::addTm(const uint8_t* buffer, uint16_t size) { payload.insert(payload.end(), buffer, buffer + size); }
+void XMLWriter::addTm(uint8_t data) { payload.push_back(data); }
+void XMLWriter::addTm(uint16_t data) { addTm((const uint8_t*) &data, sizeof(data)); }
+void XMLWriter::addTm(uint32_t data) { addTm((const uint8_t*) &data, sizeof(data)); }
+
+void XMLWriter::setStateDetails(uint8_t flag, String d)
+{
+    if (flag >= 1 && flag <= 3) {
+        details[flag - 1] = d;
+    }
+}
+
+void XMLWriter::setStateFlagValue(uint8_t flag, StateFlag_t value)
+{
+    if (flag >= 1 && flag <= 3) {
+        flags[flag - 1] = value;
+    }
+}
+
+static void Send(const char* type, const String* details, const StateFlag_t* flags, const std::vector<uint8_t>& payload,
+                 bool ack = false)
+{
+    host::ZephyrTX_t t;
+    t.ms = millis();
+    t.type = type;
+    for (int i = 0; i < 3; i++) {
+        t.details[i] = details ? details[i].c_str() : "";
+        t.flags[i] = flags ? flags[i] : NOMESS;
+    }
+    t.payload = payload;
+    t.ack = ack;
+    host::zephyr_tx.push_back(t);
+    if (host::zephyr_tx_tap) {
+        host::zephyr_tx_tap(t);
+    }
+}
+
+void XMLWriter::TM() { Send("TM", details, flags, payload); }
+void XMLWriter::S() { Send("S", nullptr, nullptr, std::vector<uint8_t>()); }
+void XMLWriter::IMR() { Send("IMR", nullptr, nullptr, std::vector<uint8_t>()); }
+
+StratoCore::StratoCore(Stream*, Instrument_t) {}
+
+void StratoCore::InitializeCore()
+{
+    inst_mode = MODE_STANDBY;
+    inst_substate = MODE_ENTRY;
+}
+
+void StratoCore::RunMode()
+{
+    switch (inst_mode) {
+    case MODE_STANDBY:  StandbyMode(); break;
+    case MODE_FLIGHT:   FlightMode(); break;
+    case MODE_LOWPOWER: LowPowerMode(); break;
+    case MODE_SAFETY:   SafetyMode(); break;
+    case MODE_EOF:      EndOfFlightMode(); break;
+    default:            break;
+    }
+}
+
+void StratoCore::ChangeMode(InstMode_t new_mode)
+{
+    if (new_mode == inst_mode) {
+        return;
+    }
+    inst_substate = MODE_EXIT;
+    RunMode();
+    inst_mode = new_mode;
+    inst_substate = MODE_ENTRY;
+}
+
+void StratoCore::RunRouter()
+{
+    while (!host::zephyr_rx.empty()) {
+        host::ZephyrRX_t m = host::zephyr_rx.front();
+        host::zephyr_rx.pop_front();
+        if (m.type == host::ZephyrRX_t::TC) {
+            mcbParam = m.mcb_param;
+            ratsParam = m.rats_param;
+        }
+        if (host::zephyr_rx_tap) {
+            host::zephyr_rx_tap(m);
+        }
+
+        switch (m.type) {
+        case host::ZephyrRX_t::IM:
+            ChangeMode(m.mode);
+            break;
+        case host::ZephyrRX_t::SW:
+            inst_substate = MODE_SHUTDOWN;
+            break;
+        case host::ZephyrRX_t::GPS:
+            zephyrRX.zephyr_gps.latitude = m.lat;
+            zephyrRX.zephyr_gps.longitude = m.lon;
+            zephyrRX.zephyr_gps.altitude = m.alt;
+            setTime(m.epoch);
+            time_valid = true;
+            break;
+        case host::ZephyrRX_t::TC:
+        {
+            bool ack = TCHandler(m.tc);
+            Send("TCACK", nullptr, nullptr, std::vector<uint8_t>(), ack);
+            break;
+        }
+        case host::ZephyrRX_t::TM_ACK:
+            TM_ack_flag = m.ack;
+            break;
+        case host::ZephyrRX_t::S_ACK:
+            S_ack_flag = m.ack;
+            break;
+        case host::ZephyrRX_t::RA_ACK:
+            RA_ack_flag = m.ack;
+            break;
+        }
+    }
+}
+
+void StratoCore::RunScheduler()
+{
+    uint8_t action;
+    while ((action = scheduler.NextDue(millis())) != NO_SCHEDULED_ACTION) {
+        ActionHandler(action);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MCBComm
+
+namespace host {
+std::deque<HostMCBMessage_t> mcb_rx;
+std::vector<HostMCBCommand_t> mcb_tx;
+HostMCBDevice* mcb_device = nullptr;
+bool mcb_tx_fail = false;
+void (*mcb_rx_tap)(const HostMCBMessage_t& m) = nullptr;
+
+void QueueMCBAck(uint8_t id)
+{
+    HostMCBMessage_t m = {};
+    m.type = ACK_MESSAGE;
+    m.id = id;
+    mcb_rx.push_back(m);
+}
+
+void QueueMCBASCII(uint8_t id)
+{
+    HostMCBMessage_t m = {};
+    m.type = ASCII_MESSAGE;
+    m.id = id;
+    mcb_rx.push_back(m);
+}
+
+void QueueMCBBin(uint8_t id, const uint8_t* data, size_t len)
+{
+    HostMCBMessage_t m = {};
+    m.type = BIN_MESSAGE;
+    m.id = id;
+    m.bin.assign(data, data + len);
+    mcb_rx.push_back(m);
+}
+}
+
+SerialMessage_t MCBComm::RX()
+{
+    if (host::mcb_rx.empty()) {
+        return NO_MESSAGE;
+    }
+    last = host::mcb_rx.front();
+    host::mcb_rx.pop_front();
+    if (host::mcb_rx_tap) {
+        host::mcb_rx_tap(last);
+    }
+
+    switch (last.type) {
+    case ACK_MESSAGE:
+        ack_id = last.id;
+        break;
+    case ASCII_MESSAGE:
+        ascii_rx.msg_id = last.id;
+        break;
+    case STRING_MESSAGE:
+        string_rx.str_id = last.id;
+        break;
+    case BIN_MESSAGE:
+    {
+        binary_rx.bin_id = last.id;
+        size_t n = last.bin.size();
+        if (n > rx_buffer_size) {
+            n = rx_buffer_size;
+        }
+        if (rx_buffer && n) {
+            memcpy(rx_buffer, last.bin.data(), n);
+        }
+        binary_rx.bin_length = (uint16_t) n;
+        break;
+    }
+    default:
+        break;
+    }
+    return last.type;
+}
+
+bool MCBComm::TX(uint8_t id, float p1, float p2)
+{
+    if (host::mcb_tx_fail) {
+        return false;
+    }
+    HostMCBCommand_t cmd = {millis(), id, {p1, p2}};
+    host::mcb_tx.push_back(cmd);
+    if (host::mcb_device) {
+        host::mcb_device->Command(cmd);
+    }
+    return true;
+}
+
+bool MCBComm::TX_ASCII(uint8_t msg_id) { return TX(msg_id); }
+bool MCBComm::TX_Reel_Out(float num_revs, float speed) { return TX(MCB_REEL_OUT, num_revs, speed); }
+bool MCBComm::TX_Reel_In(float num_revs, float speed) { return TX(MCB_REEL_IN, num_revs, speed); }
+bool MCBComm::TX_In_No_LW(float num_revs, float speed) { return TX(MCB_IN_NO_LW, num_revs, speed); }
+bool MCBComm::TX_Full_Retract(float num_revs, float speed) { return TX(MCB_FULL_RETRACT, num_revs, speed); }
+bool MCBComm::TX_Out_Acc(float acc) { return TX(MCB_OUT_ACC, acc); }
+bool MCBComm::TX_In_Acc(float acc) { return TX(MCB_IN_ACC, acc); }
+bool MCBComm::TX_Torque_Limits(float reel, float lw) { return TX(MCB_TORQUE_LIMITS, reel, lw); }
+bool MCBComm::TX_Curr_Limits(float reel, float lw) { return TX(MCB_CURR_LIMITS, reel, lw); }
+
+bool MCBComm::RX_Voltages(float* v1, float* v2, float* v3, float* v4)
+{
+    if (last.type != ASCII_MESSAGE || last.id != MCB_VOLTAGES) {
+        return false;
+    }
+    *v1 = last.voltages[0];
+    *v2 = last.voltages[1];
+    *v3 = last.voltages[2];
+    *v4 = last.voltages[3];
+    return true;
+}
+
+bool MCBComm::RX_Motion_Fault(uint16_t* f1, uint16_t* f2, uint16_t* f3, uint16_t* f4,
+                              uint16_t* f5, uint16_t* f6, uint16_t* f7, uint16_t* f8)
+{
+    if (last.type != ASCII_MESSAGE || last.id != MCB_MOTION_FAULT) {
+        return false;
+    }
+    uint16_t* f[8] = {f1, f2, f3, f4, f5, f6, f7, f8};
+    for (int i = 0; i < 8; i++) {
+        *f[i] = last.fault[i];
+    }
+    return true;
+}
+
+bool MCBComm::RX_Error(char* error, uint16_t size)
+{
+    if (size == 0) {
+        return false;
+    }
+    snprintf(error, size, "%s", last.error.c_str());
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ECULoRa and ECUReport
+
+namespace host {
+std::deque<ECULoRaMsg_t> lora_rx;
+std::vector<std::vector<uint8_t>> lora_tx;
+int lora_rssi = -90;
+float lora_snr = 8.0f;
+bool lora_init_ok = true;
+uint32_t lora_count = 0;
+void (*lora_rx_tap)(const ECULoRaMsg_t& m) = nullptr;
+
+void QueueLoRa(const uint8_t* data, size_t len)
+{
+    ECULoRaMsg_t m = {};
+    if (len > ECU_LORA_DATA_BUFSIZE) {
+        len = ECU_LORA_DATA_BUFSIZE;
+    }
+    m.count = ++lora_count;
+    m.id = lora_count;
+    m.data_len = (uint8_t) len;
+    memcpy(m.data, data, len);
+    lora_rx.push_back(m);
+}
+}
+
+bool ECULoRaInit(int, int, int, int, int, SPIClass*, int, int, int, long, double, int, int)
+{
+    return host::lora_init_ok;
+}
+
+bool ecu_lora_rx(ECULoRaMsg_t* msg)
+{
+    if (host::lora_rx.empty()) {
+        return false;
+    }
+    *msg = host::lora_rx.front();
+    host::lora_rx.pop_front();
+    if (host::lora_rx_tap) {
+        host::lora_rx_tap(*msg);
+    }
+    return true;
+}
+
+void ecu_lora_tx(uint8_t* payload, size_t len, bool)
+{
+    host::lora_tx.push_back(std::vector<uint8_t>(payload, payload + len));
+}
+
+int ecu_lora_rssi() { return host::lora_rssi; }
+float ecu_lora_snr() { return host::lora_snr; }
+long ecu_lora_frequency_error() { return 0; }
+ECULoRaConfig_t ecu_lora_get_config() { return {915000000, 125000, 9, 20}; }
+
+// Data reports: flags (gps, rs41, tsen valid), then the floats in
+// ECUReport_t order. Raw reports: n_bytes, then the bytes.
+static const size_t ECU_FLOATS = 7;
+
+std::array<uint8_t, 3> ecu_report_deserialize_rev_msg_type_id(ECUReportBytes_t& bytes)
+{
+    return {bytes[0], bytes[1], bytes[2]};
+}
+
+ECUReport_t ecu_report_deserialize(ECUReportBytes_t& bytes)
+{
+    ECUReport_t r = {};
+    r.rev = bytes[0];
+    r.msg_type = (ECU_REPORT_TYPE_t) bytes[1];
+    r.id = bytes[2];
+    if (r.msg_type == ECU_REPORT_DATA) {
+        r.gps_valid = bytes[3] & 1;
+        r.rs41_valid = bytes[3] & 2;
+        r.tsen_valid = bytes[3] & 4;
+        float* f[ECU_FLOATS] = {&r.gps_alt, &r.rs41_airt, &r.rs41_hum, &r.rs41_pres,
+                                &r.tsen_airt, &r.tsen_ptemp, &r.tsen_pres};
+        for (size_t i = 0; i < ECU_FLOATS; i++) {
+            memcpy(f[i], &bytes[4 + 4 * i], sizeof(float));
+        }
+    } else if (r.msg_type == ECU_REPORT_RAW) {
+        r.n_bytes = bytes[3];
+        memcpy(r.raw, &bytes[4], sizeof(r.raw));
+    }
+    return r;
+}
+
+ECUReportBytes_t ecu_report_serialize(const ECUReport_t& r)
+{
+    ECUReportBytes_t bytes = {0};
+    bytes[0] = r.rev ? r.rev : ECU_REPORT_REV;
+    bytes[1] = r.msg_type;
+    bytes[2] = r.id;
+    if (r.msg_type == ECU_REPORT_DATA) {
+        bytes[3] = (r.gps_valid ? 1 : 0) | (r.rs41_valid ? 2 : 0) | (r.tsen_valid ? 4 : 0);
+        const float f[ECU_FLOATS] = {r.gps_alt, r.rs41_airt, r.rs41_hum, r.rs41_pres,
+                                     r.tsen_airt, r.tsen_ptemp, r.tsen_pres};
+        for (size_t i = 0; i < ECU_FLOATS; i++) {
+            memcpy(&bytes[4 + 4 * i], &f[i], sizeof(float));
+        }
+    } else if (r.msg_type == ECU_REPORT_RAW) {
+        bytes[3] = r.n_bytes;
+        memcpy(&bytes[4], r.raw, sizeof(r.raw));
+    }
+    return bytes;
+}
+
+void ecu_report_print(ECUReport_t&) {}
+
+// ---------------------------------------------------------------------------
+
+namespace host {
+void Reset()
+{
+    now_us = 0;
+    epoch_at_zero = 0;
+    memset(pins, 0, sizeof(pins));
+    memset(analog, 0, sizeof(analog));
+    cpu_temp = 40.0f;
+    F_CPU_ACTUAL = F_CPU;
+    F_BUS_ACTUAL = F_CPU / 4;
+    HostSerial* ports[] = {&Serial, &Serial1, &Serial2, &Serial3, &Serial4, &Serial5, &Serial6, &Serial7, &Serial8};
+    for (HostSerial* p : ports) {
+        while (p->read() >= 0) {
+        }
+        p->Output().clear();
+        p->rx_tap = nullptr;
+    }
+    log_lines.clear();
+    zephyr_tx.clear();
+    zephyr_rx.clear();
+    zephyr_rx_tap = nullptr;
+    zephyr_tx_tap = nullptr;
+    mcb_rx.clear();
+    mcb_rx_tap = nullptr;
+    mcb_tx.clear();
+    mcb_device = nullptr;
+    mcb_tx_fail = false;
+    lora_rx.clear();
+    lora_tx.clear();
+    lora_rssi = -90;
+    lora_snr = 8.0f;
+    lora_init_ok = true;
+    lora_count = 0;
+    lora_rx_tap = nullptr;
+    sd_present = true;
+    sd_write_fail = false;
+    memset(&mcbParam, 0, sizeof(mcbParam));
+    memset(&ratsParam, 0, sizeof(ratsParam));
+}
+}
@@ -0,0 +1,130 @@
+// CRC32 and the MCB motion record codec, on the host: "pio test -e native"
+
+#include <unity.h>
+#include "src/CRC32.h"
+#include "src/MCBMotionCodec.h"
+
+typedef MCBMotionCodec<12> Codec_t;
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t CRC32(const char* text)
+{
+    return ~CRC32Update(0xFFFFFFFF, (const uint8_t*) text, strlen(text));
+}
+
+void test_crc32_check_value()
+{
+    // The standard CRC-32 check value
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, CRC32("123456789"));
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, CRC32(""));
+}
+
+void test_crc32_incremental()
+{
+    const uint8_t* data = (const uint8_t*) "123456789";
+    uint32_t crc = 0xFFFFFFFF;
+    crc = CRC32Update(crc, data, 4);
+    crc = CRC32Update(crc, data + 4, 5);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, ~crc);
+}
+
+void test_codec_round_trip()
+{
+    Codec_t enc, dec;
+    uint8_t records[4][12];
+    for (int r = 0; r < 4; r++) {
+        for (int i = 0; i < 12; i++) {
+            records[r][i] = (uint8_t) (i * 7);
+        }
+        records[r][3] = (uint8_t) r;
+        records[r][11] = (uint8_t) (r * 3);
+    }
+
+    uint8_t payload[4 * Codec_t::MAX_ENCODED_SIZE];
+    size_t len = 0;
+    for (int r = 0; r < 4; r++) {
+        size_t n = enc.Encode(records[r], (uint16_t) (r * 10), true, &payload[len]);
+        enc.Commit(records[r], &payload[len]);
+        len += n;
+    }
+    // One key record, then deltas with two changed bytes each
+    TEST_ASSERT_EQUAL_HEX8(Codec_t::KEY_SYNC, payload[0]);
+    TEST_ASSERT_EQUAL(3 + 12 + 3 * (3 + Codec_t::MASK_BYTES + 2), len);
+
+    size_t pos = 0;
+    for (int r = 0; r < 4; r++) {
+        uint8_t record[12];
+        uint16_t elapsed = 0;
+        size_t n = dec.Decode(&payload[pos], len - pos, record, elapsed);
+        TEST_ASSERT_TRUE(n > 0);
+        TEST_ASSERT_EQUAL_UINT16(r * 10, elapsed);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(records[r], record, 12);
+        pos += n;
+    }
+    TEST_ASSERT_EQUAL(len, pos);
+}
+
+void test_codec_rejects_bad_input()
+{
+    Codec_t enc, dec;
+    uint8_t record[12] = {0};
+    uint8_t out[Codec_t::MAX_ENCODED_SIZE];
+    uint16_t elapsed;
+
+    // Truncated key record
+    size_t n = enc.Encode(record, 0, true, out);
+    TEST_ASSERT_EQUAL(0, dec.Decode(out, n - 1, record, elapsed));
+
+    // A delta record with no key record before it
+    enc.Commit(record, out);
+    record[0] = 1;
+    n = enc.Encode(record, 1, true, out);
+    TEST_ASSERT_EQUAL_HEX8(Codec_t::DELTA_SYNC, out[0]);
+    TEST_ASSERT_EQUAL(0, dec.Decode(out, n, record, elapsed));
+
+    // Unknown sync byte
+    out[0] = 0x00;
+    TEST_ASSERT_EQUAL(0, dec.Decode(out, n, record, elapsed));
+}
+
+void test_codec_key_interval()
+{
+    Codec_t enc;
+    uint8_t record[12] = {0};
+    uint8_t out[Codec_t::MAX_ENCODED_SIZE];
+    for (uint16_t r = 0; r <= Codec_t::KEY_INTERVAL + 1; r++) {
+        record[0] = (uint8_t) r;
+        enc.Encode(record, r, true, out);
+        enc.Commit(record, out);
+        uint8_t expected = (r == 0 || r == Codec_t::KEY_INTERVAL + 1) ? Codec_t::KEY_SYNC : Codec_t::DELTA_SYNC;
+        TEST_ASSERT_EQUAL_HEX8(expected, out[0]);
+    }
+}
+
+void test_codec_fault_record()
+{
+    const uint16_t regs[Codec_t::FAULT_REGS] = {1, 0x0203, 0xFFFF, 0, 5, 6, 7, 0x8000};
+    uint8_t out[Codec_t::FAULT_RECORD_SIZE];
+    TEST_ASSERT_EQUAL(Codec_t::FAULT_RECORD_SIZE, Codec_t::EncodeFault(regs, 321, out));
+
+    uint16_t decoded[Codec_t::FAULT_REGS];
+    uint16_t elapsed = 0;
+    TEST_ASSERT_EQUAL(Codec_t::FAULT_RECORD_SIZE, Codec_t::DecodeFault(out, sizeof(out), decoded, elapsed));
+    TEST_ASSERT_EQUAL_UINT16(321, elapsed);
+    TEST_ASSERT_TRUE(memcmp(regs, decoded, sizeof(regs)) == 0);
+    TEST_ASSERT_EQUAL(0, Codec_t::DecodeFault(out, sizeof(out) - 1, decoded, elapsed));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_crc32_incremental);
+    RUN_TEST(test_codec_round_trip);
+    RUN_TEST(test_codec_rejects_bad_input);
+    RUN_TEST(test_codec_key_interval);
+    RUN_TEST(test_codec_fault_record);
+    return UNITY_END();
+}
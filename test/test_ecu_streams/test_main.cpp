@@ -0,0 +1,106 @@
+// ECUStreams, on the host: "pio test -e native"
+
+#include <string.h>
+#include <unity.h>
+#include "src/ECUStreams.h"
+
+static ECUStreams* streams;
+
+void setUp()
+{
+    streams = new ECUStreams();
+}
+
+void tearDown()
+{
+    delete streams;
+}
+
+// Receive a report from an ECU at now_ms; true if it is accumulated
+static bool Report(uint8_t ecu_id, uint32_t now_ms, uint16_t decimate_factor = 2)
+{
+    ECUStream_t& s = streams->Stream(ecu_id);
+    if (!streams->Receive(s, -90, 5.0f, decimate_factor, now_ms)) {
+        return false;
+    }
+    streams->Accumulated(s);
+    return true;
+}
+
+void test_decimates_each_ecu()
+{
+    // Interleaved, each ECU keeps every second of its own reports
+    TEST_ASSERT_FALSE(Report(1, 0));
+    TEST_ASSERT_FALSE(Report(2, 0));
+    TEST_ASSERT_TRUE(Report(1, 1000));
+    TEST_ASSERT_TRUE(Report(2, 1000));
+    TEST_ASSERT_EQUAL(2, streams->Active());
+}
+
+void test_full_table_accumulates_every_report()
+{
+    for (uint8_t id = 1; id <= MAX_ECU_STREAMS; id++) {
+        Report(id, 0);
+    }
+    TEST_ASSERT_TRUE(Report(10, 1000));
+    TEST_ASSERT_TRUE(Report(11, 1000));
+    TEST_ASSERT_TRUE(Report(10, 2000));
+    TEST_ASSERT_EQUAL(3, streams->Overflowed());
+    TEST_ASSERT_EQUAL(MAX_ECU_STREAMS + 1, streams->Active());
+
+    char buf[400];
+    streams->Format(buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "; others n:3/3 "));
+}
+
+void test_reset_evicts_longest_silent()
+{
+    for (uint8_t id = 1; id <= MAX_ECU_STREAMS; id++) {
+        Report(id, id * 1000);
+    }
+    Report(1, 9000);
+    Report(10, 9000);
+    streams->Reset();
+
+    // ECU 2, silent since 2 s, made room for ECU 10
+    TEST_ASSERT_FALSE(Report(10, 10000));
+    TEST_ASSERT_EQUAL(0, streams->Overflowed());
+    TEST_ASSERT_TRUE(Report(2, 10000));
+    TEST_ASSERT_EQUAL(1, streams->Overflowed());
+}
+
+void test_reset_keeps_table_without_overflow()
+{
+    for (uint8_t id = 1; id <= MAX_ECU_STREAMS; id++) {
+        Report(id, id * 1000);
+    }
+    streams->Reset();
+    for (uint8_t id = 1; id <= MAX_ECU_STREAMS; id++) {
+        Report(id, 10000);
+    }
+    TEST_ASSERT_EQUAL(0, streams->Overflowed());
+}
+
+void test_paired_stream_bypasses_table()
+{
+    for (uint8_t id = 1; id <= MAX_ECU_STREAMS; id++) {
+        Report(id, 0);
+    }
+    ECUStream_t& paired = streams->Paired(7);
+    TEST_ASSERT_FALSE(streams->Receive(paired, -90, 5.0f, 2, 1000));
+    TEST_ASSERT_TRUE(streams->Receive(paired, -90, 5.0f, 2, 2000));
+    TEST_ASSERT_EQUAL(0, streams->Overflowed());
+    TEST_ASSERT_EQUAL(7, paired.ecu_id);
+    TEST_ASSERT_EQUAL(2, paired.received);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decimates_each_ecu);
+    RUN_TEST(test_full_table_accumulates_every_report);
+    RUN_TEST(test_reset_evicts_longest_silent);
+    RUN_TEST(test_reset_keeps_table_without_overflow);
+    RUN_TEST(test_paired_stream_bypasses_table);
+    return UNITY_END();
+}
@@ -0,0 +1,63 @@
+// A simulated day of flight (sim/FlightSim.h): "pio test -e native"
+
+#include <unity.h>
+#include "sim/FlightSim.h"
+
+static SimResult_t result;
+
+void setUp() {}
+void tearDown() {}
+
+void test_flight_reaches_end_of_flight()
+{
+    TEST_ASSERT_EQUAL_STRING("mode:EOF:EF_LOOP", result.final_state.c_str());
+    TEST_ASSERT_EQUAL_UINT32(24 * 3600 * 1000, result.sim_ms);
+}
+
+void test_flight_warms_up_after_each_motion()
+{
+    // GPS wait, after each of the five reel commands, and after low power
+    TEST_ASSERT_EQUAL_UINT32(7, result.Entries("FL_WARMUP"));
+    TEST_ASSERT_EQUAL_UINT32(7, result.Entries("FL_MEASURE"));
+    TEST_ASSERT_EQUAL_UINT32(0, result.Entries("FL_ERROR"));
+    TEST_ASSERT_EQUAL_UINT32(0, result.ecu_reports_lost);
+}
+
+void test_flight_full_retracts_reach_zero()
+{
+    // The slow phase of a full retract follows the fast one by less than
+    // the fast phase's timeout, which must not cut it short
+    TEST_ASSERT_EQUAL_UINT32(0, result.Entries("SA_ERROR"));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, result.final_reel_revs);
+}
+
+void test_flight_reports()
+{
+    const SimTMStats_t& reports = result.tms["RATSREPORT"];
+    // About one every NUM_ECU_REPORTS ECU reports or RATS_REPORT_PERIOD_SECS
+    TEST_ASSERT_GREATER_THAN(100, reports.count);
+    TEST_ASSERT_LESS_OR_EQUAL(8192 * reports.count, reports.bytes);
+    TEST_ASSERT_GREATER_THAN(0, result.tms["MCBREPORT"].count);
+    TEST_ASSERT_EQUAL_UINT32(0, result.tc_naks);
+}
+
+void test_flight_safety_message_sent()
+{
+    TEST_ASSERT_EQUAL_UINT32(1, result.s_messages);
+    TEST_ASSERT_EQUAL_UINT32(1, result.Entries("SA_RETRACT"));
+}
+
+int main(int argc, char** argv)
+{
+    SimConfig_t cfg;
+    FlightSim sim(cfg);
+    result = sim.Run();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_flight_reaches_end_of_flight);
+    RUN_TEST(test_flight_warms_up_after_each_motion);
+    RUN_TEST(test_flight_full_retracts_reach_zero);
+    RUN_TEST(test_flight_reports);
+    RUN_TEST(test_flight_safety_message_sent);
+    return UNITY_END();
+}
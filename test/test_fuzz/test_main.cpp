@@ -0,0 +1,73 @@
+// The fuzz targets (test/fuzz) over their seed corpus: "pio test -e native"
+
+#include <dirent.h>
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "test/fuzz/FuzzTargets.h"
+
+// test/fuzz/corpus, found from this file
+static std::string CorpusDir(const char* target)
+{
+    std::string path = __FILE__;
+    path.erase(path.find_last_of('/') + 1);
+    return path + "../fuzz/corpus/" + target;
+}
+
+// Run the target on every seed, returning the number run
+static size_t RunCorpus(const char* target, int (*fuzz)(const uint8_t*, size_t))
+{
+    std::string dir = CorpusDir(target);
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return 0;
+    }
+    size_t seeds = 0;
+    while (struct dirent* e = readdir(d)) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        FILE* f = fopen((dir + "/" + e->d_name).c_str(), "rb");
+        if (!f) {
+            continue;
+        }
+        std::vector<uint8_t> data;
+        uint8_t buf[1024];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            data.insert(data.end(), buf, buf + n);
+        }
+        fclose(f);
+        TEST_ASSERT_EQUAL(0, fuzz(data.data(), data.size()));
+        seeds++;
+    }
+    closedir(d);
+    return seeds;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fuzz_lora_corpus() { TEST_ASSERT_GREATER_THAN(0, RunCorpus("lora", FuzzLoRa)); }
+void test_fuzz_mcb_corpus() { TEST_ASSERT_GREATER_THAN(0, RunCorpus("mcb", FuzzMCB)); }
+void test_fuzz_profile_corpus() { TEST_ASSERT_GREATER_THAN(0, RunCorpus("profile", FuzzReelProfile)); }
+void test_fuzz_codec_corpus() { TEST_ASSERT_GREATER_THAN(0, RunCorpus("codec", FuzzMotionCodec)); }
+
+void test_fuzz_empty_inputs()
+{
+    TEST_ASSERT_EQUAL(0, FuzzLoRa(nullptr, 0));
+    TEST_ASSERT_EQUAL(0, FuzzMCB(nullptr, 0));
+    TEST_ASSERT_EQUAL(0, FuzzReelProfile((const uint8_t*) "", 0));
+    TEST_ASSERT_EQUAL(0, FuzzMotionCodec(nullptr, 0));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fuzz_lora_corpus);
+    RUN_TEST(test_fuzz_mcb_corpus);
+    RUN_TEST(test_fuzz_profile_corpus);
+    RUN_TEST(test_fuzz_codec_corpus);
+    RUN_TEST(test_fuzz_empty_inputs);
+    return UNITY_END();
+}
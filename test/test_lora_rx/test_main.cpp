@@ -0,0 +1,79 @@
+// LoRaRX() length checks, on the host: "pio test -e native"
+
+#include <unity.h>
+#include "sim/FlightSim.h"
+
+static StratoRATS* rats;
+
+static ECUReportBytes_t DataReport()
+{
+    ECUReport_t r = {};
+    r.msg_type = ECU_REPORT_DATA;
+    r.id = 1;
+    r.gps_valid = r.rs41_valid = r.tsen_valid = true;
+    r.rs41_airt = -56.5f;
+    r.rs41_pres = 70.0f;
+    return ecu_report_serialize(r);
+}
+
+// Hand one packet to LoRaRX(), returning the number of rejections logged
+static size_t Receive(const uint8_t* data, size_t len)
+{
+    host::log_lines.clear();
+    host::QueueLoRa(data, len);
+    RunFirmwareLoop(*rats);
+    host::Advance(500);
+    TEST_ASSERT_TRUE(host::lora_rx.empty());
+    return host::CountLog("LoRa message rejected");
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_whole_data_report_accepted()
+{
+    ECUReportBytes_t r = DataReport();
+    TEST_ASSERT_EQUAL(0, Receive(r.data(), r.size()));
+    TEST_ASSERT_EQUAL(0, Receive(r.data(), ECU_DATA_REPORT_SIZE_BYTES));
+}
+
+void test_short_data_report_rejected()
+{
+    // Would otherwise be zero-filled into the RATS report
+    ECUReportBytes_t r = DataReport();
+    TEST_ASSERT_EQUAL(1, Receive(r.data(), ECU_DATA_REPORT_SIZE_BYTES - 1));
+    TEST_ASSERT_EQUAL(1, Receive(r.data(), 3));
+}
+
+void test_bad_lengths_rejected()
+{
+    uint8_t big[ECU_REPORT_SIZE_BYTES + 1] = {1, ECU_REPORT_DATA, 1};
+    TEST_ASSERT_EQUAL(1, Receive(big, sizeof(big)));
+    TEST_ASSERT_EQUAL(1, Receive(big, 0));
+}
+
+void test_short_rats_message_accepted()
+{
+    // Not an ECU report (first byte 0), so not held to the report length
+    uint8_t msg[3] = {0, 1, 2};
+    TEST_ASSERT_EQUAL(0, Receive(msg, sizeof(msg)));
+}
+
+int main(int argc, char** argv)
+{
+    host::Reset();
+    host::EraseEEPROM();
+    host::SetEpoch(1700000000);
+    rats = new StratoRATS();
+    rats->InitializeCore();
+    rats->InstrumentSetup();
+    host::QueueModeChange(MODE_FLIGHT);
+    RunFirmwareLoop(*rats);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_data_report_accepted);
+    RUN_TEST(test_short_data_report_rejected);
+    RUN_TEST(test_bad_lengths_rejected);
+    RUN_TEST(test_short_rats_message_accepted);
+    return UNITY_END();
+}
@@ -0,0 +1,86 @@
+// Reel profiles run by TC, and their profile products (sim/FlightSim.h):
+// "pio test -e native"
+
+#include <unity.h>
+#include "sim/FlightSim.h"
+
+static const char* PROFILE =
+    "OUT 20 600\n"
+    "IN  20 600\n";
+
+static const char* SCENARIO =
+    "0:01:00   MODE FL\n"
+    "0:10:00   TC DEPLOYx 20\n"
+    "0:20:00   TC CONFIGSET 21 1\n"
+    "0:21:00   TC DEPLOYx 20\n"
+    "0:30:00   TC PROFILELOAD\n"
+    "0:31:00   TC PROFILESTART\n"
+    "2:00:00   TC PROFILESTART\n"
+    "2:01:00   TC PROFILEABORT\n"
+    "3:00:00   TC PROFILEABORT\n"
+    "4:00:00   END\n";
+
+static SimResult_t result;
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t TimelineCount(const char* text)
+{
+    uint32_t n = 0;
+    for (const SimEvent_t& e : result.timeline) {
+        if (e.text.find(text) != std::string::npos) {
+            n++;
+        }
+    }
+    return n;
+}
+
+void test_profile_needs_ecu_on_during_motions()
+{
+    // The first reel out, with the ECU powered off, has nothing to bin. The
+    // second, and the profile's motions, run with the ECU on.
+    const SimTMStats_t& profiles = result.tms["RATSPROFILE"];
+    TEST_ASSERT_EQUAL_UINT32(4, profiles.count);
+    // Every product has bins after its 24 byte header
+    TEST_ASSERT_GREATER_THAN(4 * 24, profiles.bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, TimelineCount("TM RATSPROFILE 24B"));
+    // Only power-on, and the motion with the ECU off, needed a warmup
+    TEST_ASSERT_EQUAL_UINT32(2, result.Entries("FL_WARMUP"));
+}
+
+void test_profile_tcs_accepted()
+{
+    TEST_ASSERT_EQUAL_UINT32(8, TimelineCount("TM RATSTCACK"));
+    // Only the second abort, with no profile running, is refused
+    TEST_ASSERT_EQUAL_UINT32(1, TimelineCount("ERR: TC Abort reel profile"));
+    TEST_ASSERT_EQUAL_UINT32(0, TimelineCount("ERR: TC Load reel profile"));
+    TEST_ASSERT_EQUAL_UINT32(0, TimelineCount("ERR: TC Start reel profile"));
+}
+
+void test_profile_runs_and_aborts()
+{
+    // The whole profile, then only the first step of the aborted one
+    TEST_ASSERT_EQUAL_UINT32(2, result.Entries("FL_PROFILE"));
+    TEST_ASSERT_EQUAL_UINT32(5, TimelineCount("TM MCBREPORT"));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, -60.0f, result.final_reel_revs);
+}
+
+int main(int argc, char** argv)
+{
+    SimConfig_t cfg;
+    cfg.profile = PROFILE;
+    FlightSim sim(cfg);
+    char err[100];
+    if (!sim.LoadScenario(SCENARIO, err, sizeof(err))) {
+        printf("%s\n", err);
+        return 1;
+    }
+    result = sim.Run();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_needs_ecu_on_during_motions);
+    RUN_TEST(test_profile_tcs_accepted);
+    RUN_TEST(test_profile_runs_and_aborts);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+// The RATSREPORT header against the frozen revision 5 and 6 vectors:
+// "pio test -e native"
+
+#include <unity.h>
+#include "src/RATSReport.h"
+
+// The reference header of docs/TM_specs.md, 175 records
+class ReferenceReport : public RATSReport<175>
+{
+public:
+    using RATSReport<175>::scaledField;
+
+    // v56 is passed already scaled, as its scaling depends on the revision
+    const uint8_t* Serialize(uint8_t version, uint8_t header_size_bytes, uint16_t v56)
+    {
+        _header.version = version;
+        _header.header_size_bytes = header_size_bytes;
+        _header.rats_id = 0x1234;
+        _header.epoch = 1700000000;
+        _header.paired_ecu = 7;
+        _header.num_ecu_records = 175;
+        _header.ecu_pwr_on = 1;
+        _header.v56 = v56;
+        _header.cpu_temp = scaledField((45.0 + 100.0) * 10, 11);
+        _header.lora_rssi = scaledField((-80.0 + 100.0) * 10, 10);
+        _header.lora_snr = scaledField((9.5 + 70) * 10, 10);
+        _header.inst_imon = scaledField(120.5 * 10, 11);
+        _header.gps_lat = (int32_t)(-45.123456 * 1e6);
+        _header.gps_lon = (int32_t)(-170.5 * 1e6);
+        _header.gps_alt = scaledField(20000, 16);
+        _header.reel_revs = scaledField((1538.3 + 100.0) * 10, 14);
+        _header.recovered = 1;
+        _header.collect_epoch = 1699999400;
+        _header.time_col_bytes = 262;
+        serializeHeader();
+        return _report_bytes.data();
+    }
+};
+
+static const uint8_t REV5[30] = {
+    0x51, 0x23, 0x46, 0x55, 0x3F, 0x10, 0x00, 0x71, 0xE2, 0xBC, 0x49, 0xD6, 0x05, 0xAA, 0x32,
+    0x31, 0xB9, 0x6B, 0xFA, 0x9E, 0xF1, 0x01, 0xEB, 0xAC, 0xC0, 0xC0, 0x9C, 0x41, 0xFF, 0xFC,
+};
+
+static const uint8_t REV6[36] = {
+    0x61, 0x23, 0x46, 0x55, 0x3F, 0x10, 0x00, 0x72, 0x42, 0xBC, 0x49, 0xAF, 0x05, 0xAA, 0x32,
+    0x31, 0xB9, 0x6B, 0xFA, 0x9E, 0xF1, 0x01, 0xEB, 0xAC, 0xC0, 0xC0, 0x9C, 0x41, 0xFF, 0xFD,
+    0x95, 0x4F, 0xBA, 0xA0, 0x83, 0x00,
+};
+
+static ReferenceReport report;
+
+void setUp() {}
+void tearDown() {}
+
+void test_header_size()
+{
+    TEST_ASSERT_EQUAL(281, RATS_REPORT_HEADER_SIZE_BITS);
+    TEST_ASSERT_EQUAL(sizeof(REV6), RATS_REPORT_HEADER_SIZE_BYTES);
+    TEST_ASSERT_EQUAL(6, RATS_REPORT_REV);
+}
+
+void test_rev6_vector()
+{
+    const uint8_t* bytes = report.Serialize(RATS_REPORT_REV, RATS_REPORT_HEADER_SIZE_BYTES,
+                                            ReferenceReport::scaledField(56.00 * 100, 13));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(REV6, bytes, sizeof(REV6));
+}
+
+void test_rev5_vector()
+{
+    // Revision 6 changed v56 from V * 1000, which wraps the 13-bit field, to
+    // V * 100, and appended fields: with the revision 5 version, header size
+    // and v56, the first 238 bits are the revision 5 header
+    const uint8_t* bytes = report.Serialize(5, sizeof(REV5), 56000 % 8192);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(REV5, bytes, 29);
+    TEST_ASSERT_EQUAL_HEX8(REV5[29] & 0xFC, bytes[29] & 0xFC);
+}
+
+void test_scaled_fields_saturate()
+{
+    TEST_ASSERT_EQUAL(0, ReferenceReport::scaledField(-5.0, 13));
+    TEST_ASSERT_EQUAL(0, ReferenceReport::scaledField(NAN, 13));
+    TEST_ASSERT_EQUAL(8191, ReferenceReport::scaledField(56.0 * 1000, 13));
+    TEST_ASSERT_EQUAL(5600, ReferenceReport::scaledField(56.0 * 100, 13));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_header_size);
+    RUN_TEST(test_rev6_vector);
+    RUN_TEST(test_rev5_vector);
+    RUN_TEST(test_scaled_fields_saturate);
+    return UNITY_END();
+}
@@ -0,0 +1,94 @@
+// ReelEstimator, on the host: "pio test -e native"
+
+#include <unity.h>
+#include "src/ReelEstimator.h"
+
+static ReelEstimator est;
+
+void setUp()
+{
+    est.Reset(-10.0f, 1000, ReelEstimator::CONFIDENCE_MEASURED);
+}
+
+void tearDown() {}
+
+void test_stopped_holds_position()
+{
+    TEST_ASSERT_FALSE(est.Moving());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, -10.0f, est.Position(60000));
+    TEST_ASSERT_EQUAL_UINT8(ReelEstimator::CONFIDENCE_MEASURED, est.Confidence(60000));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0f, est.Velocity());
+}
+
+void test_extrapolates_commanded_velocity()
+{
+    // Deploy 5 revs at 0.5 revs/s
+    est.StartMotion(-15.0f, -0.5f, 1000);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -11.0f, est.Position(3000));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, -0.5f, est.Velocity());
+    TEST_ASSERT_FALSE(est.MeasuredVelocityValid());
+}
+
+void test_stops_at_target()
+{
+    est.StartMotion(-11.0f, -0.5f, 1000);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -11.0f, est.Position(9000));
+}
+
+void test_measured_velocity_replaces_commanded()
+{
+    est.StartMotion(-20.0f, -0.5f, 1000);
+    est.AddSample(-10.25f, 2000);
+    est.AddSample(-10.5f, 3000);
+    TEST_ASSERT_TRUE(est.MeasuredVelocityValid());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -0.25f, est.Velocity());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -10.75f, est.Position(4000));
+}
+
+void test_confidence_decays_while_extrapolating()
+{
+    est.StartMotion(-20.0f, -0.5f, 1000);
+    TEST_ASSERT_EQUAL_UINT8(100, est.Confidence(1000));
+    TEST_ASSERT_EQUAL_UINT8(50, est.Confidence(1000 + ReelEstimator::MAX_EXTRAPOLATION_MS / 2));
+    TEST_ASSERT_EQUAL_UINT8(0, est.Confidence(1000 + ReelEstimator::MAX_EXTRAPOLATION_MS));
+
+    // Extrapolation stops growing after MAX_EXTRAPOLATION_MS
+    float limit = est.Position(1000 + ReelEstimator::MAX_EXTRAPOLATION_MS);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, limit, est.Position(1000 + 3 * ReelEstimator::MAX_EXTRAPOLATION_MS));
+
+    // A sample restores it
+    est.AddSample(-12.0f, 30000);
+    TEST_ASSERT_EQUAL_UINT8(100, est.Confidence(30000));
+}
+
+void test_stop_holds_estimate()
+{
+    est.StartMotion(-20.0f, -0.5f, 1000);
+    est.StopMotion(3000);
+    TEST_ASSERT_FALSE(est.Moving());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -11.0f, est.Position(60000));
+    TEST_ASSERT_EQUAL_UINT8(80, est.Confidence(60000));
+}
+
+void test_restored_position_has_no_measured_velocity()
+{
+    est.Reset(-10.0f, 0, ReelEstimator::CONFIDENCE_RESTORED);
+    est.StartMotion(-20.0f, -0.5f, 0);
+    est.AddSample(-10.5f, 1000);
+    // The first pair of samples starts from a restored position, so no velocity is measured
+    TEST_ASSERT_FALSE(est.MeasuredVelocityValid());
+    TEST_ASSERT_EQUAL_UINT8(ReelEstimator::CONFIDENCE_MEASURED, est.Confidence(1000));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stopped_holds_position);
+    RUN_TEST(test_extrapolates_commanded_velocity);
+    RUN_TEST(test_stops_at_target);
+    RUN_TEST(test_measured_velocity_replaces_commanded);
+    RUN_TEST(test_confidence_decays_while_extrapolating);
+    RUN_TEST(test_stop_holds_estimate);
+    RUN_TEST(test_restored_position_has_no_measured_velocity);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// Recording and replay (sim/Recording.h): "pio test -e native"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+#include "sim/FlightSim.h"
+
+// Exercises every link: TCs with parameters, MCB acks, records, voltages and
+// a fault, ECU reports, the console, and NAKed TMs
+static const char* SCENARIO =
+    "0:01:00   MODE FL\n"
+    "0:20:00   TC GETMCBVOLTS\n"
+    "0:25:00   TC CONFIGSET 16 20\n"
+    "0:26:00   TC CONFIGGET 16\n"
+    "0:30:00   TC DEPLOYx 20\n"
+    "1:00:00   CONSOLE help\n"
+    "1:30:00   MCBFAULT\n"
+    "1:30:00   TC RETRACTx 20\n"
+    "2:00:00   TC ZEROREEL\n"
+    "2:30:00   MODE SA\n"
+    "3:00:00   END\n";
+
+static std::string recording;
+static ReplayResult_t result;
+static int changed_status = -1;
+
+void setUp() {}
+void tearDown() {}
+
+// Each flight or replay in its own process, as the firmware keeps state in
+// statics. Returns the child's exit status.
+template <class F> static int InChild(F f)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(f());
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static bool ReadFile(const char* path, std::string& text)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool Recorded(const char* text)
+{
+    return recording.find(text) != std::string::npos;
+}
+
+void test_recording_has_every_link()
+{
+    TEST_ASSERT_TRUE(Recorded(" TC DEPLOYx 20\n"));
+    TEST_ASSERT_TRUE(Recorded(" TC CONFIGSET 16 20\n"));
+    TEST_ASSERT_TRUE(Recorded(" TC CONFIGGET 16\n"));
+    TEST_ASSERT_TRUE(Recorded(" MCB BIN "));
+    TEST_ASSERT_TRUE(Recorded(" MCB ASCII 21 15.1"));     // MCB_VOLTAGES
+    TEST_ASSERT_TRUE(Recorded(" MCB ASCII 20 1 0 0 4"));  // MCB_MOTION_FAULT
+    TEST_ASSERT_TRUE(Recorded(" LORA "));
+    TEST_ASSERT_TRUE(Recorded(" CONSOLE 68656C70\n"));
+    TEST_ASSERT_TRUE(Recorded(" TMACK NAK\n"));
+    TEST_ASSERT_TRUE(Recorded(" > TM "));
+}
+
+void test_replay_sends_the_recorded_tms()
+{
+    for (const std::string& d : result.diffs) {
+        printf("%s\n", d.c_str());
+    }
+    TEST_ASSERT_GREATER_THAN(1000, result.inputs);
+    TEST_ASSERT_GREATER_THAN(10, result.expected);
+    TEST_ASSERT_EQUAL_UINT32(result.expected, result.outputs);
+    TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+    TEST_ASSERT_TRUE(result.Matched());
+}
+
+void test_replay_catches_a_changed_input()
+{
+    // A byte of one ECU report changes the next RATSREPORT
+    TEST_ASSERT_EQUAL(1, changed_status);
+}
+
+void test_replay_rejects_bad_recordings()
+{
+    ReplayConfig_t cfg;
+    FlightReplay replay(cfg);
+    char err[96];
+    TEST_ASSERT_TRUE(replay.Load("EPOCH 1700000000\n10 IM FL\n20 > IMR\n", err, sizeof(err)));
+    TEST_ASSERT_FALSE(replay.Load("10 IM XX\n", err, sizeof(err)));
+    TEST_ASSERT_FALSE(replay.Load("10 LORA 1 1 -90 8 ABC\n", err, sizeof(err)));
+    TEST_ASSERT_FALSE(replay.Load("20 SW\n10 SW\n", err, sizeof(err)));
+    TEST_ASSERT_EQUAL_STRING("line 2: expected \"<ms> <input>\" or \"<ms> > <output>\" in time order", err);
+}
+
+int main(int argc, char** argv)
+{
+    char path[] = "/tmp/rats_replay_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    InChild([&path]() {
+        SimConfig_t cfg;
+        cfg.tm_nak_rate = 0.1f;
+        cfg.record = fopen(path, "w");
+        FlightSim sim(cfg);
+        sim.LoadScenario(SCENARIO, nullptr, 0);
+        sim.Run();
+        fclose(cfg.record);
+        return 0;
+    });
+    ReadFile(path, recording);
+    unlink(path);
+
+    // A byte of the data in the 50th LoRa packet
+    std::string changed = recording;
+    size_t at = 0;
+    for (int i = 0; i < 50 && at != std::string::npos; i++) {
+        at = changed.find(" LORA ", at + 1);
+    }
+    if (at != std::string::npos) {
+        size_t hex = changed.find_last_of(' ', changed.find('\n', at)) + 1;
+        changed[hex + 20] = (changed[hex + 20] == '0') ? '1' : '0';
+    }
+    changed_status = InChild([&changed]() {
+        ReplayConfig_t cfg;
+        FlightReplay replay(cfg);
+        return (replay.Load(changed.c_str(), nullptr, 0) && replay.Run().Matched()) ? 0 : 1;
+    });
+
+    ReplayConfig_t cfg;
+    FlightReplay replay(cfg);
+    if (replay.Load(recording.c_str(), nullptr, 0)) {
+        result = replay.Run();
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_recording_has_every_link);
+    RUN_TEST(test_replay_sends_the_recorded_tms);
+    RUN_TEST(test_replay_catches_a_changed_input);
+    RUN_TEST(test_replay_rejects_bad_recordings);
+    return UNITY_END();
+}
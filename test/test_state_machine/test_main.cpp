@@ -0,0 +1,170 @@
+// StateMachine, on the host: "pio test -e native"
+
+#include <unity.h>
+#include <string>
+#include "src/StateMachine.h"
+
+// IDLE, and ACTIVE with the children A (initial) and B
+class Machine
+{
+public:
+    enum State_t : uint8_t { IDLE, ACTIVE, A, B, N_STATES };
+    enum Transition_t : uint8_t { GO, NEXT, REPEAT, RESTART, STOP, N_TRANSITIONS };
+
+    typedef StateMachine<Machine, N_STATES, N_TRANSITIONS> SM_t;
+    static const SM_t::State_t states[N_STATES];
+    static const SM_t::Transition_t transitions[N_TRANSITIONS];
+
+    Machine() : sm(this, states, transitions) {}
+
+    SM_t sm;
+    bool go = false, next = false, repeat = false, restart = false, stop = false;
+    std::string trace;
+
+    void EnterIdle() { trace += "+IDLE "; }
+    void EnterActive() { trace += "+ACTIVE "; }
+    void RunActive() { trace += "ACTIVE "; }
+    void ExitActive() { trace += "-ACTIVE "; }
+    void EnterA() { trace += "+A "; }
+    void RunA() { trace += "A "; }
+    void ExitA() { trace += "-A "; }
+    void EnterB() { trace += "+B "; }
+    void ExitB() { trace += "-B "; }
+    void OnStop() { trace += "stop "; }
+
+    bool Go() { return go; }
+    bool Next() { return next; }
+    bool Repeat() { return repeat; }
+    bool Restart() { return restart; }
+    bool Stop() { return stop; }
+};
+
+const Machine::SM_t::State_t Machine::states[N_STATES] = {
+    {"IDLE",   SM_NONE, SM_NONE, &Machine::EnterIdle,   nullptr,             nullptr},
+    {"ACTIVE", SM_NONE, A,       &Machine::EnterActive, &Machine::RunActive, &Machine::ExitActive},
+    {"A",      ACTIVE,  SM_NONE, &Machine::EnterA,      &Machine::RunA,      &Machine::ExitA},
+    {"B",      ACTIVE,  SM_NONE, &Machine::EnterB,      nullptr,             &Machine::ExitB},
+};
+
+const Machine::SM_t::Transition_t Machine::transitions[N_TRANSITIONS] = {
+    {IDLE,   ACTIVE, &Machine::Go,      nullptr},
+    {A,      B,      &Machine::Next,    nullptr},
+    {B,      B,      &Machine::Repeat,  nullptr},
+    {B,      ACTIVE, &Machine::Restart, nullptr},
+    {ACTIVE, IDLE,   &Machine::Stop,    &Machine::OnStop},
+};
+
+static Machine* m;
+
+void setUp()
+{
+    m = new Machine();
+    m->sm.Start(Machine::IDLE, 0);
+}
+
+void tearDown()
+{
+    delete m;
+}
+
+void test_start_enters_initial_state()
+{
+    TEST_ASSERT_EQUAL(Machine::IDLE, m->sm.Current());
+    TEST_ASSERT_EQUAL_STRING("+IDLE ", m->trace.c_str());
+    TEST_ASSERT_FALSE(m->sm.Step(100));
+}
+
+void test_composite_enters_initial_child()
+{
+    m->go = true;
+    m->trace = "";
+    TEST_ASSERT_TRUE(m->sm.Step(100));
+    TEST_ASSERT_EQUAL(Machine::A, m->sm.Current());
+    TEST_ASSERT_TRUE(m->sm.InState(Machine::ACTIVE));
+    TEST_ASSERT_EQUAL_STRING("+ACTIVE +A ", m->trace.c_str());
+
+    // Run actions, outermost first
+    m->trace = "";
+    TEST_ASSERT_FALSE(m->sm.Step(200));
+    TEST_ASSERT_EQUAL_STRING("ACTIVE A ", m->trace.c_str());
+}
+
+void test_sibling_transition_keeps_parent()
+{
+    m->go = true;
+    m->sm.Step(100);
+    m->next = true;
+    m->trace = "";
+    TEST_ASSERT_TRUE(m->sm.Step(200));
+    TEST_ASSERT_EQUAL(Machine::B, m->sm.Current());
+    TEST_ASSERT_EQUAL_STRING("ACTIVE A -A +B ", m->trace.c_str());
+}
+
+void test_self_transition_reenters()
+{
+    m->go = m->next = true;
+    m->sm.Step(100);
+    m->sm.Step(200);
+    m->repeat = true;
+    m->trace = "";
+    TEST_ASSERT_TRUE(m->sm.Step(300));
+    TEST_ASSERT_EQUAL_STRING("ACTIVE -B +B ", m->trace.c_str());
+    TEST_ASSERT_EQUAL(2, m->sm.Entries(Machine::B));
+}
+
+void test_ancestor_transition_exits_leaf()
+{
+    m->go = true;
+    m->sm.Step(100);
+    m->go = false;
+    m->stop = true;
+    m->trace = "";
+    TEST_ASSERT_TRUE(m->sm.Step(200));
+    TEST_ASSERT_EQUAL(Machine::IDLE, m->sm.Current());
+    TEST_ASSERT_EQUAL_STRING("ACTIVE A -A -ACTIVE stop +IDLE ", m->trace.c_str());
+}
+
+void test_transition_to_ancestor_reenters_it()
+{
+    m->go = m->next = true;
+    m->sm.Step(100);
+    m->sm.Step(200);
+    m->restart = true;
+    m->trace = "";
+    TEST_ASSERT_TRUE(m->sm.Step(300));
+    TEST_ASSERT_EQUAL(Machine::A, m->sm.Current());
+    TEST_ASSERT_EQUAL_STRING("ACTIVE -B -ACTIVE +ACTIVE +A ", m->trace.c_str());
+    TEST_ASSERT_EQUAL(2, m->sm.Entries(Machine::ACTIVE));
+}
+
+void test_statistics()
+{
+    m->go = true;
+    m->sm.Step(1000);
+    m->go = false;
+    m->stop = true;
+    m->sm.Step(3500);
+
+    TEST_ASSERT_EQUAL(2, m->sm.Entries(Machine::IDLE));
+    TEST_ASSERT_EQUAL(1, m->sm.Taken(Machine::GO));
+    TEST_ASSERT_EQUAL(1, m->sm.Taken(Machine::STOP));
+    TEST_ASSERT_EQUAL_UINT32(2500, m->sm.TimeIn(Machine::ACTIVE, 3500));
+    TEST_ASSERT_EQUAL_UINT32(1500, m->sm.TimeIn(Machine::IDLE, 4000));
+
+    char buf[80];
+    m->sm.FormatStats(buf, sizeof(buf), 4000);
+    TEST_ASSERT_EQUAL_STRING("IDLE 1.5s/2 ACTIVE 2.5s/1 A 2.5s/1", buf);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_start_enters_initial_state);
+    RUN_TEST(test_composite_enters_initial_child);
+    RUN_TEST(test_sibling_transition_keeps_parent);
+    RUN_TEST(test_self_transition_reenters);
+    RUN_TEST(test_ancestor_transition_exits_leaf);
+    RUN_TEST(test_transition_to_ancestor_reenters_it);
+    RUN_TEST(test_statistics);
+    return UNITY_END();
+}